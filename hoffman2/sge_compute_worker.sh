@@ -8,10 +8,12 @@
 # Workflow:
 #   1. Read ticker name from current_batch.txt
 #   2. Find all staged .7z files for this ticker
-#   3. Extract message CSVs into a temp folder (structured for the parser)
-#   4. Run the C++ data_processor (single-threaded, kappa=0)
-#   5. Run compute_permanence.py to add overnight targets
-#   6. rm -rf all extracted CSVs immediately
+#   3. Stream message CSVs out of the archives (`7z x -so`); with py7zr
+#      or STREAM_EXTRACT=0, extract them into a temp folder instead
+#   4. Run the C++ data_processor (single-threaded, kappa=0) on the
+#      stream / folder
+#   5. rm -rf all extracted CSVs immediately (if any)
+#   6. Run compute_permanence.py to add overnight targets
 #   7. Exit with status code
 #
 # SGE directives (set by master_orchestrator.sh via qsub flags):
@@ -140,20 +142,87 @@ extract_one() {
     esac
 }
 
-# Extract every archive for this ticker (process substitution → main shell).
-while IFS= read -r ARCHIVE_PATH; do
-    if ! extract_one "${ARCHIVE_PATH}" "${EXTRACT_DIR}"; then
-        echo "[${TICKER}] WARNING: Failed to extract ${ARCHIVE_PATH}"
-        EXTRACT_ERRORS=$((EXTRACT_ERRORS + 1))
+mapfile -t ARCHIVES < <(find "${STAGING_DIR}" -name "${TICKER}.7z" 2>/dev/null | sort)
+ARCHIVE_COUNT=${#ARCHIVES[@]}
+
+# Streaming mode: `7z x -so` pipes every message CSV into data_processor.
+# Each entry is preceded by a framing line "# <entry path>", from which
+# the binary takes the day's date, so a missing or empty entry cannot
+# shift the dates of the days after it.
+STREAM_EXTRACT="${STREAM_EXTRACT:-1}"
+if [ "${EXTRACTOR}" = "py7zr" ]; then
+    STREAM_EXTRACT=0
+fi
+
+# Entries of archive $1 as "<path><TAB><size>" lines, in archive order.
+list_messages() {
+    "${EXTRACTOR}" l -ba -slt "$1" -r '*message*.csv' \
+        | awk '/^Path = /{ p = substr($0, 8) } /^Size = /{ print p "\t" substr($0, 8) }'
+}
+
+# 7z writes the entries in listing order, so one `x -so` per archive is
+# cut at the listed sizes (extracting entry by entry would re-decompress
+# a solid archive from the start every time).  Returns 1 if 7z fails or
+# its output is longer or shorter than the listing says.
+stream_archive() {
+    # $1 = archive path, $2 = its listing
+    local path size got
+    "${EXTRACTOR}" x -so "$1" -r '*message*.csv' 2>"${WORK_DIR}/7z_stderr.txt" | {
+        while IFS=$'\t' read -r path size <&4; do
+            printf '\n# %s\n' "${path}"
+            got=$(head -c "${size}" | tee /dev/fd/3 | wc -c)
+            if [ "${got}" -ne "${size}" ]; then
+                echo "[${TICKER}] ERROR: ${1}: ${path} gave ${got} of ${size} bytes" >&2
+                exit 1
+            fi
+        done 4< "$2"
+        if [ "$(head -c 1 | wc -c)" -ne 0 ]; then
+            echo "[${TICKER}] ERROR: ${1}: more data than its listing" >&2
+            exit 1
+        fi
+    } 3>&1
+    local status=("${PIPESTATUS[@]}")
+    # 141 = SIGPIPE: 7z outlived a reader that had already given up.
+    if [ "${status[0]}" -ne 0 ] && [ "${status[0]}" -ne 141 ]; then
+        echo "[${TICKER}] ERROR: ${EXTRACTOR} failed on ${1} (exit ${status[0]})" >&2
+        cat "${WORK_DIR}/7z_stderr.txt" >&2
+        return 1
     fi
-    ARCHIVE_COUNT=$((ARCHIVE_COUNT + 1))
-done < <(find "${STAGING_DIR}" -name "${TICKER}.7z" 2>/dev/null | sort)
+    return "${status[1]}"
+}
 
-echo "[${TICKER}] Processed ${ARCHIVE_COUNT} archive(s), ${EXTRACT_ERRORS} extraction error(s)"
+stream_messages() {
+    local k
+    for k in "${!ARCHIVES[@]}"; do
+        stream_archive "${ARCHIVES[$k]}" "${WORK_DIR}/listing_${k}.tsv" || return 1
+    done
+}
 
-# Count extracted message files
-MSG_FILE_COUNT=$(find "${EXTRACT_DIR}" -name "*message*" -name "*.csv" 2>/dev/null | wc -l)
-echo "[${TICKER}] Extracted ${MSG_FILE_COUNT} message files from archives"
+if [ "${STREAM_EXTRACT}" = "1" ]; then
+    MSG_FILE_COUNT=0
+    for k in "${!ARCHIVES[@]}"; do
+        if ! list_messages "${ARCHIVES[$k]}" > "${WORK_DIR}/listing_${k}.tsv"; then
+            echo "[${TICKER}] ERROR: Failed to list ${ARCHIVES[$k]}"
+            exit 1
+        fi
+        MSG_FILE_COUNT=$((MSG_FILE_COUNT + $(wc -l < "${WORK_DIR}/listing_${k}.tsv")))
+    done
+    echo "[${TICKER}] Streaming ${MSG_FILE_COUNT} message files from ${ARCHIVE_COUNT} archive(s)"
+else
+    # Extract every archive for this ticker (runs in the main shell).
+    for ARCHIVE_PATH in "${ARCHIVES[@]}"; do
+        if ! extract_one "${ARCHIVE_PATH}" "${EXTRACT_DIR}"; then
+            echo "[${TICKER}] WARNING: Failed to extract ${ARCHIVE_PATH}"
+            EXTRACT_ERRORS=$((EXTRACT_ERRORS + 1))
+        fi
+    done
+
+    echo "[${TICKER}] Processed ${ARCHIVE_COUNT} archive(s), ${EXTRACT_ERRORS} extraction error(s)"
+
+    # Count extracted message files
+    MSG_FILE_COUNT=$(find "${EXTRACT_DIR}" -name "*message*" -name "*.csv" 2>/dev/null | wc -l)
+    echo "[${TICKER}] Extracted ${MSG_FILE_COUNT} message files from archives"
+fi
 
 if [ "${MSG_FILE_COUNT}" -eq 0 ]; then
     echo "[${TICKER}] ERROR: No message files found after extraction!"
@@ -166,14 +235,30 @@ fi
 # ── Step 2: Run C++ data_processor ───────────────────────────────────────
 echo ""
 echo "[${TICKER}] ── Running C++ burst detector ──"
-echo "[${TICKER}] Input:  ${EXTRACT_DIR} (${MSG_FILE_COUNT} day files)"
+if [ "${STREAM_EXTRACT}" = "1" ]; then
+    echo "[${TICKER}] Input:  ${EXTRACTOR} stream (${MSG_FILE_COUNT} day files)"
+    INPUT="-"
+    INPUT_ARGS=(-N "${TICKER}")
+else
+    echo "[${TICKER}] Input:  ${EXTRACT_DIR} (${MSG_FILE_COUNT} day files)"
+    INPUT="${EXTRACT_DIR}"
+    INPUT_ARGS=()
+fi
 echo "[${TICKER}] Output: ${OUTPUT_CSV}"
 
+run_data_processor() {
+    "${PROJECT_DIR}/data_processor" "${INPUT}" "${OUTPUT_CSV}" "${INPUT_ARGS[@]}" "$@"
+}
+if [ "${STREAM_EXTRACT}" != "1" ]; then
+    stream_messages() { :; }
+fi
+
 # Parser parameters from batch_env.sh (with fallback defaults)
 PARSE_START=$(date +%s)
-"${PROJECT_DIR}/data_processor" \
-    "${EXTRACT_DIR}" \
-    "${OUTPUT_CSV}" \
+# Both exit codes matter: a failed extraction leaves days missing or cut
+# short even when data_processor itself succeeds.
+set +e
+stream_messages | run_data_processor \
     -H "${HAWKES_BETA:-1.0}" \
     -I "${TRIGGER_INTENSITY:-0.5}" \
     -w "${CANCEL_WINDOW:-0.050}" \
@@ -185,14 +270,22 @@ PARSE_START=$(date +%s)
     -j 1 \
     -b 34200 \
     -e 57600
-
-PARSE_EXIT=$?
+PIPE_STATUS=("${PIPESTATUS[@]}")
+set -e
+STREAM_EXIT=${PIPE_STATUS[0]}
+PARSE_EXIT=${PIPE_STATUS[1]}
 PARSE_ELAPSED=$(( $(date +%s) - PARSE_START ))
 
 if [ ${PARSE_EXIT} -ne 0 ]; then
     echo "[${TICKER}] ERROR: data_processor exited with code ${PARSE_EXIT}"
+    rm -f "${OUTPUT_CSV}" "${OUTPUT_CSV%.csv}_adv.csv"
     exit ${PARSE_EXIT}
 fi
+if [ ${STREAM_EXIT} -ne 0 ]; then
+    echo "[${TICKER}] ERROR: extracting the message files failed; discarding ${OUTPUT_CSV}"
+    rm -f "${OUTPUT_CSV}" "${OUTPUT_CSV%.csv}_adv.csv"
+    exit 1
+fi
 
 if [ ! -s "${OUTPUT_CSV}" ]; then
     echo "[${TICKER}] ERROR: Output CSV is empty after data_processor"
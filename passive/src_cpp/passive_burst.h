@@ -2,6 +2,7 @@
 #define PASSIVE_BURST_H
 
 #include "../../src_cpp/types.h"
+#include "../../src_cpp/burst_engine.h"
 #include <cmath>
 #include <algorithm>
 #include <vector>
@@ -32,6 +33,9 @@ struct PassiveBurst {
     // ── Passive-Specific Features ──────────────────────────────
     double submission_size_variance; // Variance of individual submission sizes
     double round_lot_pct;            // Fraction of submissions that are 100-share multiples
+    double submission_size_skew;     // Skewness (g1) of the submission sizes
+    double submission_size_entropy;  // Entropy (bits) of the sizes over power-of-two buckets
+    double inter_submission_cv;      // CV of the gaps between submissions
     double hawkes_peak_intensity;    // Maximum Hawkes intensity during burst
 
     // ── Cancellation Features (NOT triggers, just features) ────
@@ -42,9 +46,18 @@ struct PassiveBurst {
     int bid_cancel_volume;        // Bid-side cancelled volume
     int ask_cancel_volume;        // Ask-side cancelled volume
     double cancel_ratio;          // cancel_count / (submission_count + cancel_count)
-    double preburst_cancel_rate;  // Cancellation rate in pre-burst window
+    double preburst_cancel_rate;  // Cancellation rate in pre-burst window (set by passive_main.cpp)
 };
 
+// ─────────────────────────────────────────────────────────────
+// PassiveBurstDetector: one BurstEngine configuration
+// ─────────────────────────────────────────────────────────────
+//
+// Submissions near the BBO excite; the features are bid/ask flow,
+// submission sizes and gaps, and the cancels near the BBO during the
+// burst.
+// ─────────────────────────────────────────────────────────────
+
 class PassiveBurstDetector {
 public:
     PassiveBurstDetector(double silence_threshold, double min_volume_threshold,
@@ -58,56 +71,26 @@ public:
     bool process(const LobsterMessage& msg, double current_mid,
                  int best_bid, int best_ask, PassiveBurst& result);
 
-    void set_preburst_cancel_rate(double rate);
     bool flush(PassiveBurst& result);
     void reset();
 
+    // True if the last process() call started a new burst
+    // (passive_main.cpp takes the pre-burst cancels then).
+    bool started() const { return !bank_.started().empty(); }
+
 private:
-    bool should_terminate(double time_gap);
-    void classify_direction();
-    void compute_fingerprint();
-    bool passes_filter();
+    // LOBSTER direction for Type 1: 1 = buy (bid), -1 = sell (ask)
+    using BidAskFlow = SideFlow<1>;
+
+    // Build the finished burst into `out`; false if it fails the filter.
+    bool close_burst(const BurstSpan& span, const SideCounts& sides, const SizeStats& sizes,
+                     const GapStats& gaps, const CancelTotals& cancels, PassiveBurst& out) const;
+    bool passes_filter(const PassiveBurst& b) const;
 
-    double silence_threshold_;
+    BurstBank<NearBboSubmissions, BidAskFlow, SizeProfile, EventGaps, NearBboCancels> bank_;
     double min_volume_threshold_;
     double direction_threshold_;
     double volume_ratio_threshold_;
-    int max_bbo_levels_;  // How many levels from BBO to accept (e.g., 3)
-
-    // Hawkes state
-    double hawkes_beta_;
-    double trigger_intensity_;
-    bool use_hawkes_;
-    double hawkes_intensity_;
-
-    bool is_active_;
-    PassiveBurst current_burst_;
-    double last_msg_time_;
-    double last_mid_price_;
-
-    // Submission size tracking
-    std::vector<int> submission_sizes_;
-    int round_lot_count_;
-
-    // Directional accumulators
-    int bid_sub_count_;
-    int ask_sub_count_;
-    int bid_sub_volume_;
-    int ask_sub_volume_;
-
-    // Cancellation accumulators during burst
-    int cancel_count_;
-    int cancel_volume_;
-    int bid_cancel_count_;
-    int ask_cancel_count_;
-    int bid_cancel_volume_;
-    int ask_cancel_volume_;
-
-    // Price extremes
-    double max_price_;
-    double min_price_;
-
-    double pending_preburst_cancel_rate_;
 };
 
 #endif
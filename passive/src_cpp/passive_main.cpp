@@ -26,6 +26,7 @@
 #include <chrono>
 #include <cerrno>
 #include <cstring>
+#include <cstdio>
 #include <dirent.h>
 #include <numeric>
 
@@ -33,11 +34,17 @@
 #include "../../src_cpp/types.h"
 #include "passive_burst.h"
 #include "../../src_cpp/orderbook.h"
+#include "../../src_cpp/daysum.h"
+#include "../../src_cpp/book_index.h"
+#include "../../src_cpp/rolling.h"
+#include "../../src_cpp/timeline.h"
+#include "../../src_cpp/forward.h"
 
 // ── Helpers (copied from main.cpp to avoid coupling) ────────
 
 constexpr double RTH_DEFAULT_START = 34200.0;
 constexpr double RTH_DEFAULT_END   = 57600.0;
+constexpr size_t PARSE_BATCH       = 4096;   // rows per LobsterParser::next_batch
 
 std::vector<std::string> find_message_files(const std::string& folder) {
     std::vector<std::string> files;
@@ -46,8 +53,9 @@ std::vector<std::string> find_message_files(const std::string& folder) {
     struct dirent* entry;
     while ((entry = readdir(dir)) != nullptr) {
         std::string name = entry->d_name;
+        bool is_csv = name.size() > 4 && name.substr(name.size() - 4) == ".csv";
         if (name.find("message") != std::string::npos &&
-            name.size() > 4 && name.substr(name.size() - 4) == ".csv") {
+            (is_csv || is_lobbin_path(name))) {
             std::string path = folder;
             if (!path.empty() && path.back() != '/') path += '/';
             files.push_back(path + name);
@@ -55,7 +63,15 @@ std::vector<std::string> find_message_files(const std::string& folder) {
     }
     closedir(dir);
     std::sort(files.begin(), files.end());
-    return files;
+    // Prefer X.lobbin over X.csv when both exist
+    std::vector<std::string> unique;
+    for (const auto& f : files) {
+        if (!is_lobbin_path(f) &&
+            std::binary_search(files.begin(), files.end(), f.substr(0, f.size() - 4) + ".lobbin"))
+            continue;
+        unique.push_back(f);
+    }
+    return unique;
 }
 
 std::string extract_date(const std::string& filepath) {
@@ -77,43 +93,24 @@ std::string extract_ticker(const std::string& folder) {
     return (upos != std::string::npos) ? dirname.substr(0, upos) : dirname;
 }
 
-double lookup_mid(const std::vector<std::pair<double, double>>& snaps, double target_time) {
-    if (snaps.empty()) return 0.0;
-    if (target_time <= snaps.front().first) return snaps.front().second;
-    if (target_time >= snaps.back().first)  return snaps.back().second;
-    auto it = std::upper_bound(snaps.begin(), snaps.end(), target_time,
-        [](double t, const std::pair<double, double>& p) { return t < p.first; });
-    if (it != snaps.begin()) --it;
-    return it->second;
-}
-
-double find_peak_price(const std::vector<std::pair<double, double>>& snaps,
-                       double start_time, double start_price, double tau_max, int direction) {
-    if (snaps.empty()) return start_price;
-    auto it = std::lower_bound(snaps.begin(), snaps.end(), start_time,
-        [](const std::pair<double, double>& p, double t) { return p.first < t; });
-    double end_time = start_time + tau_max;
-    double max_p = start_price, min_p = start_price;
-    while (it != snaps.end() && it->first <= end_time) {
-        max_p = std::max(max_p, it->second);
-        min_p = std::min(min_p, it->second);
-        ++it;
-    }
-    if (direction == 1)  return max_p;
-    if (direction == -1) return min_p;
-    return (std::abs(max_p - start_price) >= std::abs(min_p - start_price)) ? max_p : min_p;
-}
-
-// Compute total RTH submission volume (Type 1) for ADV scaling
-long long compute_rth_submission_volume(const std::string& msg_file, double rth_start, double rth_end) {
-    LobsterParser parser(msg_file);
-    LobsterMessage msg;
+// Compute total RTH submission volume (Type 1) for ADV scaling.
+// Only used by the -A 2 pre-pass; by default process_day measures it.
+// -1 if the file could not be read in full.
+long long compute_rth_submission_volume(const std::string& msg_file, double rth_start, double rth_end,
+                                        ParseMode parse_mode) {
+    LobsterParser parser(msg_file, parse_mode);
+    std::vector<LobsterMessage> batch(PARSE_BATCH);
     long long vol = 0;
-    while (parser.next_message(msg)) {
-        if (msg.time < rth_start || msg.time > rth_end) continue;
-        if (msg.type == 1) vol += (long long)msg.size;
+    size_t n;
+    while ((n = parser.next_batch(batch.data(), batch.size())) > 0) {
+        for (size_t k = 0; k < n; ++k) {
+            const LobsterMessage& msg = batch[k];
+            if (msg.time > rth_end) return vol;     // rows are in time order
+            if (msg.time < rth_start) continue;
+            if (msg.type == 1) vol += (long long)msg.size;
+        }
     }
-    return vol;
+    return parser.failed() ? -1 : vol;
 }
 
 struct MarketState {
@@ -123,21 +120,62 @@ struct MarketState {
     int bid_depth_5;
     int ask_depth_5;
     double book_imbalance;
-    double volatility_60s;
-    double momentum_5s;
-    double momentum_30s;
-    double momentum_60s;
+    double volatility[MAX_FEATURE_WINDOWS];   // per -V window
+    double momentum[MAX_FEATURE_WINDOWS];     // per -M lag
     int trade_count_5m;
     int trade_volume_5m;
+    int bid_levels[BOOK_TOP_LEVELS];   // size at bid levels L1..L10
+    int ask_levels[BOOK_TOP_LEVELS];
+    CancelTotals pre_cancels[MAX_FEATURE_WINDOWS];   // cancels by side, per -w window
 };
 
 struct DayResult {
     std::string date;
     long msg_count = 0;
+    double resumed_at = -1.0;    // checkpoint time the replay started from
+    double stopped_at = -1.0;    // time of the row the replay stopped before
     size_t burst_candidates = 0;
     size_t burst_kept = 0;
 };
 
+// Trailing average daily volume, fed one day at a time in date order
+// (same as main.cpp).  With no history a day bootstraps from itself.
+struct TrailingAdv {
+    size_t window;
+    std::deque<long long> history;
+    long long sum = 0;
+
+    explicit TrailingAdv(size_t w) : window(w) {}
+
+    bool empty() const { return history.empty(); }
+
+    double value(long long day_vol) const {
+        return history.empty() ? (double)day_vol : (double)sum / (double)history.size();
+    }
+
+    void push(long long day_vol) {
+        history.push_back(day_vol);
+        sum += day_vol;
+        if (history.size() > window) {
+            sum -= history.front();
+            history.pop_front();
+        }
+    }
+};
+
+// A replayed day, formatted but not yet written.  Days that ran before
+// their threshold was known used no volume floor; commit applies it in
+// date order (see main.cpp PendingDay).
+struct PendingDay {
+    DayResult res;
+    DaySummary summary;                       // measured in the replay
+    OrderTableStats order_stats;
+    std::vector<int> candidate_volumes;
+    std::string csv;
+    std::vector<std::pair<int, size_t>> rows; // (burst volume, end offset in csv)
+    bool input_failed = false;                // the day file was not read in full
+};
+
 void print_usage(const char* prog) {
     std::cerr << "Usage: " << prog << " <stock_folder> <output_file> [options]\n"
               << "Options:\n"
@@ -146,12 +184,26 @@ void print_usage(const char* prog) {
               << "  -r <vol_ratio>  volume ratio cap (default: 0.5)\n"
               << "  -k <kappa>      kappa filter (default: 0.0, no filter for passive)\n"
               << "  -t <tau_max>    peak-impact horizon in seconds (default: 10.0)\n"
+              << "  -T <h,...>      forward horizons, one Mid_<h> column each: 30s, 10m,\n"
+              << "                  2h, ... or close (mid at -e)  (default: 1m,3m,5m,10m;\n"
+              << "                  at most " << MAX_HORIZONS << "; the -k filter always uses 1m,3m,5m,10m)\n"
               << "  -j <workers>    parallel day workers (default: 1)\n"
               << "  -b <rth_start>  RTH start sec-past-midnight (default: 34200)\n"
               << "  -e <rth_end>    RTH end (default: 57600)\n"
               << "  -H <beta>       Hawkes decay rate (default: 1.0)\n"
               << "  -I <intensity>  Hawkes trigger threshold (default: 0.5)\n"
-              << "  -L <levels>     max BBO levels for submission filter (default: 3)\n";
+              << "  -L <levels>     max BBO levels for submission filter (default: 3)\n"
+              << "  -V <secs,...>   volatility windows (default: 60; at most " << MAX_FEATURE_WINDOWS << ")\n"
+              << "  -M <secs,...>   momentum lags (default: 5,30,60; at most " << MAX_FEATURE_WINDOWS << ")\n"
+              << "  -w <secs,...>   pre-burst cancel windows, the first for PreBurstCancelRate\n"
+              << "                  (default: 0.050; at most " << MAX_FEATURE_WINDOWS << ")\n"
+              << "  -P <mode>       input parser: mmap | stream (default: mmap)\n"
+              << "  -B <ladder>     book price ladder: map | flat (default: " << ladder_kind_name(DEFAULT_LADDER) << ")\n"
+              << "  -O <table>      book order table: hash | dense (default: hash)\n"
+              << "  -A <passes>     1 = measure ADV during the replay, 2 = pre-pass (default: 1)\n"
+              << "  -C <dir|off>    day summary cache folder (default: next to each day file)\n"
+              << "  -X <secs|off>   book index: build with a checkpoint every <secs> where\n"
+              << "                  missing; off = ignore (default: use existing, build none)\n";
 }
 
 int main(int argc, char* argv[]) {
@@ -178,6 +230,15 @@ int main(int argc, char* argv[]) {
     double hawkes_beta         = 1.0;
     double trigger_intensity   = 0.5;
     int max_bbo_levels         = 3;
+    ParseMode parse_mode       = ParseMode::MMAP;
+    LadderKind ladder          = DEFAULT_LADDER;
+    OrderTableKind order_table = OrderTableKind::HASH;
+    int adv_passes             = 1;
+    std::string summary_cache;
+    bool use_index             = true;
+    double checkpoint_interval = 0.0;
+    FeatureWindows feature_windows;
+    std::vector<Horizon> horizons = default_horizons();
 
     for (int i = 3; i < argc; i += 2) {
         if (i + 1 >= argc) break;
@@ -193,8 +254,63 @@ int main(int argc, char* argv[]) {
         else if (opt == "-H") hawkes_beta         = std::stod(argv[i+1]);
         else if (opt == "-I") trigger_intensity   = std::stod(argv[i+1]);
         else if (opt == "-L") max_bbo_levels      = std::stoi(argv[i+1]);
+        else if (opt == "-P") {
+            if (!parse_mode_from_string(argv[i+1], &parse_mode)) {
+                std::cerr << "Error: -P takes mmap or stream. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-B") {
+            if (!ladder_kind_from_string(argv[i+1], &ladder)) {
+                std::cerr << "Error: -B takes map or flat. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-O") {
+            if (!order_table_kind_from_string(argv[i+1], &order_table)) {
+                std::cerr << "Error: -O takes hash or dense. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-A") adv_passes          = (std::stoi(argv[i+1]) == 2) ? 2 : 1;
+        else if (opt == "-C") summary_cache       = argv[i+1];
+        else if (opt == "-V" || opt == "-M" || opt == "-w") {
+            std::vector<double> list = parse_window_list(argv[i+1]);
+            if (list.empty()) {
+                std::cerr << "Error: " << opt << " takes up to " << MAX_FEATURE_WINDOWS
+                          << " comma-separated windows in seconds. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+            (opt == "-V" ? feature_windows.volatility
+             : opt == "-M" ? feature_windows.momentum : feature_windows.cancels) = list;
+        }
+        else if (opt == "-T") {
+            horizons = parse_horizons(argv[i+1]);
+            if (horizons.empty()) {
+                std::cerr << "Error: -T takes up to " << MAX_HORIZONS << " comma-separated horizons such as "
+                          << "30s,10m,1h,close. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-X") {
+            use_index = std::string(argv[i+1]) != "off";
+            checkpoint_interval = use_index ? std::max(0.0, std::stod(argv[i+1])) : 0.0;
+        }
     }
 
+    // Forward lookups: the -k horizons, then any other -T horizon;
+    // horizon_slot maps -T entries onto them.
+    std::vector<double> forward_offsets(std::begin(DECAY_HORIZONS), std::end(DECAY_HORIZONS));
+    std::vector<size_t> horizon_slot(horizons.size(), 0);
+    for (size_t k = 0; k < horizons.size(); ++k) {
+        if (horizons[k].close) continue;
+        auto it = std::find(forward_offsets.begin(), forward_offsets.end(), horizons[k].secs);
+        horizon_slot[k] = it - forward_offsets.begin();
+        if (it == forward_offsets.end()) forward_offsets.push_back(horizons[k].secs);
+    }
+    const double forward_reach = std::max({longest_horizon(horizons), DECAY_HORIZONS[3], tau_max});
+    const bool   close_horizon = has_close_horizon(horizons);
+
     auto msg_files = find_message_files(stock_folder);
     if (msg_files.empty()) {
         std::cerr << "Error: No message files in " << stock_folder << "\n";
@@ -203,37 +319,61 @@ int main(int argc, char* argv[]) {
 
     std::string ticker = extract_ticker(stock_folder);
 
-    // Precompute ADV using Type 1 submission volume (avoids TSLA/SPY drought)
+    // ADV uses Type 1 submission volume (avoids TSLA/SPY drought).  By
+    // default (-A 1) it is measured during each day's replay and applied
+    // at commit; -A 2 keeps the separate pre-pass.  Days found in the
+    // summary cache (daysum.h) are never pre-scanned.
     const size_t ADV_WINDOW = 14;
-    std::vector<long long> day_sub_volumes(msg_files.size(), 0);
-    std::vector<double> day_min_volume_thresholds(msg_files.size(), 0.0);
-    std::deque<long long> adv_history;
-    long long adv_history_sum = 0;
-
+    std::vector<char> day_cached(msg_files.size(), 0);
+    std::vector<DaySummary> day_cache(msg_files.size());
+    std::vector<double> known_floor(msg_files.size(), -1.0);
+    size_t cache_hits = 0;
     for (size_t i = 0; i < msg_files.size(); ++i) {
-        long long day_vol = compute_rth_submission_volume(msg_files[i], rth_start, rth_end);
-        day_sub_volumes[i] = day_vol;
-        double trailing_adv = (!adv_history.empty())
-            ? (double)adv_history_sum / (double)adv_history.size()
-            : (double)day_vol;
-        day_min_volume_thresholds[i] = volume_fraction * trailing_adv;
-        adv_history.push_back(day_vol);
-        adv_history_sum += day_vol;
-        if (adv_history.size() > ADV_WINDOW) {
-            adv_history_sum -= adv_history.front();
-            adv_history.pop_front();
+        day_cached[i] = load_day_summary(msg_files[i], summary_cache, rth_start, rth_end, day_cache[i]);
+        cache_hits += day_cached[i];
+        if (adv_passes == 2 && !day_cached[i]) {
+            day_cache[i].rth_submission_volume =
+                compute_rth_submission_volume(msg_files[i], rth_start, rth_end, parse_mode);
+            if (day_cache[i].rth_submission_volume < 0) {
+                std::cerr << "Error: " << msg_files[i] << " could not be read in full\n";
+                std::remove(output_file.c_str());   // the probe's empty file
+                return 1;
+            }
+        }
+    }
+
+    // Thresholds known before any replay (see main.cpp).
+    {
+        TrailingAdv pre_adv(ADV_WINDOW);
+        for (size_t i = 0; i < msg_files.size(); ++i) {
+            bool have_vol = day_cached[i] || adv_passes == 2;
+            if (i == 0 && !have_vol) break;
+            known_floor[i] = volume_fraction * pre_adv.value(day_cache[i].rth_submission_volume);
+            if (!have_vol) break;
+            pre_adv.push(day_cache[i].rth_submission_volume);
         }
     }
 
     std::cout << "PASSIVE Burst Detector\n";
     std::cout << "Ticker: " << ticker << "\n";
-    std::cout << "Found " << msg_files.size() << " day file(s)\n";
+    std::cout << "Found " << msg_files.size() << " day file(s), "
+              << cache_hits << " in the summary cache\n";
     std::cout << "Settings: vol_frac=" << volume_fraction
               << "  dir_thresh=" << direction_threshold
+              << "  horizons=" << join_horizons(horizons)
               << "  hawkes_beta=" << hawkes_beta
               << "  trigger_intensity=" << trigger_intensity
               << "  max_bbo_levels=" << max_bbo_levels
-              << "  workers=" << workers << "\n\n";
+              << "  vol_windows=" << join_windows(feature_windows.volatility)
+              << "  mom_lags=" << join_windows(feature_windows.momentum)
+              << "  cancel_windows=" << join_windows(feature_windows.cancels)
+              << "  workers=" << workers
+              << "  adv_passes=" << adv_passes
+              << "  parser=" << (parse_mode == ParseMode::MMAP ? std::string("mmap/") + parser_simd_level() : std::string("stream"))
+              << "  book=" << ladder_kind_name(ladder) << "/" << order_table_kind_name(order_table)
+              << "  index=" << (!use_index ? std::string("off")
+                               : checkpoint_interval > 0.0 ? "build/" + std::to_string((long)checkpoint_interval) + "s"
+                               : std::string("use")) << "\n\n";
 
     std::ofstream out(output_file);
     if (!out.is_open()) {
@@ -242,21 +382,33 @@ int main(int argc, char* argv[]) {
     }
     out << "Ticker,Date,BurstID,StartTime,EndTime,Direction,Volume,SubmissionCount,"
         << "BidSubCount,AskSubCount,BidSubVolume,AskSubVolume,BidRatio,AskRatio,MinMaxVolRatio,"
-        << "StartPrice,EndPrice,PeakPrice,CloseMid,"
-        << "Mid_1m,Mid_3m,Mid_5m,Mid_10m,"
-        << "Spread,BidVolBest,AskVolBest,BidDepth5,AskDepth5,BookImbalance,"
-        << "Volatility60s,Momentum5s,Momentum30s,Momentum60s,"
-        << "TradeCount5m,TradeVolume5m,"
-        << "SubmissionSizeVariance,RoundLotPct,HawkesPeakIntensity,"
+        << "StartPrice,EndPrice,PeakPrice,CloseMid,";
+    for (const Horizon& h : horizons) out << "Mid_" << h.label << ",";
+    out << "Spread,BidVolBest,AskVolBest,BidDepth5,AskDepth5,BookImbalance,";
+    for (double w : feature_windows.volatility) out << "Volatility" << window_label(w) << ",";
+    for (double l : feature_windows.momentum)   out << "Momentum" << window_label(l) << ",";
+    out << "TradeCount5m,TradeVolume5m,"
+        << "SubmissionSizeVariance,RoundLotPct,"
+        << "SubmissionSizeSkew,SubmissionSizeEntropy,InterSubmissionCV,HawkesPeakIntensity,"
         << "CancelCount,CancelVolume,BidCancelCount,AskCancelCount,"
-        << "BidCancelVolume,AskCancelVolume,CancelRatio,PreBurstCancelRate\n";
+        << "BidCancelVolume,AskCancelVolume,CancelRatio,PreBurstCancelRate";
+    for (double w : feature_windows.cancels) {
+        const std::string l = window_label(w);
+        out << ",PreBidCancelCount" << l << ",PreAskCancelCount" << l
+            << ",PreBidCancelVolume" << l << ",PreAskCancelVolume" << l;
+    }
+    for (int k = 1; k <= BOOK_TOP_LEVELS; ++k) out << ",BidL" << k;
+    for (int k = 1; k <= BOOK_TOP_LEVELS; ++k) out << ",AskL" << k;
+    out << "\n";
 
-    std::mutex log_mutex, write_mutex;
+    std::mutex log_mutex;
     auto t0 = std::chrono::steady_clock::now();
 
-    auto process_day = [&](const std::string& msg_file, size_t day_idx, size_t total_days,
-                           std::atomic<size_t>& done_counter) -> DayResult {
-        DayResult day_res;
+    // min_volume < 0: threshold not known yet, run with no floor.
+    auto process_day = [&](const std::string& msg_file, double min_volume, size_t day_idx,
+                           size_t total_days) -> PendingDay {
+        PendingDay pending;
+        DayResult& day_res = pending.res;
         day_res.date = extract_date(msg_file);
 
         { std::lock_guard<std::mutex> lk(log_mutex);
@@ -264,58 +416,25 @@ int main(int argc, char* argv[]) {
                     << day_res.date << "\n";
         }
 
-        OrderBook book;
+        static thread_local OrderTable worker_orders;   // recycled across days
+        worker_orders.set_kind(order_table);
+        OrderBook book(ladder, &worker_orders);
         PassiveBurstDetector detector(
-            1.0, day_min_volume_thresholds[day_idx], direction_threshold,
+            1.0, std::max(0.0, min_volume), direction_threshold,
             volume_ratio_threshold, hawkes_beta, trigger_intensity, max_bbo_levels);
-        LobsterParser parser(msg_file);
-
-        std::vector<std::pair<double, double>> mid_snapshots;
-        mid_snapshots.reserve(500000);
-
-        // Rolling stats
-        std::deque<std::pair<double, double>> mid_ring;
-        const double VOL_WINDOW = 60.0;
-        struct TradeStamp { double time; int size; };
-        std::deque<TradeStamp> trade_ring;
-        const double TRADE_WINDOW = 300.0;
-
-        // Pre-burst cancel ring
-        struct CancelEvent { double time; int direction; int size; };
-        std::deque<CancelEvent> cancel_ring;
-        double cancel_window = 0.050;
-
-        auto calc_volatility = [&](double now) -> double {
-            while (!mid_ring.empty() && mid_ring.front().first < now - VOL_WINDOW)
-                mid_ring.pop_front();
-            if (mid_ring.size() < 2) return 0.0;
-            double sum_sq = 0.0; int n = 0;
-            for (size_t k = 1; k < mid_ring.size(); ++k) {
-                double prev = mid_ring[k-1].second;
-                if (prev == 0.0) continue;
-                double ret = (mid_ring[k].second - prev) / prev;
-                sum_sq += ret * ret; ++n;
-            }
-            return (n > 0) ? std::sqrt(sum_sq / n) : 0.0;
-        };
+        LobsterParser parser(msg_file, parse_mode);
 
-        auto calc_momentum = [&](double now, double delta, double current_mid) -> double {
-            double target = now - delta;
-            double ref_mid = 0.0;
-            for (auto it = mid_ring.rbegin(); it != mid_ring.rend(); ++it) {
-                if (it->first <= target) { ref_mid = it->second; break; }
-            }
-            if (ref_mid == 0.0 || current_mid == 0.0) return 0.0;
-            return (current_mid - ref_mid) / ref_mid;
-        };
+        L1Timeline timeline;   // BBO updates, mid changes marked (timeline.h)
+        timeline.reserve(500000);
 
-        auto calc_trade_stats = [&](double now) -> std::pair<int, int> {
-            while (!trade_ring.empty() && trade_ring.front().time < now - TRADE_WINDOW)
-                trade_ring.pop_front();
-            int cnt = 0, vol = 0;
-            for (auto& t : trade_ring) { ++cnt; vol += t.size; }
-            return {cnt, vol};
-        };
+        // Rolling stats (see rolling.h)
+        RollingFeatures features;
+        features.configure(feature_windows);
+
+        // Pre-burst cancels by side, per -w window
+        CancelWindows cancels;
+        cancels.configure(feature_windows.cancels);
+        CancelTotals burst_cancels[MAX_FEATURE_WINDOWS];   // as of the open burst's start
 
         auto snapshot_market_state = [&](double now, double current_mid) -> MarketState {
             MarketState s{};
@@ -324,110 +443,173 @@ int main(int argc, char* argv[]) {
             s.ask_vol_best = book.get_ask_volume_at_best();
             s.bid_depth_5 = book.get_bid_depth(5);
             s.ask_depth_5 = book.get_ask_depth(5);
+            for (int k = 0; k < BOOK_TOP_LEVELS; ++k) {
+                s.bid_levels[k] = book.get_bid_level_volume(k + 1);
+                s.ask_levels[k] = book.get_ask_level_volume(k + 1);
+            }
             double total_depth = (double)(s.bid_depth_5 + s.ask_depth_5);
             s.book_imbalance = (total_depth > 0)
                 ? (double)(s.bid_depth_5 - s.ask_depth_5) / total_depth : 0.0;
-            s.volatility_60s = calc_volatility(now);
-            s.momentum_5s = calc_momentum(now, 5.0, current_mid);
-            s.momentum_30s = calc_momentum(now, 30.0, current_mid);
-            s.momentum_60s = calc_momentum(now, 60.0, current_mid);
-            auto [tc, tv] = calc_trade_stats(now);
+            for (size_t w = 0; w < feature_windows.volatility.size(); ++w)
+                s.volatility[w] = features.volatility(w, now);
+            for (size_t l = 0; l < feature_windows.momentum.size(); ++l)
+                s.momentum[l] = features.momentum(l, now, current_mid);
+            auto [tc, tv] = features.trades(now);
             s.trade_count_5m = tc; s.trade_volume_5m = tv;
             return s;
         };
 
-        auto calc_preburst_cancel_rate = [&](double burst_start_time) -> double {
-            double prune_cutoff = burst_start_time - 1.0;
-            while (!cancel_ring.empty() && cancel_ring.front().time < prune_cutoff)
-                cancel_ring.pop_front();
-            double window_start = burst_start_time - cancel_window;
-            int ask_cancels = 0, bid_cancels = 0, total_events = 0;
-            for (auto it = cancel_ring.rbegin(); it != cancel_ring.rend(); ++it) {
-                if (it->time < window_start) break;
-                if (it->time > burst_start_time) continue;
-                total_events++;
-                if (it->direction == -1) ask_cancels++; else bid_cancels++;
-            }
-            if (total_events == 0) return 0.0;
-            return (double)std::max(ask_cancels, bid_cancels) / (double)total_events;
-        };
+        // Book index (see main.cpp process_day_file): resume from the last
+        // checkpoint before RTH's first cancel window, and stop reading
+        // past the last forward lookup once the day's totals are known.
+        BookIndex index;
+        std::vector<uint8_t> start_book;
+        std::unique_ptr<BookIndexWriter> writer;
+        const BookCheckpoint* start = nullptr;
+        double stop_after = std::numeric_limits<double>::infinity();
+        const bool indexed = use_index &&
+                             load_book_index(msg_file, summary_cache, index) &&
+                             (checkpoint_interval <= 0.0 || index.interval == checkpoint_interval);
+        if (indexed) {
+            start = index.latest_before(rth_start - longest(feature_windows.cancels));
+            if (start && !index.read_book(*start, start_book)) start = nullptr;
+        } else if (checkpoint_interval > 0.0) {
+            writer.reset(new BookIndexWriter(msg_file, summary_cache, checkpoint_interval));
+            if (!writer->ok()) writer.reset();
+        }
+        if (!writer && (indexed || day_cached[day_idx])) {
+            stop_after = rth_end + forward_reach;
+        }
 
-        LobsterMessage msg;
+        std::vector<LobsterMessage> batch(PARSE_BATCH);
+        size_t batch_n = 0;
         PassiveBurst finished;
         std::vector<std::pair<PassiveBurst, MarketState>> day_bursts;
+
+        // Record `finished` with its MarketState and pre-burst cancels.
+        auto close_burst = [&](double current_mid) {
+            MarketState ms = snapshot_market_state(finished.start_time, current_mid);
+            std::copy(burst_cancels, burst_cancels + cancels.windows(), ms.pre_cancels);
+            finished.preburst_cancel_rate = busier_side_rate(ms.pre_cancels[0]);
+            day_bursts.push_back({finished, ms});
+        };
         double current_mid = 0.0;
         long msg_count = 0;
         bool flushed = false;
 
-        while (parser.next_message(msg)) {
-            ++msg_count;
-            bool bbo_changed = book.process_message(msg);
+        // Mid tracking: the mid only moves with a best price.
+        book.subscribe(BOOK_BID_PRICE | BOOK_ASK_PRICE, [&](const BookDelta& d) {
+            if (!d.valid()) return;
+            double new_mid = d.mid();
+            const bool moved = new_mid != current_mid;
+            current_mid = new_mid;
+            timeline.push(d.time, d.best_bid, d.best_ask, moved);
+        });
+
+        if (start) {
+            if (book.restore_checkpoint(start_book.data(), start_book.size()) &&
+                parser.seek(start->position)) {
+                msg_count   = (long)start->rows;
+                current_mid = start->mid;
+                if (start->bbo_time >= 0.0)
+                    timeline.seed(start->bbo_time, start->bbo_bid, start->bbo_ask, start->mid_time);
+                day_res.resumed_at = start->time;
+            } else {
+                book.reset();
+                parser.seek(0);
+            }
+        }
 
-            if (book.is_valid()) {
-                double new_mid = book.get_mid_price();
-                if (new_mid != current_mid) {
-                    current_mid = new_mid;
-                    mid_snapshots.push_back({msg.time, current_mid});
+        while (day_res.stopped_at < 0.0 &&
+               (batch_n = parser.next_batch(batch.data(), batch.size())) > 0) {
+            for (size_t bi = 0; bi < batch_n; ++bi) {
+                const LobsterMessage& msg = batch[bi];
+                if (msg.time > stop_after) {
+                    day_res.stopped_at = msg.time;
+                    break;
                 }
-            }
+                ++msg_count;
+                const BookDelta delta = book.process_message(msg);
 
-            // Track cancellations for pre-burst feature
-            if (msg.type == 2 || msg.type == 3) {
-                cancel_ring.push_back({msg.time, msg.direction, msg.size});
-            }
+                // Track cancellations for pre-burst feature
+                if (msg.type == 2 || msg.type == 3) {
+                    cancels.on_cancel(msg.time, msg.direction, msg.size);
+                }
 
-            if (msg.time < rth_start) continue;
+                if (msg.time < rth_start) continue;
 
-            // Rolling stats
-            if (current_mid > 0.0) {
-                if (mid_ring.empty() || mid_ring.back().second != current_mid)
-                    mid_ring.push_back({msg.time, current_mid});
-            }
-            if (msg.type == 1)
-                trade_ring.push_back({msg.time, msg.size});
-
-            if (msg.time > rth_end) {
-                if (!flushed) {
-                    if (detector.flush(finished)) {
-                        MarketState ms = snapshot_market_state(finished.start_time, current_mid);
-                        day_bursts.push_back({finished, ms});
+                // Rolling stats
+                if (current_mid > 0.0) {
+                    features.on_mid(msg.time, current_mid);
+                }
+                if (msg.type == 1) {
+                    features.on_trade(msg.time, msg.size);
+                    if (msg.time <= rth_end) pending.summary.rth_submission_volume += (long long)msg.size;
+                }
+                if ((msg.type == 4 || msg.type == 5) && msg.time <= rth_end) {
+                    pending.summary.rth_trade_volume += (long long)msg.size;
+                }
+
+                if (msg.time > rth_end) {
+                    if (!flushed) {
+                        if (detector.flush(finished)) close_burst(current_mid);
+                        flushed = true;
                     }
-                    flushed = true;
+                    continue;
                 }
-                continue;
-            }
 
-            // Feed to passive burst detector
-            if (current_mid > 0.0 && book.is_valid()) {
-                if (msg.type == 1) {
-                    double cr = calc_preburst_cancel_rate(msg.time);
-                    detector.set_preburst_cancel_rate(cr);
+                // Feed to passive burst detector
+                if (current_mid > 0.0 && delta.valid()) {
+                    if (detector.process(msg, current_mid, delta.best_bid, delta.best_ask, finished))
+                        close_burst(current_mid);
+                    if (detector.started()) {
+                        for (size_t w = 0; w < cancels.windows(); ++w)
+                            burst_cancels[w] = cancels.at(w, msg.time);
+                    }
                 }
-                int bb = book.get_best_bid();
-                int ba = book.get_best_ask();
-                if (detector.process(msg, current_mid, bb, ba, finished)) {
-                    MarketState ms = snapshot_market_state(finished.start_time, current_mid);
-                    day_bursts.push_back({finished, ms});
+            }
+
+            if (writer && writer->due(batch[batch_n - 1].time)) {
+                BookCheckpoint c;
+                c.time     = batch[batch_n - 1].time;
+                c.position = parser.tell();
+                c.rows     = (uint64_t)msg_count;
+                c.mid      = current_mid;
+                c.mid_time = timeline.last_mid_time();
+                c.bbo_time = -1.0;
+                if (!timeline.empty()) {
+                    const size_t last = timeline.size() - 1;
+                    c.bbo_time = timeline.time(last);
+                    c.bbo_bid  = timeline.bid(last);
+                    c.bbo_ask  = timeline.ask(last);
                 }
+                writer->add(c, book);
             }
         }
 
-        if (!flushed && detector.flush(finished)) {
-            MarketState ms = snapshot_market_state(finished.start_time, current_mid);
-            day_bursts.push_back({finished, ms});
-        }
+        if (!flushed && detector.flush(finished)) close_burst(current_mid);
 
         double close_mid = current_mid;
-
-        // Compute forward returns and write CSV
+        if (day_res.stopped_at >= 0.0) {
+            msg_count = indexed ? index.msg_count : day_cache[day_idx].msg_count;
+            close_mid = indexed ? index.close_mid : day_cache[day_idx].close_mid;
+        }
+        pending.input_failed = parser.failed();
+        if (writer && !pending.input_failed) writer->finish(msg_count, close_mid);
+
+        // Compute forward returns (one cursor sweep, see forward.h) and write CSV
+        PeakSweep peaks(timeline, tau_max);
+        std::vector<AsOfCursor> mid_at(forward_offsets.size(), AsOfCursor(timeline));
+        const double mid_at_close = close_horizon ? AsOfCursor(timeline).mid(rth_end) : 0.0;
+        double fwd[MAX_HORIZONS + 4];
         std::ostringstream day_csv;
         for (auto& [b, ms] : day_bursts) {
-            b.peak_price = find_peak_price(mid_snapshots, b.start_time, b.start_price, tau_max, b.direction);
+            pending.candidate_volumes.push_back(b.volume);
+            b.peak_price = peaks.peak(b.start_time, b.start_price, b.direction);
 
-            double mid_1m  = lookup_mid(mid_snapshots, b.end_time + 60.0);
-            double mid_3m  = lookup_mid(mid_snapshots, b.end_time + 180.0);
-            double mid_5m  = lookup_mid(mid_snapshots, b.end_time + 300.0);
-            double mid_10m = lookup_mid(mid_snapshots, b.end_time + 600.0);
+            for (size_t o = 0; o < forward_offsets.size(); ++o) {
+                fwd[o] = mid_at[o].mid(b.end_time + forward_offsets[o]);
+            }
 
             // Apply kappa if set (default 0 for passive)
             if (kappa > 0.0) {
@@ -439,7 +621,7 @@ int main(int argc, char* argv[]) {
                         dc++;
                     }
                 };
-                acc(mid_1m); acc(mid_3m); acc(mid_5m); acc(mid_10m);
+                for (int o = 0; o < 4; ++o) acc(fwd[o]);
                 double d_b = (dc > 0) ? (dsum / dc) : 0.0;
                 if (d_b < kappa) continue;
             }
@@ -456,21 +638,25 @@ int main(int argc, char* argv[]) {
                     << b.minmax_vol_ratio << ","
                     << std::setprecision(4)
                     << b.start_price << "," << b.end_price << "," << b.peak_price << ","
-                    << close_mid << ","
-                    << mid_1m << "," << mid_3m << "," << mid_5m << "," << mid_10m << ","
-                    << std::setprecision(6)
+                    << close_mid << ",";
+            for (size_t k = 0; k < horizons.size(); ++k)
+                day_csv << (horizons[k].close ? mid_at_close : fwd[horizon_slot[k]]) << ",";
+            day_csv << std::setprecision(6)
                     << ms.spread << ","
                     << ms.bid_vol_best << "," << ms.ask_vol_best << ","
                     << ms.bid_depth_5 << "," << ms.ask_depth_5 << ","
                     << ms.book_imbalance << ","
-                    << std::setprecision(8)
-                    << ms.volatility_60s << ","
-                    << ms.momentum_5s << "," << ms.momentum_30s << "," << ms.momentum_60s << ","
-                    << ms.trade_count_5m << "," << ms.trade_volume_5m << ","
+                    << std::setprecision(8);
+            for (size_t w = 0; w < feature_windows.volatility.size(); ++w) day_csv << ms.volatility[w] << ",";
+            for (size_t l = 0; l < feature_windows.momentum.size(); ++l)   day_csv << ms.momentum[l] << ",";
+            day_csv << ms.trade_count_5m << "," << ms.trade_volume_5m << ","
                     << std::setprecision(4)
                     << b.submission_size_variance << ","
                     << std::setprecision(6)
                     << b.round_lot_pct << ","
+                    << b.submission_size_skew << ","
+                    << b.submission_size_entropy << ","
+                    << b.inter_submission_cv << ","
                     << std::setprecision(4)
                     << b.hawkes_peak_intensity << ","
                     << b.cancel_count << "," << b.cancel_volume << ","
@@ -478,32 +664,98 @@ int main(int argc, char* argv[]) {
                     << b.bid_cancel_volume << "," << b.ask_cancel_volume << ","
                     << std::setprecision(6)
                     << b.cancel_ratio << ","
-                    << b.preburst_cancel_rate
-                    << "\n";
-            day_res.burst_kept++;
+                    << b.preburst_cancel_rate;
+            for (size_t w = 0; w < feature_windows.cancels.size(); ++w) {
+                const CancelTotals& c = ms.pre_cancels[w];
+                day_csv << "," << c.bid_count << "," << c.ask_count
+                        << "," << c.bid_volume << "," << c.ask_volume;
+            }
+            for (int v : ms.bid_levels) day_csv << "," << v;
+            for (int v : ms.ask_levels) day_csv << "," << v;
+            day_csv << "\n";
+            pending.rows.push_back({b.volume, (size_t)day_csv.tellp()});
         }
+        pending.csv = day_csv.str();
+        day_res.msg_count = msg_count;
+        pending.summary.msg_count = msg_count;
+        pending.summary.close_mid = close_mid;
+        pending.order_stats = book.order_stats();
+        return pending;
+    };
 
-        { std::lock_guard<std::mutex> lk(write_mutex); out << day_csv.str(); }
+    // Ordered commit: fix each day's threshold from the committed days,
+    // filter its rows, write them, then add its volume to the history.
+    std::mutex commit_mutex;
+    TrailingAdv adv(ADV_WINDOW);
+    std::vector<PendingDay> pending_days(msg_files.size());
+    std::vector<char> day_ready(msg_files.size(), 0);
+    std::vector<DayResult> day_results(msg_files.size());
+    size_t next_commit = 0;
 
-        day_res.msg_count = msg_count;
-        day_res.burst_candidates = day_bursts.size();
+    auto volume_floor = [&](size_t day_idx) -> double {
+        if (known_floor[day_idx] >= 0.0) return known_floor[day_idx];
+        std::lock_guard<std::mutex> lk(commit_mutex);
+        if (next_commit == day_idx && !adv.empty()) return volume_fraction * adv.value(0);
+        return -1.0;
+    };
 
-        size_t done = done_counter.fetch_add(1) + 1;
-        { std::lock_guard<std::mutex> lk(log_mutex);
-          std::cout << "[done  " << done << "/" << total_days << "] "
-                    << day_res.date << " msgs=" << msg_count
-                    << " bursts=" << day_res.burst_candidates
-                    << " kept=" << day_res.burst_kept << "\n";
+    // A day file that could not be read in full stops the run; no output
+    // is kept.
+    std::atomic<bool> input_failed{false};
+    auto run_day = [&](size_t i) {
+        if (input_failed) return;
+        PendingDay p = process_day(msg_files[i], volume_floor(i), i, msg_files.size());
+        if (p.input_failed) {
+            std::cerr << "Error: " << msg_files[i] << " could not be read in full\n";
+            input_failed = true;
+            return;
+        }
+        if (!day_cached[i]) {
+            store_day_summary(msg_files[i], summary_cache, rth_start, rth_end, p.summary);
+        }
+        std::lock_guard<std::mutex> lk(commit_mutex);
+        pending_days[i] = std::move(p);
+        day_ready[i] = 1;
+        while (next_commit < msg_files.size() && day_ready[next_commit]) {
+            PendingDay& d = pending_days[next_commit];
+            DayResult& day_res = d.res;
+            const long long day_vol = d.summary.rth_submission_volume;
+            double threshold = volume_fraction * adv.value(day_vol);
+            for (int v : d.candidate_volumes) {
+                if ((double)v >= threshold) day_res.burst_candidates++;
+            }
+            size_t begin = 0;
+            for (const auto& [v, end] : d.rows) {
+                if ((double)v >= threshold) {
+                    out.write(d.csv.data() + begin, (std::streamsize)(end - begin));
+                    day_res.burst_kept++;
+                }
+                begin = end;
+            }
+            adv.push(day_vol);
+            day_results[next_commit] = day_res;
+            const OrderTableStats os = d.order_stats;
+            ++next_commit;
+
+            std::lock_guard<std::mutex> lk_log(log_mutex);
+            std::cout << "[done  " << next_commit << "/" << msg_files.size() << "] "
+                      << day_res.date << " msgs=" << day_res.msg_count
+                      << " bursts=" << day_res.burst_candidates
+                      << " kept=" << day_res.burst_kept
+                      << " orders_peak=" << os.peak_live
+                      << " probe=" << std::fixed << std::setprecision(2) << os.mean_probe()
+                      << "/" << os.max_probe;
+            if (os.dense_hits) std::cout << " dense_hits=" << os.dense_hits;
+            if (day_res.resumed_at >= 0.0) std::cout << " resumed@" << std::setprecision(0) << day_res.resumed_at;
+            if (day_res.stopped_at >= 0.0) std::cout << " stopped@" << std::setprecision(0) << day_res.stopped_at;
+            std::cout << "\n";
+            d = PendingDay();   // day_res refers into d
         }
-        return day_res;
     };
 
-    std::vector<DayResult> day_results(msg_files.size());
-    std::atomic<size_t> done_counter{0};
-
     if (workers <= 1 || msg_files.size() <= 1) {
         for (size_t i = 0; i < msg_files.size(); ++i)
-            day_results[i] = process_day(msg_files[i], i, msg_files.size(), done_counter);
+            run_day(i);
     } else {
         int nthreads = std::min<int>(workers, (int)msg_files.size());
         std::atomic<size_t> next_idx{0};
@@ -514,7 +766,7 @@ int main(int argc, char* argv[]) {
                 while (true) {
                     size_t i = next_idx.fetch_add(1);
                     if (i >= msg_files.size()) break;
-                    day_results[i] = process_day(msg_files[i], i, msg_files.size(), done_counter);
+                    run_day(i);
                 }
             });
         }
@@ -522,6 +774,10 @@ int main(int argc, char* argv[]) {
     }
 
     out.flush(); out.close();
+    if (input_failed) {
+        std::remove(output_file.c_str());
+        return 1;
+    }
 
     auto t1 = std::chrono::steady_clock::now();
     double elapsed = std::chrono::duration<double>(t1 - t0).count();
@@ -0,0 +1,242 @@
+#ifndef ACCUMULATORS_H
+#define ACCUMULATORS_H
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// Streaming accumulators: one pass, O(1) memory, no allocation
+// ─────────────────────────────────────────────────────────────
+//
+// A burst's features are folded in event by event as it runs, so
+// nothing about it is stored but these fixed-size states:
+//
+//   Moments        count, mean and central moments to the 4th
+//                  (Welford / Pébay updates): variance, skewness,
+//                  kurtosis
+//   MinMax         extremes
+//   Vwap           volume-weighted mean price
+//   InterArrival   Moments of the gaps between event times (CV)
+//   P2Quantile     one quantile, P² sketch (5 markers)
+//   LogHistogram   counts per power-of-two bucket (entropy)
+//
+// Each has add() and clear(); a default-constructed one is empty.
+// Statistics of too few points are 0.
+// ─────────────────────────────────────────────────────────────
+
+class Moments {
+public:
+    void clear() { *this = Moments(); }
+
+    void add(double x) {
+        const double n1 = (double)n_;
+        ++n_;
+        const double n       = (double)n_;
+        const double delta   = x - mean_;
+        const double delta_n = delta / n;
+        const double delta_n2 = delta_n * delta_n;
+        const double term1   = delta * delta_n * n1;
+        mean_ += delta_n;
+        m4_ += term1 * delta_n2 * (n * n - 3.0 * n + 3.0) + 6.0 * delta_n2 * m2_ - 4.0 * delta_n * m3_;
+        m3_ += term1 * delta_n * (n - 2.0) - 3.0 * delta_n * m2_;
+        m2_ += term1;
+    }
+
+    long long count() const { return n_; }
+    double    mean()  const { return mean_; }
+
+    // Sample variance Σ(x_i - mean)^2 / (N - 1).
+    double variance() const { return n_ > 1 ? m2_ / (double)(n_ - 1) : 0.0; }
+    double stddev()   const { return std::sqrt(variance()); }
+
+    // Moment coefficient of skewness g1 = m3 / m2^1.5 (0 if all equal).
+    double skewness() const {
+        if (n_ < 2 || m2_ <= 0.0) return 0.0;
+        return std::sqrt((double)n_) * m3_ / std::pow(m2_, 1.5);
+    }
+
+    // Excess kurtosis g2 = m4 / m2^2 - 3 (0 if all equal).
+    double kurtosis() const {
+        if (n_ < 2 || m2_ <= 0.0) return 0.0;
+        return (double)n_ * m4_ / (m2_ * m2_) - 3.0;
+    }
+
+private:
+    long long n_ = 0;
+    double mean_ = 0.0;
+    double m2_ = 0.0;   // m2..m4: Σ(x - mean)^k
+    double m3_ = 0.0;
+    double m4_ = 0.0;
+};
+
+struct MinMax {
+    double lo = std::numeric_limits<double>::infinity();
+    double hi = -std::numeric_limits<double>::infinity();
+
+    void clear() { *this = MinMax(); }
+    void add(double x) {
+        lo = std::min(lo, x);
+        hi = std::max(hi, x);
+    }
+    bool empty() const { return lo > hi; }
+};
+
+class Vwap {
+public:
+    void clear() { *this = Vwap(); }
+    void add(double price, long long size) {
+        notional_ += price * (double)size;
+        volume_   += size;
+    }
+    long long volume() const { return volume_; }
+    double value() const { return volume_ > 0 ? notional_ / (double)volume_ : 0.0; }
+
+private:
+    double    notional_ = 0.0;
+    long long volume_   = 0;
+};
+
+// Gaps between successive event times.
+class InterArrival {
+public:
+    void clear() { *this = InterArrival(); }
+    void add(double t) {
+        if (seen_) gaps_.add(t - last_);
+        last_ = t;
+        seen_ = true;
+    }
+    const Moments& gaps() const { return gaps_; }
+
+    // Coefficient of variation of the gaps: sample stddev / mean; 1 for
+    // Poisson arrivals, near 0 for a clock (TWAP slicing), above 1 for
+    // clustered ones.  0 with fewer than two gaps or a zero mean.
+    double cv() const {
+        if (gaps_.count() < 2 || gaps_.mean() <= 0.0) return 0.0;
+        return gaps_.stddev() / gaps_.mean();
+    }
+
+private:
+    Moments gaps_;
+    double  last_ = 0.0;
+    bool    seen_ = false;
+};
+
+// The P² algorithm (Jain & Chlamtac, 1985): a running estimate of the
+// p-quantile from five markers, moved by parabolic interpolation.
+// Exact for up to five points.
+class P2Quantile {
+public:
+    explicit P2Quantile(double p = 0.5) : p_(p) { clear(); }
+
+    void clear() {
+        n_ = 0;
+        const double dn[5] = {0.0, p_ / 2.0, p_, (1.0 + p_) / 2.0, 1.0};
+        for (int i = 0; i < 5; ++i) {
+            pos_[i]  = i + 1;
+            want_[i] = 1.0 + 4.0 * dn[i];
+            step_[i] = dn[i];
+        }
+    }
+
+    void add(double x) {
+        if (n_ < 5) {
+            height_[n_++] = x;
+            std::sort(height_, height_ + n_);
+            return;
+        }
+        ++n_;
+        int k;
+        if (x < height_[0]) {
+            height_[0] = x;
+            k = 0;
+        } else if (x >= height_[4]) {
+            height_[4] = std::max(height_[4], x);
+            k = 3;
+        } else {
+            k = 0;
+            while (x >= height_[k + 1]) ++k;
+        }
+        for (int i = k + 1; i < 5; ++i) ++pos_[i];
+        for (int i = 0; i < 5; ++i) want_[i] += step_[i];
+
+        for (int i = 1; i < 4; ++i) {
+            const double d = want_[i] - (double)pos_[i];
+            if ((d >= 1.0 && pos_[i + 1] - pos_[i] > 1) || (d <= -1.0 && pos_[i - 1] - pos_[i] < -1)) {
+                const int s = d > 0 ? 1 : -1;
+                double h = parabolic(i, s);
+                if (!(height_[i - 1] < h && h < height_[i + 1])) h = linear(i, s);
+                height_[i] = h;
+                pos_[i] += s;
+            }
+        }
+    }
+
+    long long count() const { return n_; }
+
+    double value() const {
+        if (n_ == 0) return 0.0;
+        if (n_ <= 5) {   // exact: nearest rank
+            const long long r = (long long)std::ceil(p_ * (double)n_);
+            return height_[std::max(1LL, r) - 1];
+        }
+        return height_[2];
+    }
+
+private:
+    double parabolic(int i, int s) const {
+        const double np = (double)pos_[i + 1], n = (double)pos_[i], nm = (double)pos_[i - 1];
+        return height_[i] + s / (np - nm) *
+               ((n - nm + s) * (height_[i + 1] - height_[i]) / (np - n) +
+                (np - n - s) * (height_[i] - height_[i - 1]) / (n - nm));
+    }
+    double linear(int i, int s) const {
+        return height_[i] + s * (height_[i + s] - height_[i]) / (double)(pos_[i + s] - pos_[i]);
+    }
+
+    double    p_;
+    long long n_;
+    double    height_[5];   // marker heights (the first n_ points, sorted, until there are 5)
+    long long pos_[5];      // marker positions, 1-based
+    double    want_[5];     // desired positions
+    double    step_[5];     // ... and their increment per point
+};
+
+// Counts of positive integers by power-of-two bucket: [1], [2,3],
+// [4,7], ...  Values past the last bucket are counted in it, values
+// below 1 in the first.
+template <int Buckets>
+class LogHistogram {
+public:
+    void clear() { *this = LogHistogram(); }
+
+    void add(long long v) {
+        const int b = v > 1 ? std::min(63 - __builtin_clzll((unsigned long long)v), Buckets - 1) : 0;
+        ++counts_[b];
+        ++total_;
+    }
+
+    long long total() const { return total_; }
+    long long count(int b) const { return counts_[b]; }
+
+    // Shannon entropy of the bucket shares, in bits: 0 when every value
+    // falls in one bucket, log2(Buckets) at most.
+    double entropy() const {
+        if (total_ == 0) return 0.0;
+        double h = 0.0;
+        for (long long c : counts_) {
+            if (c == 0) continue;
+            const double p = (double)c / (double)total_;
+            h -= p * std::log2(p);
+        }
+        return h;
+    }
+
+private:
+    long long counts_[Buckets] = {};
+    long long total_ = 0;
+};
+
+#endif
@@ -0,0 +1,164 @@
+// Book checkpoint sidecar (format described in book_index.h)
+#include "book_index.h"
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <unistd.h>
+
+static const char LOBIDX_MAGIC[8] = {'L', 'O', 'B', 'I', 'D', 'X', '1', '\0'};
+static constexpr uint32_t LOBIDX_VERSION = 1;
+
+struct BookIndexTrailer {
+    uint64_t path_hash;          // FNV-1a of the day file's absolute path
+    int64_t  size;
+    int64_t  mtime_ns;
+    uint64_t head_hash;
+    uint64_t tail_hash;
+    double   interval;
+    int64_t  msg_count;
+    double   close_mid;
+    uint64_t entries;
+    uint64_t table_offset;
+    uint32_t version;
+    uint32_t reserved;
+    char     magic[8];
+};
+
+static uint64_t path_hash(const std::string& path) {
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : path) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// ── Reader ──────────────────────────────────────────────────
+
+const BookCheckpoint* BookIndex::latest_before(double t) const {
+    const BookCheckpoint* best = nullptr;
+    for (const auto& c : checkpoints) {
+        if (c.time >= t) break;
+        best = &c;
+    }
+    return best;
+}
+
+bool BookIndex::read_book(const BookCheckpoint& c, std::vector<uint8_t>& out) const {
+    FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) return false;
+    out.resize(c.book_bytes);
+    bool ok = std::fseek(fp, (long)c.book_offset, SEEK_SET) == 0 &&
+              std::fread(out.data(), 1, out.size(), fp) == out.size();
+    std::fclose(fp);
+    return ok;
+}
+
+bool load_book_index(const std::string& day_file, const std::string& cache_dir, BookIndex& out) {
+    if (cache_dir == "off") return false;
+    DayFileKey key;
+    if (!day_file_key(day_file, key)) return false;
+
+    const std::string path = day_sidecar_path(key.path, cache_dir, ".lobidx");
+    FILE* fp = std::fopen(path.c_str(), "rb");
+    if (!fp) return false;
+
+    BookIndexTrailer tr;
+    char magic[8];
+    bool ok = std::fread(magic, sizeof(magic), 1, fp) == 1 &&
+              std::memcmp(magic, LOBIDX_MAGIC, sizeof(magic)) == 0 &&
+              std::fseek(fp, -(long)sizeof(tr), SEEK_END) == 0 &&
+              std::fread(&tr, sizeof(tr), 1, fp) == 1 &&
+              std::memcmp(tr.magic, LOBIDX_MAGIC, sizeof(tr.magic)) == 0 &&
+              tr.version == LOBIDX_VERSION &&
+              tr.path_hash == path_hash(key.path) &&
+              tr.size == key.size && tr.mtime_ns == key.mtime_ns &&
+              tr.head_hash == key.head_hash && tr.tail_hash == key.tail_hash;
+
+    std::vector<BookCheckpoint> entries;
+    if (ok) {
+        entries.resize(tr.entries);
+        ok = std::fseek(fp, (long)tr.table_offset, SEEK_SET) == 0 &&
+             std::fread(entries.data(), sizeof(BookCheckpoint), entries.size(), fp) == entries.size();
+    }
+    std::fclose(fp);
+    if (!ok) return false;
+
+    out.path = path;
+    out.interval = tr.interval;
+    out.msg_count = (long)tr.msg_count;
+    out.close_mid = tr.close_mid;
+    out.checkpoints = std::move(entries);
+    return true;
+}
+
+// ── Writer ──────────────────────────────────────────────────
+
+BookIndexWriter::BookIndexWriter(const std::string& day_file, const std::string& cache_dir,
+                                 double interval)
+    : interval_(interval), next_(interval) {
+    if (cache_dir == "off" || !(interval > 0.0) || !day_file_key(day_file, key_)) return;
+
+    static std::atomic<unsigned> seq{0};
+    target_ = day_sidecar_path(key_.path, cache_dir, ".lobidx");
+    tmp_ = target_ + ".tmp." + std::to_string(getpid()) + "." + std::to_string(seq.fetch_add(1));
+    fp_ = std::fopen(tmp_.c_str(), "wb");
+    if (fp_ && std::fwrite(LOBIDX_MAGIC, sizeof(LOBIDX_MAGIC), 1, fp_) != 1) {
+        std::fclose(fp_);
+        fp_ = nullptr;
+        std::remove(tmp_.c_str());
+    }
+    offset_ = sizeof(LOBIDX_MAGIC);
+}
+
+BookIndexWriter::~BookIndexWriter() {
+    if (fp_) {
+        std::fclose(fp_);
+        std::remove(tmp_.c_str());
+    }
+}
+
+void BookIndexWriter::add(BookCheckpoint c, const OrderBook& book) {
+    if (!fp_) return;
+    blob_.clear();
+    book.save_checkpoint(blob_);
+    c.book_offset = offset_;
+    c.book_bytes  = blob_.size();
+    if (std::fwrite(blob_.data(), 1, blob_.size(), fp_) != blob_.size()) {
+        std::fclose(fp_);
+        fp_ = nullptr;
+        std::remove(tmp_.c_str());
+        return;
+    }
+    offset_ += blob_.size();
+    entries_.push_back(c);
+    next_ = (std::floor(c.time / interval_) + 1.0) * interval_;
+}
+
+bool BookIndexWriter::finish(long msg_count, double close_mid) {
+    if (!fp_) return false;
+    BookIndexTrailer tr;
+    std::memset(&tr, 0, sizeof(tr));
+    tr.path_hash    = path_hash(key_.path);
+    tr.size         = key_.size;
+    tr.mtime_ns     = key_.mtime_ns;
+    tr.head_hash    = key_.head_hash;
+    tr.tail_hash    = key_.tail_hash;
+    tr.interval     = interval_;
+    tr.msg_count    = msg_count;
+    tr.close_mid    = close_mid;
+    tr.entries      = entries_.size();
+    tr.table_offset = offset_;
+    tr.version      = LOBIDX_VERSION;
+    std::memcpy(tr.magic, LOBIDX_MAGIC, sizeof(tr.magic));
+
+    bool ok = std::fwrite(entries_.data(), sizeof(BookCheckpoint), entries_.size(), fp_) == entries_.size() &&
+              std::fwrite(&tr, sizeof(tr), 1, fp_) == 1;
+    ok = (std::fclose(fp_) == 0) && ok;
+    fp_ = nullptr;
+    if (!ok || std::rename(tmp_.c_str(), target_.c_str()) != 0) {
+        std::remove(tmp_.c_str());
+        return false;
+    }
+    return true;
+}
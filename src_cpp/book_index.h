@@ -0,0 +1,103 @@
+#ifndef BOOK_INDEX_H
+#define BOOK_INDEX_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include "orderbook.h"
+#include "daysum.h"
+
+// ─────────────────────────────────────────────────────────────
+// Book index (".lobidx" sidecar): checkpoints for random access
+// ─────────────────────────────────────────────────────────────
+//
+// While a day file is replayed in full, a checkpoint can be taken
+// every `interval` seconds of message time: the complete OrderBook
+// (OrderBook::save_checkpoint), the parser position of the next row
+// (LobsterParser::tell), the row count so far and the last mid / BBO.
+// A later run restores the latest checkpoint before the part of the
+// day it needs, seeks the parser there and replays only from that
+// row on — an RTH window of 14:00–16:00 no longer replays from 04:00.
+//
+// The index also keeps the day's totals (rows, closing mid), so a
+// replay that has covered its last forward horizon can stop reading
+// instead of running on to the end of the file.
+//
+// File layout (little-endian, written by one process, read anywhere
+// with the same byte order):
+//
+//   "LOBIDX1\0"
+//   book blobs, back to back
+//   BookCheckpoint × n       entry table, ascending time
+//   trailer                  day file key, totals, n, table offset
+//
+// Location and keying follow the .daysum cache (daysum.h):
+// <dir>/<day file name>.lobidx, valid only for the exact day file it
+// was built from, published with a temp file + rename().
+// ─────────────────────────────────────────────────────────────
+
+struct BookCheckpoint {
+    double   time = 0.0;          // time of the last row applied
+    uint64_t position = 0;        // LobsterParser::tell() of the next row
+    uint64_t rows = 0;            // rows applied so far
+    double   mid = 0.0;           // last valid mid (0 = none yet) ...
+    double   mid_time = 0.0;      // ... and when it was set
+    double   bbo_time = 0.0;      // last two-sided BBO ($), time < 0 = none yet
+    double   bbo_bid = 0.0;
+    double   bbo_ask = 0.0;
+    uint64_t book_offset = 0;     // OrderBook blob within the sidecar
+    uint64_t book_bytes = 0;
+};
+
+struct BookIndex {
+    std::string path;             // the sidecar
+    double interval  = 0.0;       // seconds between checkpoints
+    long   msg_count = 0;         // rows in the whole day
+    double close_mid = 0.0;       // last mid of the day
+    std::vector<BookCheckpoint> checkpoints;
+
+    // Latest checkpoint taken strictly before time t, or nullptr.
+    const BookCheckpoint* latest_before(double t) const;
+
+    // Read back a checkpoint's OrderBook blob.
+    bool read_book(const BookCheckpoint& c, std::vector<uint8_t>& out) const;
+};
+
+// cache_dir as for load_day_summary: "" = next to the day file, "off"
+// = disabled.  False if there is no valid index for this exact file.
+bool load_book_index(const std::string& day_file, const std::string& cache_dir, BookIndex& out);
+
+// Builds the sidecar during one front-to-back replay of the day.
+class BookIndexWriter {
+public:
+    BookIndexWriter(const std::string& day_file, const std::string& cache_dir, double interval);
+    ~BookIndexWriter();             // an unfinished index is discarded
+
+    BookIndexWriter(const BookIndexWriter&) = delete;
+    BookIndexWriter& operator=(const BookIndexWriter&) = delete;
+
+    bool ok() const { return fp_ != nullptr; }
+
+    // A checkpoint is due once the replay has applied a row at time t.
+    bool due(double t) const { return fp_ && t >= next_; }
+
+    // Record `c` (book_offset / book_bytes are filled in) with `book`.
+    void add(BookCheckpoint c, const OrderBook& book);
+
+    // Write the entry table and totals and publish the sidecar.
+    // Best effort: false (silently) if it could not be written.
+    bool finish(long msg_count, double close_mid);
+
+private:
+    FILE*       fp_ = nullptr;
+    std::string target_, tmp_;
+    double      interval_;
+    double      next_ = 0.0;
+    uint64_t    offset_ = 0;
+    DayFileKey  key_;
+    std::vector<BookCheckpoint> entries_;
+    std::vector<uint8_t> blob_;
+};
+
+#endif
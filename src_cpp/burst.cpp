@@ -1,293 +1,96 @@
 #include "burst.h"
-#include <cmath>    // Required for std::abs, std::exp, std::sqrt
-#include <numeric>  // Required for std::accumulate
+#include <cmath>
 
-BurstDetector::BurstDetector(double silence_threshold, double min_volume_threshold, double direction_threshold,
-                             double volume_ratio_threshold,
-                             double hawkes_beta, double trigger_intensity) 
-    : silence_threshold_(silence_threshold), 
-    min_volume_threshold_(min_volume_threshold),
+BurstDetector::BurstDetector(const std::vector<DetectorConfig>& configs, double min_volume_threshold,
+                             double direction_threshold, double volume_ratio_threshold)
+    : bank_(configs, Trades(), BuySellFlow(), SizeProfile(), EventGaps()),
+      min_volume_threshold_(min_volume_threshold),
       direction_threshold_(direction_threshold),
-      volume_ratio_threshold_(volume_ratio_threshold),
-      hawkes_beta_(hawkes_beta),
-      trigger_intensity_(trigger_intensity),
-      use_hawkes_(hawkes_beta > 0.0),
-      hawkes_intensity_(0.0),
-      is_active_(false), 
-      last_msg_time_(0),
-      last_mid_price_(0),
-      round_lot_count_(0),
-      buy_count_(0),
-      sell_count_(0),
-      buy_volume_(0),
-      sell_volume_(0),
-      max_price_(0),
-      min_price_(0),
-      pending_preburst_cancel_rate_(0.0) {}
-
-
-// ── TERMINATION: when does a burst end? ─────────────────────
-bool BurstDetector::should_terminate(double time_gap) {
-    if (use_hawkes_) {
-        // Hawkes Process: decay the current intensity by the elapsed time gap.
-        // If the decayed intensity (before adding the new trade) drops below
-        // the trigger threshold, the burst has ended.
-        double decayed = hawkes_intensity_ * std::exp(-hawkes_beta_ * time_gap);
-        return decayed < trigger_intensity_;
-    }
-    // Legacy silence-based termination
-    return time_gap > silence_threshold_;
+      volume_ratio_threshold_(volume_ratio_threshold) {
+    finished_.reserve(configs.size());
 }
 
+
 // ── CLASSIFICATION: Hybrid count + volume check (Eq 2.3) ─────
-//
-// Two conditions must hold for a directional classification:
-//   1. Count-based:  buy_ratio >= direction_threshold_  (or sell)
-//   2. Volume-based: minority_volume < volume_ratio_threshold_ × majority_volume
-//
-// Condition 2 prevents cases like "9 buys of 10 shares + 1 sell of 1000 shares"
-// from being classified as a Buy burst.
-void BurstDetector::classify_direction() {
-    int total = buy_count_ + sell_count_;
-    if (total == 0) return;
-    
-    double buy_ratio = (double)buy_count_ / total;
-    double sell_ratio = (double)sell_count_ / total;
-    current_burst_.buy_count = buy_count_;
-    current_burst_.sell_count = sell_count_;
-    current_burst_.buy_volume = buy_volume_;
-    current_burst_.sell_volume = sell_volume_;
-    current_burst_.buy_ratio = buy_ratio;
-    current_burst_.sell_ratio = sell_ratio;
-    double major_vol = std::max((double)buy_volume_, (double)sell_volume_);
-    double minor_vol = std::min((double)buy_volume_, (double)sell_volume_);
-    current_burst_.minmax_vol_ratio = (major_vol > 0.0) ? (minor_vol / major_vol) : 1.0;
-    
-    if (buy_ratio >= direction_threshold_) {
-        // Count says Buy – verify volume doesn't contradict
-        double minority_vol = (double)sell_volume_;
-        double majority_vol = (double)buy_volume_;
-        if (majority_vol > 0 && minority_vol <= volume_ratio_threshold_ * majority_vol) {
-            current_burst_.direction = 1;   // Buy burst
-            current_burst_.peak_price = max_price_;
-        } else {
-            current_burst_.direction = 0;   // Counts say Buy, but volume is contradictory
-            double up_move = std::abs(max_price_ - current_burst_.start_price);
-            double down_move = std::abs(min_price_ - current_burst_.start_price);
-            current_burst_.peak_price = (up_move >= down_move) ? max_price_ : min_price_;
-        }
-    } else if (sell_ratio >= direction_threshold_) {
-        // Count says Sell – verify volume doesn't contradict
-        double minority_vol = (double)buy_volume_;
-        double majority_vol = (double)sell_volume_;
-        if (majority_vol > 0 && minority_vol <= volume_ratio_threshold_ * majority_vol) {
-            current_burst_.direction = -1;  // Sell burst
-            current_burst_.peak_price = min_price_;
-        } else {
-            current_burst_.direction = 0;   // Counts say Sell, but volume is contradictory
-            double up_move = std::abs(max_price_ - current_burst_.start_price);
-            double down_move = std::abs(min_price_ - current_burst_.start_price);
-            current_burst_.peak_price = (up_move >= down_move) ? max_price_ : min_price_;
-        }
-    } else {
-        current_burst_.direction = 0;   // Mixed
-        // Use std::abs for safer distance calculation
-        double up_move = std::abs(max_price_ - current_burst_.start_price);
-        double down_move = std::abs(min_price_ - current_burst_.start_price);
-        current_burst_.peak_price = (up_move >= down_move) ? max_price_ : min_price_;
-    }
+// See classify_sides (burst_engine.h): buyer-initiated trades are the
+// up side, so a Buy burst's peak is its highest mid.
+void BurstDetector::classify_direction(Burst& b, const BurstSpan& span, const SideCounts& t) const {
+    b.buy_count   = (int)t.up_count;
+    b.sell_count  = (int)t.down_count;
+    b.buy_volume  = (int)t.up_volume;
+    b.sell_volume = (int)t.down_volume;
+    if (b.buy_count + b.sell_count == 0) return;
+
+    const SideClass c = classify_sides(t, span, direction_threshold_, volume_ratio_threshold_);
+    b.direction        = c.direction;
+    b.buy_ratio        = c.up_ratio;
+    b.sell_ratio       = c.down_ratio;
+    b.minmax_vol_ratio = c.minmax_vol_ratio;
+    b.peak_price       = c.peak_price;
 }
 
 // ── PATH 1: Compute VWAP/TWAP Fingerprint metrics ──────────
-void BurstDetector::compute_fingerprint() {
-    int n = (int)trade_sizes_.size();
-    if (n <= 1) {
-        // Single-trade burst: variance is 0 by definition (no variation).
-        // This avoids N-1 divide-by-zero for sample variance.
-        current_burst_.trade_size_variance = 0.0;
-    } else {
-        // Sample variance: Var = Σ(x_i - mean)^2 / (N - 1)
-        double sum = 0.0;
-        for (int s : trade_sizes_) sum += (double)s;
-        double mean = sum / n;
-
-        double sq_sum = 0.0;
-        for (int s : trade_sizes_) {
-            double diff = (double)s - mean;
-            sq_sum += diff * diff;
-        }
-        current_burst_.trade_size_variance = sq_sum / (n - 1);
-    }
-
-    current_burst_.round_lot_pct = (n > 0) ? (double)round_lot_count_ / n : 0.0;
+// Single-trade burst: variance is 0 by definition (no variation).
+// An algorithm slicing a parent order trades evenly sized clips on a
+// clock: low variance, entropy and inter-trade CV.
+void BurstDetector::compute_fingerprint(Burst& b, const SizeStats& sizes, const GapStats& gaps) const {
+    b.trade_size_variance = sizes.variance;
+    b.round_lot_pct = (sizes.count > 0) ? (double)sizes.round_lots / (double)sizes.count : 0.0;
+    b.trade_size_skew     = sizes.skewness;
+    b.trade_size_entropy  = sizes.entropy;
+    b.inter_trade_cv      = gaps.cv;
 }
 
 // ── FILTER: is this burst worth keeping? ────────────────────
-bool BurstDetector::passes_filter() {
-    return (double)current_burst_.volume >= min_volume_threshold_;
+bool BurstDetector::passes_filter(const Burst& b) const {
+    return (double)b.volume >= min_volume_threshold_;
 }
 
 // ─────────────────────────────────────────────────────────────
 
-// ── SET PRE-BURST CANCEL RATE (called from main.cpp) ────────
-void BurstDetector::set_preburst_cancel_rate(double rate) {
-    pending_preburst_cancel_rate_ = rate;
+void BurstDetector::close_burst(size_t k, const BurstSpan& span, const SideCounts& sides,
+                                const SizeStats& sizes, const GapStats& gaps) {
+    Burst b{};
+    b.id          = span.id;
+    b.config      = (int)k;
+    b.start_time  = span.start_time;
+    b.end_time    = span.end_time;
+    b.start_price = span.start_price;
+    b.end_price   = span.end_price;
+    b.volume      = (int)sides.volume;
+    b.trade_count = (int)(sides.up_count + sides.down_count);
+    b.minmax_vol_ratio      = 1.0;
+    b.hawkes_peak_intensity = span.peak_intensity;
+    // Path 3: main.cpp fills in the pre-burst cancel rate at close
+    b.preburst_cancel_rate  = 0.0;
+
+    classify_direction(b, span, sides);
+    compute_fingerprint(b, sizes, gaps);
+    if (passes_filter(b)) finished_.push_back(b);
 }
 
-// ── FLUSH: finalize active burst at end of day ──────────────
-bool BurstDetector::flush(Burst& result) {
-    if (!is_active_) return false;
-
-    current_burst_.end_time = last_msg_time_;
-    current_burst_.end_price = last_mid_price_;
-    current_burst_.trade_count = buy_count_ + sell_count_;
-    classify_direction();
-    compute_fingerprint();
-
-    is_active_ = false;
+void BurstDetector::process(const LobsterMessage& msg, double current_mid) {
+    finished_.clear();
+    bank_.process(msg, BurstQuote{current_mid, 0, 0},
+                  [this](size_t k, const BurstSpan& span, const SideCounts& sides, const SizeStats& sizes,
+                         const GapStats& gaps) { close_burst(k, span, sides, sizes, gaps); });
+}
 
-    if (passes_filter()) {
-        result = current_burst_;
-        return true;
-    }
-    return false;
+// ── FLUSH: finalize active bursts at end of day ─────────────
+void BurstDetector::flush() {
+    finished_.clear();
+    bank_.flush([this](size_t k, const BurstSpan& span, const SideCounts& sides, const SizeStats& sizes,
+                       const GapStats& gaps) { close_burst(k, span, sides, sizes, gaps); });
 }
 
 // ── RESET: clear all state for next day ─────────────────────
 void BurstDetector::reset() {
-    is_active_ = false;
-    last_msg_time_ = 0;
-    last_mid_price_ = 0;
-    buy_count_ = 0;
-    sell_count_ = 0;
-    buy_volume_ = 0;
-    sell_volume_ = 0;
-    max_price_ = 0;
-    min_price_ = 0;
-    current_burst_ = {};
-    trade_sizes_.clear();
-    round_lot_count_ = 0;
-    hawkes_intensity_ = 0.0;
-    pending_preburst_cancel_rate_ = 0.0;
+    bank_.reset();
+    finished_.clear();
 }
 
-bool BurstDetector::process(const LobsterMessage& msg, double current_mid, Burst& result) {
-    // 1. Check if this is a trade (Execution or Hidden Execution)
-    bool is_trade = (msg.type == 4 || msg.type == 5);
-
-    // 2. IF NOT A TRADE:
-    // We just update the price tracker so 'start_price' will be fresh 
-    // when the next trade finally happens. Then we return false.
-    if (!is_trade) {
-        last_mid_price_ = current_mid; 
-        return false;
-    }
-
-    // ─────────────────────────────────────────────────────────────
-    // FROM HERE DOWN, WE KNOW IT IS A TRADE
-    // ─────────────────────────────────────────────────────────────
-
-    bool burst_finished = false;
-
-    if (is_active_) {
-        // Calculate gap from the LAST TRADE time (not last message time)
-        double time_gap = msg.time - last_msg_time_;
-
-        if (should_terminate(time_gap)) {
-            // 1. Finalize the burst stats
-            current_burst_.end_time = last_msg_time_;
-            current_burst_.end_price = last_mid_price_;
-            current_burst_.trade_count = buy_count_ + sell_count_;
-            
-            // 2. Classify direction & compute fingerprint
-            classify_direction();
-            compute_fingerprint();
-
-            // 3. Filter and Emit
-            if (passes_filter()) {
-                result = current_burst_;
-                burst_finished = true;
-            }
-            
-            // 4. Reset Active State
-            is_active_ = false;
-        } else if (use_hawkes_) {
-            // Hawkes: burst survives — decay and add this trade's contribution
-            double time_gap_h = msg.time - last_msg_time_;
-            hawkes_intensity_ = hawkes_intensity_ * std::exp(-hawkes_beta_ * time_gap_h) + 1.0;
-            current_burst_.hawkes_peak_intensity = std::max(
-                current_burst_.hawkes_peak_intensity, hawkes_intensity_);
-        }
-    }
-
-    // Start new burst if not active
-    if (!is_active_) {
-        is_active_ = true;
-        current_burst_.id = msg.order_id;
-        current_burst_.start_time = msg.time;
-        current_burst_.direction = 0;
-        current_burst_.volume = 0;
-        current_burst_.trade_count = 0;
-        current_burst_.buy_count = 0;
-        current_burst_.sell_count = 0;
-        current_burst_.buy_volume = 0;
-        current_burst_.sell_volume = 0;
-        current_burst_.buy_ratio = 0.0;
-        current_burst_.sell_ratio = 0.0;
-        current_burst_.minmax_vol_ratio = 1.0;
-        
-        // Path 1: reset fingerprint state
-        current_burst_.trade_size_variance = 0.0;
-        current_burst_.round_lot_pct = 0.0;
-        trade_sizes_.clear();
-        round_lot_count_ = 0;
-
-        // Path 2: reset Hawkes intensity — first trade seeds at 1.0
-        hawkes_intensity_ = 1.0;
-        current_burst_.hawkes_peak_intensity = 1.0;
-
-        // Path 3: capture the pre-burst cancel rate computed by main.cpp
-        current_burst_.preburst_cancel_rate = pending_preburst_cancel_rate_;
-        
-        // last_mid_price_ is now the price from the most recent message 
-        // (even if it was a quote update 1ms ago), so this is accurate.
-        current_burst_.start_price = (last_mid_price_ > 0) ? last_mid_price_ : current_mid;
-        
-        buy_count_ = 0;
-        sell_count_ = 0;
-        buy_volume_ = 0;
-        sell_volume_ = 0;
-        
-        // Initialize extremes to include both start_price and current_mid
-        max_price_ = std::max(current_burst_.start_price, current_mid);
-        min_price_ = std::min(current_burst_.start_price, current_mid);
-    }
-
-    // Accumulate Current Trade
-    current_burst_.volume += msg.size;
-
-    // Path 1: track individual trade sizes for variance calculation
-    trade_sizes_.push_back(msg.size);
-    if (msg.size % 100 == 0) {
-        round_lot_count_++;
-    }
-    
-    // LOBSTER Direction: -1 = Buyer-initiated, 1 = Seller-initiated
-    if (msg.direction == -1) {
-        buy_count_++;
-        buy_volume_ += msg.size;
-    } else {
-        sell_count_++;
-        sell_volume_ += msg.size;
-    }
-    
-    // Track extremes
-    max_price_ = std::max(max_price_, current_mid);
-    min_price_ = std::min(min_price_, current_mid);
-    
-    // Update trackers for the NEXT loop iteration
-    last_msg_time_ = msg.time;      // Only update time on trades (to measure trade silence)
-    last_mid_price_ = current_mid;  // Always update price
-
-    return burst_finished;
-}
\ No newline at end of file
+double BurstDetector::earliest_start() const {
+    double t = bank_.earliest_open_start();
+    for (const Burst& b : finished_) t = std::min(t, b.start_time);
+    return t;
+}
@@ -2,12 +2,18 @@
 #define BURST_H
 
 #include "types.h"
+#include "burst_engine.h"
 #include <cmath>
 #include <algorithm>
+#include <limits>
+#include <string>
 #include <vector>
+#include <cstdint>
+#include <cstdlib>
 
 struct Burst {
     long id;            // The ID of the FIRST order in the burst
+    int config;         // Detector configuration that found it (index into the -G grid; 0 without one)
     double start_time;
     double end_time;
     int direction;      // 1=Buy, -1=Sell, 0=Mixed (didn't meet direction threshold)
@@ -27,90 +33,160 @@ struct Burst {
     // ── Path 1: VWAP/TWAP Fingerprinting ──────────────────────
     double trade_size_variance;   // Variance of individual trade sizes within burst
     double round_lot_pct;         // Fraction of trades that are multiples of 100 shares
+    double trade_size_skew;       // Skewness (g1) of the trade sizes
+    double trade_size_entropy;    // Entropy (bits) of the trade sizes over power-of-two buckets
+    double inter_trade_cv;        // CV of the gaps between trades (0 = clockwork, 1 = Poisson)
 
     // ── Path 2: Hawkes Process ────────────────────────────────
     double hawkes_peak_intensity; // Maximum intensity score reached during burst
 
     // ── Path 3: Pre-Burst Quote Depletion ─────────────────────
-    double preburst_cancel_rate;  // Cancellation rate on opposing side in pre-burst window
+    double preburst_cancel_rate;  // Cancellation rate on opposing side in pre-burst window (set by main.cpp)
 };
 
+// ─────────────────────────────────────────────────────────────
+// Detector configurations (-s / -H / -I, or a -G grid)
+// ─────────────────────────────────────────────────────────────
+//
+// What ends a burst is a DetectorConfig (burst_engine.h): a Hawkes
+// intensity falling below its trigger, or a trade gap longer than the
+// silence threshold.  -G runs a grid of them over one replay, e.g.
+//
+//     -G "beta=0.5,1,2 I=0.3,0.5,0.8"      9 configurations
+//     -G "beta=0 s=0.5,1,2"                3 silence thresholds
+//
+// Axes are beta (or H), I and s, separated by spaces or ';'; an axis
+// left out takes the -H / -I / -s value.  Configurations are numbered
+// in grid order, beta slowest.  Points that detect alike (s under
+// Hawkes, I under silence) are kept once.
+// ─────────────────────────────────────────────────────────────
+
+constexpr int MAX_DETECTOR_CONFIGS = 64;
+
+// "beta=0.5,1 I=0.3" → the grid's distinct configurations; `base`
+// fills the axes not given.  *points gets the grid's size before
+// duplicates are dropped.  Empty if malformed or larger than
+// MAX_DETECTOR_CONFIGS.
+inline std::vector<DetectorConfig> parse_detector_grid(const std::string& spec, const DetectorConfig& base,
+                                                       size_t* points = nullptr) {
+    std::vector<double> beta = {base.hawkes_beta}, intensity = {base.trigger_intensity},
+                        silence = {base.silence_threshold};
+    bool seen[3] = {false, false, false};
+    const char* p = spec.c_str();
+    for (;;) {
+        while (*p == ' ' || *p == ';') ++p;
+        if (!*p) break;
+        const char* eq = p;
+        while (*eq && *eq != '=' && *eq != ' ' && *eq != ';') ++eq;
+        if (*eq != '=') return {};
+        const std::string axis(p, eq);
+        const int a = (axis == "beta" || axis == "H") ? 0 : (axis == "I") ? 1 : (axis == "s") ? 2 : -1;
+        if (a < 0 || seen[a]) return {};
+        seen[a] = true;
+        std::vector<double>& list = (a == 0) ? beta : (a == 1) ? intensity : silence;
+        list.clear();
+        p = eq + 1;
+        for (;;) {
+            char* end = nullptr;
+            const double v = std::strtod(p, &end);
+            if (end == p || !std::isfinite(v) || v < 0.0) return {};
+            list.push_back(v);
+            p = end;
+            if (*p != ',') break;
+            ++p;
+        }
+        if (*p && *p != ' ' && *p != ';') return {};
+    }
+    const size_t n = beta.size() * intensity.size() * silence.size();
+    if (points) *points = n;
+    if (n > (size_t)MAX_DETECTOR_CONFIGS) return {};
+
+    std::vector<DetectorConfig> grid;
+    for (double b : beta)
+        for (double i : intensity)
+            for (double s : silence) {
+                const DetectorConfig c{s, b, i};
+                if (std::none_of(grid.begin(), grid.end(),
+                                 [&](const DetectorConfig& g) { return g.same_detector(c); }))
+                    grid.push_back(c);
+            }
+    return grid;
+}
+
+// ─────────────────────────────────────────────────────────────
+// BurstDetector: a bank of trade detectors (BurstEngine)
+// ─────────────────────────────────────────────────────────────
+//
+// Trades excite; the features are buy/sell flow, trade sizes and the
+// gaps between trades.
+// Every configuration sees the same trades, so one replay serves a
+// whole -G grid; without one the bank has a single configuration.
+// ─────────────────────────────────────────────────────────────
+
 class BurstDetector {
 public:
-    // silence_threshold: time gap (seconds) that ends a burst (legacy mode)
     // min_volume_threshold: minimum total volume for a burst to be output
     // direction_threshold: ratio (e.g., 0.7) of buy/total or sell/total to classify direction
     // volume_ratio_threshold: max minority_vol / majority_vol ratio (e.g., 0.5) for directional bursts
-    // hawkes_beta: exponential decay rate for Hawkes intensity (0 = disable Hawkes, use silence)
-    // trigger_intensity: burst stays active while intensity >= this threshold
-    BurstDetector(double silence_threshold, double min_volume_threshold, double direction_threshold,
-                  double volume_ratio_threshold = 0.5,
-                  double hawkes_beta = 0.0, double trigger_intensity = 0.5);
-    
-    // Returns true if a burst just finished (and passed filters)
-    // If true, 'result' will contain that finished burst data
-    bool process(const LobsterMessage& msg, double current_mid, Burst& result);
-
-    // Set the pre-burst cancellation rate for the NEXT burst that starts.
-    // Called from main.cpp which has access to order book cancel history.
-    void set_preburst_cancel_rate(double rate);
-
-    // Finalize any active burst (call at end of each trading day).
-    // Returns true if an active burst was emitted into 'result'.
-    bool flush(Burst& result);
+    BurstDetector(const std::vector<DetectorConfig>& configs, double min_volume_threshold,
+                  double direction_threshold, double volume_ratio_threshold = 0.5);
+
+    size_t configs() const { return bank_.configs(); }
+    const DetectorConfig& config(size_t k) const { return bank_.config(k); }
+
+    // Feed one row.  The bursts it finished that passed the filter are
+    // in finished() until the next call, and the configurations that
+    // started a burst on it in started() — main.cpp takes the pre-burst
+    // cancels then.  A burst start clears everything but the last mid,
+    // so two detectors that both start one on the same trade agree from
+    // there on (see the intra-day chunks in main.cpp).
+    void process(const LobsterMessage& msg, double current_mid);
+
+    // Finalize every open burst into finished() (call at end of each
+    // trading day).
+    void flush();
 
     // Reset all state for a new trading day.
     void reset();
 
+    const std::vector<Burst>&    finished() const { return finished_; }
+    const std::vector<uint32_t>& started()  const { return bank_.started(); }
+
+    // Earliest start of a burst that is open or in finished(): MarketState
+    // queries for this row and later ones go no further back.
+    double earliest_start() const;
+
+    // Burst volume floor (the constructor's min_volume_threshold).
+    void set_min_volume(double min_volume_threshold) { min_volume_threshold_ = min_volume_threshold; }
+
 private:
+    // LOBSTER Direction of executions: -1 = Buyer-initiated, 1 = Seller-initiated
+    using BuySellFlow = SideFlow<-1>;
+
     // ── CHANGE THESE TO CHANGE BEHAVIOR ──────────────────────
-    
-    // Should the current burst end? Hawkes or silence-based.
-    bool should_terminate(double time_gap);
-    
-    // Set direction & peak_price on current_burst_. Currently: buy/sell ratio.
-    void classify_direction();
-
-    // Compute Path 1 fingerprint metrics on current_burst_.
-    void compute_fingerprint();
-    
+
+    // Build configuration k's finished burst; into finished() if it
+    // passes the filter.
+    void close_burst(size_t k, const BurstSpan& span, const SideCounts& sides, const SizeStats& sizes,
+                     const GapStats& gaps);
+
+    // Set direction & peak_price on b. Currently: buy/sell ratio.
+    void classify_direction(Burst& b, const BurstSpan& span, const SideCounts& sides) const;
+
+    // Compute Path 1 fingerprint metrics on b.
+    void compute_fingerprint(Burst& b, const SizeStats& sizes, const GapStats& gaps) const;
+
     // Is the finished burst worth keeping? Currently: minimum volume.
-    bool passes_filter();
-    
+    bool passes_filter(const Burst& b) const;
+
     // ─────────────────────────────────────────────────────────
-    
-    double silence_threshold_;
+
+    BurstBank<Trades, BuySellFlow, SizeProfile, EventGaps> bank_;
     double min_volume_threshold_;
     double direction_threshold_;
     double volume_ratio_threshold_;
 
-    // ── Path 2: Hawkes Process state ─────────────────────────
-    double hawkes_beta_;           // Exponential decay rate (0 = legacy silence mode)
-    double trigger_intensity_;     // Burst stays active above this threshold
-    bool   use_hawkes_;            // true = Hawkes mode, false = legacy silence mode
-    double hawkes_intensity_;      // Current rolling intensity score
-    
-    bool is_active_;
-    Burst current_burst_;
-    double last_msg_time_;
-    double last_mid_price_; 
-
-    // ── Path 1: Trade size tracking within burst ─────────────
-    std::vector<int> trade_sizes_; // Individual trade sizes for variance calc
-    int round_lot_count_;          // Count of 100-share multiples
-    
-    // Track buy/sell counts and volumes to determine direction at burst end
-    int buy_count_;
-    int sell_count_;
-    int buy_volume_;
-    int sell_volume_;
-    
-    // Track both max and min since direction is unknown until end
-    double max_price_;
-    double min_price_;
-
-    // ── Path 3: Pre-burst cancel rate (set externally) ───────
-    double pending_preburst_cancel_rate_;  // Buffered value for the next burst start
+    std::vector<Burst> finished_;
 };
 
-#endif
\ No newline at end of file
+#endif
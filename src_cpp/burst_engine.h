@@ -0,0 +1,617 @@
+#ifndef BURST_ENGINE_H
+#define BURST_ENGINE_H
+
+#include "types.h"
+#include "rolling.h"
+#include "accumulators.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <tuple>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// ─────────────────────────────────────────────────────────────
+// BurstEngine: the detector loop both drivers share
+// ─────────────────────────────────────────────────────────────
+//
+// A burst is a run of exciting events (trades for data_processor,
+// submissions near the BBO for passive_data_processor) that ends when
+// the gap to the next one is too long.  What differs between the
+// detectors is compile-time policy:
+//
+//   Excitation    which rows are events: Trades, HiddenExecutions,
+//                 NearBboSubmissions
+//   Termination   what gap ends a burst: HawkesTermination (intensity
+//                 decayed below the trigger), SilenceTermination (gap
+//                 over the silence threshold)
+//   Features...   what a burst accumulates: SideFlow, SizeProfile,
+//                 EventGaps, NearBboCancels
+//
+// so an instantiation's event loop has no mode tests left in it.
+//
+// One engine runs a set of configurations ("slots") of its
+// Termination over the same events; a slot's own state is its open
+// burst's start, price extremes and termination state, kept
+// structure-of-arrays.  A Feature either keeps running totals of the
+// day's events shared by all slots, a burst's value being the totals
+// now less those at its start, or folds each event into every slot's
+// own accumulators; either way nothing is stored per event, so a
+// burst never allocates.  BurstBank puts a Hawkes and a silence
+// engine side by side for a list of DetectorConfigs.
+//
+// A Feature provides:
+//
+//   add()                 one more slot
+//   clear()               new day
+//   observe(msg, quote)   a row that is not an event
+//   open(k)               slot k's burst starts with this event
+//   count(msg)            an event, after its bursts closed and opened
+//   since(k)              slot k's open burst: a Value
+// ─────────────────────────────────────────────────────────────
+
+// Detector configuration (-s / -H / -I, or a -G point): a Hawkes
+// intensity (decay hawkes_beta > 0) falling below trigger_intensity
+// ends a burst, or with hawkes_beta = 0 a gap longer than
+// silence_threshold.
+struct DetectorConfig {
+    double silence_threshold;
+    double hawkes_beta;         // 0 = silence mode
+    double trigger_intensity;
+
+    bool hawkes() const { return hawkes_beta > 0.0; }
+
+    // Same bursts from the same rows.
+    bool same_detector(const DetectorConfig& o) const {
+        if (hawkes() != o.hawkes()) return false;
+        return hawkes() ? hawkes_beta == o.hawkes_beta && trigger_intensity == o.trigger_intensity
+                        : silence_threshold == o.silence_threshold;
+    }
+};
+
+// The book after a row, as the policies see it.
+struct BurstQuote {
+    double mid;
+    int    best_bid;   // 0 where the driver does not track them
+    int    best_ask;
+};
+
+// What the engine itself knows of a closing burst.
+struct BurstSpan {
+    long   id;              // order ID of its first event
+    double start_time;
+    double end_time;        // its last event
+    double start_price;     // mid before its first event
+    double end_price;       // mid before the event that ended it
+    double max_price;       // mid extremes over its events
+    double min_price;
+    double peak_intensity;  // Hawkes peak (1 under silence)
+};
+
+// Within `levels` ticks of the BBO on the row's side, inside the spread
+// included.  LOBSTER prices are $×10000, so a $0.01 tick is 100.
+inline bool near_bbo(const LobsterMessage& msg, const BurstQuote& q, int levels) {
+    if (q.best_bid <= 0 || q.best_ask <= 0) return false;
+    constexpr int tick_size = 100;
+    if (msg.direction == 1)   // bid side
+        return msg.price >= q.best_bid - levels * tick_size && msg.price <= q.best_ask;
+    return msg.price <= q.best_ask + levels * tick_size && msg.price >= q.best_bid;
+}
+
+// ── Excitation ───────────────────────────────────────────────
+
+// Executions of visible and hidden orders (types 4, 5).
+struct Trades {
+    bool excites(const LobsterMessage& msg, const BurstQuote&) const {
+        return msg.type == 4 || msg.type == 5;
+    }
+};
+
+// Executions of hidden orders only (type 5).
+struct HiddenExecutions {
+    bool excites(const LobsterMessage& msg, const BurstQuote&) const { return msg.type == 5; }
+};
+
+// Limit order submissions (type 1) within `levels` of the BBO.
+struct NearBboSubmissions {
+    int levels = 3;
+    bool excites(const LobsterMessage& msg, const BurstQuote& q) const {
+        return msg.type == 1 && near_bbo(msg, q, levels);
+    }
+};
+
+// ── Termination ──────────────────────────────────────────────
+//
+// end(gap, ends) marks the slots whose burst the gap since the last
+// event ends and returns how many; excite() then adds the event to
+// every slot (the ended ones are open()ed again right after).
+
+// Hawkes intensity: decays at beta, +1 per event; the burst ends when
+// the decayed intensity (before adding this event) is below the
+// trigger.  exp() is taken once per distinct beta.
+class HawkesTermination {
+public:
+    void add(const DetectorConfig& c) {
+        auto it = std::find(betas_.begin(), betas_.end(), c.hawkes_beta);
+        beta_slot_.push_back((uint32_t)(it - betas_.begin()));
+        if (it == betas_.end()) betas_.push_back(c.hawkes_beta);
+        trigger_.push_back(c.trigger_intensity);
+        decay_.resize(betas_.size());
+        intensity_.push_back(0.0);
+        decayed_.push_back(0.0);
+        peak_.push_back(0.0);
+    }
+
+    size_t end(double gap, uint8_t* ends) {
+        for (size_t b = 0; b < betas_.size(); ++b) decay_[b] = std::exp(-betas_[b] * gap);
+        size_t ended = 0;
+        for (size_t k = 0; k < trigger_.size(); ++k) {
+            decayed_[k] = intensity_[k] * decay_[beta_slot_[k]];
+            ends[k] = decayed_[k] < trigger_[k];
+            ended += ends[k];
+        }
+        return ended;
+    }
+
+    void excite() {
+        for (size_t k = 0; k < trigger_.size(); ++k) {
+            intensity_[k] = decayed_[k] + 1.0;
+            peak_[k] = std::max(peak_[k], intensity_[k]);
+        }
+    }
+
+    // The first event seeds the intensity at 1.
+    void open(size_t k) { intensity_[k] = 1.0; peak_[k] = 1.0; }
+
+    double peak(size_t k) const { return peak_[k]; }
+
+private:
+    std::vector<double>   betas_;       // distinct decay rates
+    std::vector<double>   decay_;       // ... and their factor for this gap
+    std::vector<uint32_t> beta_slot_;   // per slot: index into betas_
+    std::vector<double>   trigger_;
+    std::vector<double>   intensity_;
+    std::vector<double>   decayed_;     // intensity before this event
+    std::vector<double>   peak_;
+};
+
+// Trade silence: the burst ends on a gap over the threshold.
+class SilenceTermination {
+public:
+    void add(const DetectorConfig& c) { silence_.push_back(c.silence_threshold); }
+
+    size_t end(double gap, uint8_t* ends) {
+        size_t ended = 0;
+        for (size_t k = 0; k < silence_.size(); ++k) {
+            ends[k] = gap > silence_[k];
+            ended += ends[k];
+        }
+        return ended;
+    }
+
+    void excite() {}
+    void open(size_t) {}
+    double peak(size_t) const { return 1.0; }
+
+private:
+    std::vector<double> silence_;
+};
+
+// ── Features ─────────────────────────────────────────────────
+
+// Event counts and volumes by side.  `Up` is the LOBSTER direction
+// that pushes the price up: -1 for executions (buyer-initiated), 1 for
+// submissions (bid).
+struct SideCounts {
+    long long volume      = 0;
+    long long up_count    = 0;
+    long long down_count  = 0;
+    long long up_volume   = 0;
+    long long down_volume = 0;
+    SideCounts operator-(const SideCounts& o) const {
+        return {volume - o.volume, up_count - o.up_count, down_count - o.down_count,
+                up_volume - o.up_volume, down_volume - o.down_volume};
+    }
+};
+
+template <int Up>
+class SideFlow {
+public:
+    using Value = SideCounts;
+
+    void add() { start_.emplace_back(); }
+    void clear() { total_ = SideCounts(); }
+    void observe(const LobsterMessage&, const BurstQuote&) {}
+    void open(size_t k) { start_[k] = total_; }
+    void count(const LobsterMessage& msg) {
+        total_.volume += msg.size;
+        if (msg.direction == Up) {
+            total_.up_count++;
+            total_.up_volume += msg.size;
+        } else {
+            total_.down_count++;
+            total_.down_volume += msg.size;
+        }
+    }
+    Value since(size_t k) const { return total_ - start_[k]; }
+
+private:
+    SideCounts total_;
+    std::vector<SideCounts> start_;
+};
+
+// Event sizes, folded into each open burst's accumulators
+// (accumulators.h) as they come: nothing is kept per event.
+struct SizeStats {
+    long long count      = 0;
+    long long round_lots = 0;     // multiples of 100 shares
+    double    variance   = 0.0;   // sample; 0 for fewer than two events
+    double    skewness   = 0.0;   // g1; 0 if all sizes are equal
+    double    entropy    = 0.0;   // bits, over power-of-two size buckets
+};
+
+class SizeProfile {
+public:
+    using Value = SizeStats;
+
+    void add() { slots_.emplace_back(); }
+    void clear() {}
+    void observe(const LobsterMessage&, const BurstQuote&) {}
+    void open(size_t k) { slots_[k] = Slot(); }
+    void count(const LobsterMessage& msg) {
+        const bool round_lot = msg.size % 100 == 0;
+        for (Slot& s : slots_) {
+            s.moments.add((double)msg.size);
+            s.buckets.add(msg.size);
+            s.round_lots += round_lot;
+        }
+    }
+
+    Value since(size_t k) const {
+        const Slot& s = slots_[k];
+        SizeStats v;
+        v.count      = s.moments.count();
+        v.round_lots = s.round_lots;
+        v.variance   = s.moments.variance();
+        v.skewness   = s.moments.skewness();
+        v.entropy    = s.buckets.entropy();
+        return v;
+    }
+
+private:
+    struct Slot {
+        Moments          moments;
+        LogHistogram<24> buckets;   // 1 .. 2^23 shares
+        long long        round_lots = 0;
+    };
+    std::vector<Slot> slots_;
+};
+
+// Gaps between a burst's events: their coefficient of variation tells
+// a clock (TWAP slicing, near 0) from Poisson flow (1) and clustering.
+struct GapStats {
+    long long gaps = 0;
+    double    mean = 0.0;   // seconds
+    double    cv   = 0.0;   // 0 for fewer than two gaps
+};
+
+class EventGaps {
+public:
+    using Value = GapStats;
+
+    void add() { slots_.emplace_back(); }
+    void clear() {}
+    void observe(const LobsterMessage&, const BurstQuote&) {}
+    void open(size_t k) { slots_[k].clear(); }
+    void count(const LobsterMessage& msg) {
+        for (InterArrival& s : slots_) s.add(msg.time);
+    }
+    Value since(size_t k) const {
+        const InterArrival& s = slots_[k];
+        return {s.gaps().count(), s.gaps().mean(), s.cv()};
+    }
+
+private:
+    std::vector<InterArrival> slots_;
+};
+
+// Cancels and deletions (types 2, 3) within `levels` of the BBO, by
+// side, while the burst is open.  Features, not events.
+class NearBboCancels {
+public:
+    using Value = CancelTotals;
+
+    explicit NearBboCancels(int levels = 3) : levels_(levels) {}
+
+    void add() { start_.emplace_back(); }
+    void clear() { total_ = CancelTotals(); }
+    void observe(const LobsterMessage& msg, const BurstQuote& q) {
+        if ((msg.type != 2 && msg.type != 3) || !near_bbo(msg, q, levels_)) return;
+        if (msg.direction == 1) {
+            total_.bid_count++;
+            total_.bid_volume += msg.size;
+        } else {
+            total_.ask_count++;
+            total_.ask_volume += msg.size;
+        }
+    }
+    void open(size_t k) { start_[k] = total_; }
+    void count(const LobsterMessage&) {}
+    Value since(size_t k) const { return total_ - start_[k]; }
+
+private:
+    int levels_;
+    CancelTotals total_;
+    std::vector<CancelTotals> start_;
+};
+
+// ── Direction ────────────────────────────────────────────────
+
+struct SideClass {
+    int    direction;          // 1 = up, -1 = down, 0 = mixed
+    double up_ratio;           // up_count / events
+    double down_ratio;
+    double minmax_vol_ratio;   // min(up, down volume) / max(...)
+    double peak_price;         // extreme of the burst's mids in its direction
+};
+
+// Hybrid count + volume check (Eq 2.3).  Two conditions must hold for
+// a directional classification:
+//   1. Count-based:  up_ratio >= direction_threshold  (or down)
+//   2. Volume-based: minority_volume <= volume_ratio_threshold × majority_volume
+//
+// Condition 2 prevents cases like "9 buys of 10 shares + 1 sell of 1000
+// shares" from being classified as a Buy burst.  A burst that fails
+// either takes whichever extreme is further from its start price.
+inline SideClass classify_sides(const SideCounts& t, const BurstSpan& s,
+                                double direction_threshold, double volume_ratio_threshold) {
+    SideClass c{0, 0.0, 0.0, 1.0, 0.0};
+    const int up_count = (int)t.up_count, down_count = (int)t.down_count;
+    const int total = up_count + down_count;
+    if (total == 0) return c;
+
+    const double up_volume = (double)(int)t.up_volume, down_volume = (double)(int)t.down_volume;
+    c.up_ratio   = (double)up_count / total;
+    c.down_ratio = (double)down_count / total;
+    const double major_vol = std::max(up_volume, down_volume);
+    const double minor_vol = std::min(up_volume, down_volume);
+    c.minmax_vol_ratio = (major_vol > 0.0) ? (minor_vol / major_vol) : 1.0;
+
+    if (c.up_ratio >= direction_threshold) {
+        if (up_volume > 0 && down_volume <= volume_ratio_threshold * up_volume) {
+            c.direction  = 1;
+            c.peak_price = s.max_price;
+            return c;
+        }
+    } else if (c.down_ratio >= direction_threshold) {
+        if (down_volume > 0 && up_volume <= volume_ratio_threshold * down_volume) {
+            c.direction  = -1;
+            c.peak_price = s.min_price;
+            return c;
+        }
+    }
+    // Mixed, or counts contradicted by volume
+    const double up_move   = std::abs(s.max_price - s.start_price);
+    const double down_move = std::abs(s.min_price - s.start_price);
+    c.peak_price = (up_move >= down_move) ? s.max_price : s.min_price;
+    return c;
+}
+
+// ─────────────────────────────────────────────────────────────
+
+template <class Excitation, class Termination, class... Features>
+class BurstEngine {
+public:
+    explicit BurstEngine(Excitation excitation, Features... features)
+        : excitation_(excitation), features_(features...) {}
+
+    // One more configuration; its slot is the next index.
+    void add(const DetectorConfig& c) {
+        termination_.add(c);
+        each([](auto& f) { f.add(); });
+        id_.push_back(0);
+        start_time_.push_back(0.0);
+        start_price_.push_back(0.0);
+        price_.emplace_back();
+        ends_.push_back(0);
+        started_.reserve(id_.size());
+    }
+
+    size_t slots() const { return id_.size(); }
+
+    // Feed one row.  close(k, span, values...) is called for each slot
+    // whose burst the row ends, with every Feature's since(k) in
+    // template order; the slots that started a burst on it are in
+    // started() until the next call.  A start clears everything of the
+    // slot's but the last mid, so two slots that both start a burst on
+    // the same event agree from there on.
+    template <class Close>
+    void process(const LobsterMessage& msg, const BurstQuote& q, Close&& close) {
+        started_.clear();
+        if (!excitation_.excites(msg, q)) {
+            // Keep the mid fresh for the next event's start price.
+            last_mid_ = q.mid;
+            each([&](auto& f) { f.observe(msg, q); });
+            return;
+        }
+
+        const size_t n = slots();
+        if (active_) {
+            // Gap from the LAST EVENT (not the last row).
+            const size_t ended = termination_.end(msg.time - last_time_, ends_.data());
+            if (ended) {
+                for (size_t k = 0; k < n; ++k) {
+                    if (ends_[k]) close_slot(k, close);
+                }
+            }
+            termination_.excite();
+            if (ended) {
+                for (size_t k = 0; k < n; ++k) {
+                    if (ends_[k]) open(k, msg, q.mid);
+                }
+            }
+        } else {
+            active_ = true;
+            for (size_t k = 0; k < n; ++k) open(k, msg, q.mid);
+        }
+
+        each([&](auto& f) { f.count(msg); });
+        for (MinMax& p : price_) p.add(q.mid);
+        last_time_ = msg.time;
+        last_mid_  = q.mid;
+    }
+
+    // Close every open burst (end of the trading day).
+    template <class Close>
+    void flush(Close&& close) {
+        started_.clear();
+        if (!active_) return;
+        for (size_t k = 0; k < slots(); ++k) close_slot(k, close);
+        active_ = false;
+    }
+
+    // New day; configurations and capacity are kept.
+    void reset() {
+        active_    = false;
+        last_time_ = 0.0;
+        last_mid_  = 0.0;
+        started_.clear();
+        each([](auto& f) { f.clear(); });
+    }
+
+    bool   active() const { return active_; }
+    double start_time(size_t k) const { return start_time_[k]; }
+    const std::vector<uint32_t>& started() const { return started_; }
+
+private:
+    template <class F>
+    void each(F&& fn) {
+        std::apply([&](auto&... f) { (fn(f), ...); }, features_);
+    }
+
+    template <class Close>
+    void close_slot(size_t k, Close& close) const {
+        const BurstSpan span{id_[k], start_time_[k], last_time_, start_price_[k], last_mid_,
+                             price_[k].hi, price_[k].lo, termination_.peak(k)};
+        std::apply([&](const auto&... f) { close(k, span, f.since(k)...); }, features_);
+    }
+
+    void open(size_t k, const LobsterMessage& msg, double mid) {
+        id_[k]          = msg.order_id;
+        start_time_[k]  = msg.time;
+        // last_mid_ is the mid after the previous row, so the price
+        // just before this event.
+        start_price_[k] = (last_mid_ > 0) ? last_mid_ : mid;
+        price_[k].clear();
+        price_[k].add(start_price_[k]);
+        termination_.open(k);
+        each([&](auto& f) { f.open(k); });
+        started_.push_back((uint32_t)k);
+    }
+
+    Excitation             excitation_;
+    Termination            termination_;
+    std::tuple<Features...> features_;
+
+    // ── Per slot ─────────────────────────────────────────────
+    std::vector<long>     id_;
+    std::vector<double>   start_time_;
+    std::vector<double>   start_price_;
+    std::vector<MinMax>   price_;         // mids over its events, and its start price
+    std::vector<uint8_t>  ends_;          // this event ends its burst
+
+    // ── Shared ───────────────────────────────────────────────
+    bool   active_    = false;            // every slot has a burst open
+    double last_time_ = 0.0;              // last event (to measure the gap)
+    double last_mid_  = 0.0;              // mid after the last row
+    std::vector<uint32_t> started_;
+};
+
+// ─────────────────────────────────────────────────────────────
+// BurstBank: a list of DetectorConfigs over one event stream
+// ─────────────────────────────────────────────────────────────
+//
+// The Hawkes configurations run in one engine and the silence ones in
+// another; an engine with no configuration is skipped.  Callbacks and
+// started() speak configuration indices (positions in the list).
+// ─────────────────────────────────────────────────────────────
+
+template <class Excitation, class... Features>
+class BurstBank {
+public:
+    BurstBank(const std::vector<DetectorConfig>& configs, Excitation excitation, Features... features)
+        : configs_(configs), hawkes_(excitation, features...), silence_(excitation, features...) {
+        for (size_t k = 0; k < configs_.size(); ++k) {
+            if (configs_[k].hawkes()) {
+                hawkes_.add(configs_[k]);
+                hawkes_config_.push_back((uint32_t)k);
+            } else {
+                silence_.add(configs_[k]);
+                silence_config_.push_back((uint32_t)k);
+            }
+        }
+        started_.reserve(configs_.size());
+    }
+
+    size_t configs() const { return configs_.size(); }
+    const DetectorConfig& config(size_t k) const { return configs_[k]; }
+
+    // close(config, span, values...) per burst the row ends (as
+    // BurstEngine::process).
+    template <class Close>
+    void process(const LobsterMessage& msg, const BurstQuote& q, Close&& close) {
+        started_.clear();
+        auto step = [&](auto& engine, auto&& c) { engine.process(msg, q, c); };
+        if (hawkes_.slots())  run(hawkes_, hawkes_config_, step, close);
+        if (silence_.slots()) run(silence_, silence_config_, step, close);
+    }
+
+    template <class Close>
+    void flush(Close&& close) {
+        started_.clear();
+        auto step = [](auto& engine, auto&& c) { engine.flush(c); };
+        if (hawkes_.slots())  run(hawkes_, hawkes_config_, step, close);
+        if (silence_.slots()) run(silence_, silence_config_, step, close);
+    }
+
+    void reset() {
+        hawkes_.reset();
+        silence_.reset();
+        started_.clear();
+    }
+
+    const std::vector<uint32_t>& started() const { return started_; }
+
+    // Earliest start of an open burst (+inf if none).
+    double earliest_open_start() const {
+        double t = std::numeric_limits<double>::infinity();
+        earliest(hawkes_, t);
+        earliest(silence_, t);
+        return t;
+    }
+
+private:
+    template <class Engine, class Step, class Close>
+    void run(Engine& engine, const std::vector<uint32_t>& config, Step&& step, Close& close) {
+        step(engine, [&](size_t k, const BurstSpan& span, const auto&... values) {
+            close((size_t)config[k], span, values...);
+        });
+        for (uint32_t k : engine.started()) started_.push_back(config[k]);
+    }
+
+    template <class Engine>
+    static void earliest(const Engine& engine, double& t) {
+        if (!engine.active()) return;
+        for (size_t k = 0; k < engine.slots(); ++k) t = std::min(t, engine.start_time(k));
+    }
+
+    std::vector<DetectorConfig> configs_;
+    BurstEngine<Excitation, HawkesTermination, Features...>  hawkes_;
+    BurstEngine<Excitation, SilenceTermination, Features...> silence_;
+    std::vector<uint32_t> hawkes_config_;    // slot → configuration
+    std::vector<uint32_t> silence_config_;
+    std::vector<uint32_t> started_;
+};
+
+#endif
@@ -0,0 +1,47 @@
+// Columnar burst output (format described in burst_table.h)
+#include "burst_table.h"
+
+template <class T>
+static void append_pod(std::string& out, const T& v) {
+    out.append(reinterpret_cast<const char*>(&v), sizeof v);
+}
+
+bool bcol_header(const std::vector<BcolColumn>& columns, std::string& out) {
+    BcolFileHeader fh;
+    std::memcpy(fh.magic, "BURSTC1\0", 8);
+    fh.version = BCOL_VERSION;
+    fh.columns = (uint32_t)columns.size();
+    append_pod(out, fh);
+    for (const BcolColumn& c : columns) {
+        if (c.name.size() >= BCOL_NAME_SIZE) return false;
+        BcolColumnDesc d;
+        std::memset(&d, 0, sizeof d);
+        std::memcpy(d.name, c.name.data(), c.name.size());
+        d.type = c.type;
+        append_pod(out, d);
+    }
+    return true;
+}
+
+void bcol_block(const std::vector<std::string>& texts, const uint64_t* cells, size_t numeric,
+                const std::vector<size_t>& rows, std::string& out) {
+    const size_t text_at = out.size() + sizeof(BcolBlockHeader);
+    out.resize(text_at);
+    for (const std::string& t : texts) out.append(t.c_str(), t.size() + 1);
+    out.resize(text_at + (out.size() - text_at + 7) / 8 * 8, '\0');
+
+    BcolBlockHeader bh;
+    bh.rows       = rows.size();
+    bh.text_bytes = out.size() - text_at;
+    std::memcpy(&out[text_at - sizeof bh], &bh, sizeof bh);
+
+    // Transpose the rows one column at a time.
+    size_t at = out.size();
+    out.resize(at + numeric * rows.size() * sizeof(uint64_t));
+    for (size_t c = 0; c < numeric; ++c) {
+        for (size_t r : rows) {
+            std::memcpy(&out[at], &cells[r * numeric + c], sizeof(uint64_t));
+            at += sizeof(uint64_t);
+        }
+    }
+}
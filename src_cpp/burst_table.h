@@ -0,0 +1,145 @@
+#ifndef BURST_TABLE_H
+#define BURST_TABLE_H
+
+#include <string>
+#include <vector>
+#include <charconv>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+
+// ─────────────────────────────────────────────────────────────
+// Burst output rows: one column list, written as CSV or .bcol
+// ─────────────────────────────────────────────────────────────
+//
+// A driver describes a burst row once, as a sequence of sink calls in
+// column order:
+//
+//     s.text("Ticker", ticker);  s.integer("Volume", v);  s.real("D_b", d, 6);
+//
+// and runs it through a sink: SchemaSink collects the column names and
+// types (the CSV header, the .bcol column table), CsvRowSink formats the
+// row with std::to_chars (`precision` digits, fixed: the same text as
+// printf's %.*f), and CellSink stores it for bcol_block().  The CSV
+// header and the .bcol columns therefore always match.
+//
+// .bcol (--format bcol) is a typed columnar file, little-endian,
+// everything 8-byte aligned so a reader can map columns in place:
+//
+//   FileHeader       magic "BURSTC1\0", version, column count
+//   ColumnDesc × n   name (NUL-padded), type
+//   Block × days     one per committed day with rows, in date order
+//
+//   Block:  BlockHeader  rows, text bytes
+//           text values  one per TEXT column (Ticker, Date: constant
+//                        within a day), each NUL-terminated, the whole
+//                        run padded to 8 bytes
+//           columns      every INT64 / FLOAT64 column in schema order,
+//                        rows × 8 bytes each
+//
+// .bcol holds the full double values; the CSV rounds them to each
+// column's precision.  (So under -S the rolling-window columns can
+// differ from a one-chunk run in the last bits — their running sums
+// start where the chunk does — which the CSV's digits never show.)
+// src_py/burstcol.py reads it into numpy arrays.
+// ─────────────────────────────────────────────────────────────
+
+constexpr uint32_t BCOL_VERSION   = 1;
+constexpr size_t   BCOL_NAME_SIZE = 56;
+
+enum BcolType : uint32_t { BCOL_TEXT = 0, BCOL_INT64 = 1, BCOL_FLOAT64 = 2 };
+
+struct BcolFileHeader {
+    char     magic[8];     // "BURSTC1\0"
+    uint32_t version;
+    uint32_t columns;
+};
+
+struct BcolColumnDesc {
+    char     name[BCOL_NAME_SIZE];
+    uint32_t type;         // BcolType
+    uint32_t reserved;     // 0
+};
+
+struct BcolBlockHeader {
+    uint64_t rows;
+    uint64_t text_bytes;   // padded
+};
+
+struct BcolColumn {
+    std::string name;
+    BcolType    type;
+};
+
+// Column names and types, in row order.
+struct SchemaSink {
+    std::vector<BcolColumn> columns;
+
+    void text(const char* name, const std::string&)  { columns.push_back({name, BCOL_TEXT}); }
+    void integer(const char* name, long long)        { columns.push_back({name, BCOL_INT64}); }
+    void real(const char* name, double, int)         { columns.push_back({name, BCOL_FLOAT64}); }
+
+    // "Ticker,Date,...", no newline.
+    std::string csv_header() const {
+        std::string h;
+        for (const BcolColumn& c : columns) h += (h.empty() ? "" : ",") + c.name;
+        return h;
+    }
+};
+
+// CSV rows appended to a buffer.
+struct CsvRowSink {
+    std::string& out;
+    bool first = true;
+
+    explicit CsvRowSink(std::string& o) : out(o) {}
+    void text(const char*, const std::string& v) { sep(); out += v; }
+    void integer(const char*, long long v) {
+        sep();
+        char buf[24];
+        out.append(buf, std::to_chars(buf, buf + sizeof buf, v).ptr);
+    }
+    void real(const char*, double v, int precision) {
+        sep();
+        char buf[400];   // any double, fixed, up to 80 decimals
+        auto r = std::to_chars(buf, buf + sizeof buf, v, std::chars_format::fixed, precision);
+        out.append(buf, r.ptr);
+    }
+    void end_row() { out += '\n'; first = true; }
+
+private:
+    void sep() { if (!first) out += ','; first = false; }
+};
+
+// Rows for bcol_block(): numeric cells row-major (int64 or double
+// bits), text values as of the last row.
+struct CellSink {
+    std::vector<uint64_t>&    cells;
+    std::vector<std::string>& texts;
+    size_t text_k = 0;
+
+    CellSink(std::vector<uint64_t>& c, std::vector<std::string>& t) : cells(c), texts(t) {}
+    void text(const char*, const std::string& v) {
+        if (text_k == texts.size()) texts.push_back(v);
+        else if (texts[text_k] != v) texts[text_k] = v;
+        ++text_k;
+    }
+    void integer(const char*, long long v) { cells.push_back((uint64_t)v); }
+    void real(const char*, double v, int) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof bits);
+        cells.push_back(bits);
+    }
+    void end_row() { text_k = 0; }
+};
+
+// .bcol file header and column table.  False if a name does not fit.
+bool bcol_header(const std::vector<BcolColumn>& columns, std::string& out);
+
+// One day's block, appended to `out`: `texts` holds a value per TEXT
+// column, `cells` the numeric cells of every row (CellSink, `numeric`
+// per row), `rows` the rows to write.
+void bcol_block(const std::vector<std::string>& texts, const uint64_t* cells, size_t numeric,
+                const std::vector<size_t>& rows, std::string& out);
+
+#endif
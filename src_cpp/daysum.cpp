@@ -0,0 +1,153 @@
+// Per-day summary cache (format and keying described in daysum.h)
+#include "daysum.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <algorithm>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static constexpr size_t DAYSUM_HASH_BLOCK = 64 * 1024;
+
+static uint64_t fnv1a(const char* p, size_t n) {
+    uint64_t h = 1469598103934665603ULL;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= (unsigned char)p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+static bool hash_block(int fd, off_t off, size_t len, uint64_t& out) {
+    std::string buf(len, '\0');
+    size_t got = 0;
+    while (got < len) {
+        ssize_t r = pread(fd, &buf[got], len - got, off + (off_t)got);
+        if (r <= 0) return false;
+        got += (size_t)r;
+    }
+    out = fnv1a(buf.data(), len);
+    return true;
+}
+
+bool day_file_key(const std::string& day_file, DayFileKey& key) {
+    char abs[PATH_MAX];
+    if (!realpath(day_file.c_str(), abs)) return false;
+    key.path = abs;
+
+    int fd = ::open(abs, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (ok) {
+        key.size     = (long long)st.st_size;
+        key.mtime_ns = (long long)st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+        size_t len   = (size_t)std::min<long long>(key.size, (long long)DAYSUM_HASH_BLOCK);
+        ok = hash_block(fd, 0, len, key.head_hash) &&
+             hash_block(fd, (off_t)(key.size - (long long)len), len, key.tail_hash);
+    }
+    ::close(fd);
+    return ok;
+}
+
+std::string day_sidecar_path(const std::string& abs_day_file, const std::string& cache_dir,
+                             const char* ext) {
+    auto slash = abs_day_file.rfind('/');
+    std::string name = abs_day_file.substr(slash + 1) + ext;
+    if (cache_dir.empty()) return abs_day_file.substr(0, slash + 1) + name;
+    std::string dir = cache_dir;
+    if (dir.back() != '/') dir += '/';
+    return dir + name;
+}
+
+bool load_day_summary(const std::string& day_file, const std::string& cache_dir,
+                      double rth_start, double rth_end, DaySummary& out) {
+    if (cache_dir == "off") return false;
+    DayFileKey key;
+    if (!day_file_key(day_file, key)) return false;
+
+    FILE* fp = std::fopen(day_sidecar_path(key.path, cache_dir, ".daysum").c_str(), "r");
+    if (!fp) return false;
+
+    DayFileKey stored;
+    DaySummary sum;
+    double s_start = -1.0, s_end = -1.0;
+    int version = 0;
+    bool complete = false;
+    char line[PATH_MAX + 64];
+    while (std::fgets(line, sizeof(line), fp)) {
+        line[std::strcspn(line, "\n")] = '\0';
+        char* val = std::strchr(line, ' ');
+        if (!val) { complete = std::strcmp(line, "end") == 0; continue; }
+        *val++ = '\0';
+        if      (!std::strcmp(line, "daysum"))                version = std::atoi(val);
+        else if (!std::strcmp(line, "path"))                  stored.path = val;
+        else if (!std::strcmp(line, "size"))                  stored.size = std::atoll(val);
+        else if (!std::strcmp(line, "mtime_ns"))              stored.mtime_ns = std::atoll(val);
+        else if (!std::strcmp(line, "head_hash"))             stored.head_hash = std::strtoull(val, nullptr, 16);
+        else if (!std::strcmp(line, "tail_hash"))             stored.tail_hash = std::strtoull(val, nullptr, 16);
+        else if (!std::strcmp(line, "rth_start"))             s_start = std::strtod(val, nullptr);
+        else if (!std::strcmp(line, "rth_end"))               s_end = std::strtod(val, nullptr);
+        else if (!std::strcmp(line, "rth_trade_volume"))      sum.rth_trade_volume = std::atoll(val);
+        else if (!std::strcmp(line, "rth_submission_volume")) sum.rth_submission_volume = std::atoll(val);
+        else if (!std::strcmp(line, "msg_count"))             sum.msg_count = std::atol(val);
+        else if (!std::strcmp(line, "close_mid"))             sum.close_mid = std::strtod(val, nullptr);
+        else if (!std::strcmp(line, "peak_bytes"))            sum.peak_bytes = std::atoll(val);
+    }
+    std::fclose(fp);
+
+    if (!complete || version != 1 ||
+        stored.path != key.path || stored.size != key.size ||
+        stored.mtime_ns != key.mtime_ns ||
+        stored.head_hash != key.head_hash || stored.tail_hash != key.tail_hash ||
+        s_start != rth_start || s_end != rth_end) {
+        return false;
+    }
+    out = sum;
+    return true;
+}
+
+bool store_day_summary(const std::string& day_file, const std::string& cache_dir,
+                       double rth_start, double rth_end, const DaySummary& sum) {
+    if (cache_dir == "off") return false;
+    DayFileKey key;
+    if (!day_file_key(day_file, key)) return false;
+
+    static std::atomic<unsigned> seq{0};
+    const std::string target = day_sidecar_path(key.path, cache_dir, ".daysum");
+    const std::string tmp = target + ".tmp." + std::to_string(getpid()) + "." +
+                            std::to_string(seq.fetch_add(1));
+
+    FILE* fp = std::fopen(tmp.c_str(), "w");
+    if (!fp) return false;
+    std::fprintf(fp,
+                 "daysum 1\n"
+                 "size %lld\n"
+                 "mtime_ns %lld\n"
+                 "head_hash %016" PRIx64 "\n"
+                 "tail_hash %016" PRIx64 "\n"
+                 "rth_start %.17g\n"
+                 "rth_end %.17g\n"
+                 "rth_trade_volume %lld\n"
+                 "rth_submission_volume %lld\n"
+                 "msg_count %ld\n"
+                 "close_mid %.17g\n"
+                 "peak_bytes %lld\n"
+                 "path %s\n"
+                 "end\n",
+                 key.size, key.mtime_ns, key.head_hash, key.tail_hash,
+                 rth_start, rth_end,
+                 sum.rth_trade_volume, sum.rth_submission_volume,
+                 sum.msg_count, sum.close_mid, sum.peak_bytes, key.path.c_str());
+    bool ok = !std::ferror(fp);
+    ok = (std::fclose(fp) == 0) && ok;
+    if (!ok || std::rename(tmp.c_str(), target.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
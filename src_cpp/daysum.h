@@ -0,0 +1,63 @@
+#ifndef DAYSUM_H
+#define DAYSUM_H
+
+#include <string>
+#include <cstdint>
+
+// ─────────────────────────────────────────────────────────────
+// Per-day summary cache (".daysum" sidecar files)
+// ─────────────────────────────────────────────────────────────
+//
+// After a day file has been replayed once, its RTH volumes are known;
+// a re-run with other detector parameters only needs them for the
+// trailing-ADV thresholds.  The summary is kept in a small text
+// sidecar, <dir>/<day file name>.daysum, where <dir> is the day
+// file's own folder or a cache folder (-C).
+//
+// An entry is valid only for the exact file it was made from: the
+// key is the absolute path, size, mtime (ns) and a hash of the first
+// and last 64 KiB of the file, plus the RTH window the volumes were
+// measured over.  Any mismatch is a miss.
+//
+// Writers build the entry in a private temp file and rename() it into
+// place, so concurrent writers (many SGE array tasks on one shared
+// folder) never expose a torn file; last rename wins, and all writers
+// write the same content.
+// ─────────────────────────────────────────────────────────────
+
+// Identity of a day file: absolute path, size, mtime (ns) and FNV-1a
+// hashes of its first and last 64 KiB.  Also keys the book index
+// sidecars (book_index.h).
+struct DayFileKey {
+    std::string path;       // absolute
+    long long   size = 0;
+    long long   mtime_ns = 0;
+    uint64_t    head_hash = 0;
+    uint64_t    tail_hash = 0;
+};
+
+bool day_file_key(const std::string& day_file, DayFileKey& key);
+
+// <dir>/<day file name><ext> for an absolute day file path; <dir> is the
+// file's own folder when cache_dir is "".
+std::string day_sidecar_path(const std::string& abs_day_file, const std::string& cache_dir,
+                             const char* ext);
+
+struct DaySummary {
+    long long rth_trade_volume      = 0;   // types 4/5 in [rth_start, rth_end]
+    long long rth_submission_volume = 0;   // type 1   in [rth_start, rth_end]
+    long      msg_count             = 0;
+    double    close_mid             = 0.0; // last mid of the day
+    long long peak_bytes            = 0;   // largest day footprint measured so
+                                           // far (--mem-budget); 0 = unknown
+};
+
+// cache_dir: "" = next to the day file; "off" disables the cache.
+bool load_day_summary(const std::string& day_file, const std::string& cache_dir,
+                      double rth_start, double rth_end, DaySummary& out);
+
+// Best effort: returns false (silently) if the entry cannot be written.
+bool store_day_summary(const std::string& day_file, const std::string& cache_dir,
+                       double rth_start, double rth_end, const DaySummary& sum);
+
+#endif
@@ -0,0 +1,218 @@
+#ifndef FORWARD_H
+#define FORWARD_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstddef>
+#include "timeline.h"
+
+// ─────────────────────────────────────────────────────────────
+// Forward horizons: the lookups done for a day's bursts after its
+// replay
+// ─────────────────────────────────────────────────────────────
+//
+// Every burst asks the day's L1Timeline for the mid at end_time + h
+// for each -T horizon (and the fixed D_b horizons), the BBO at
+// end_time, and the extreme mid within tau_max of start_time.
+// A day's bursts come out of the detector in time order, so instead of
+// a binary search per burst and horizon, each horizon keeps an
+// AsOfCursor that gallops forward from the previous burst's answer,
+// and the peaks come from one monotonic-deque pass (PeakSweep) over
+// the [start, start + tau_max] windows.  Both fall back to a fresh
+// binary search if a query goes back in time, so they answer exactly
+// what the old per-burst lookups did, in any order.
+// ─────────────────────────────────────────────────────────────
+
+// D_b = (1/4) Σ Q_b × Direction × (Mid_τ − StartPrice) over these,
+// whatever -T asks for.
+constexpr double DECAY_HORIZONS[4] = {60.0, 180.0, 300.0, 600.0};
+
+constexpr int MAX_HORIZONS = 16;   // -T entries (BurstRecord holds this many)
+
+struct Horizon {
+    double      secs  = 0.0;     // after the burst's end (unused for close)
+    bool        close = false;   // the mid at rth_end instead
+    std::string label;           // column suffix: Mid_<label>
+};
+
+// 1m, 3m, 5m, 10m — the Mid_1m … Mid_10m columns.
+inline std::vector<Horizon> default_horizons() {
+    std::vector<Horizon> h(4);
+    const char* labels[4] = {"1m", "3m", "5m", "10m"};
+    for (int k = 0; k < 4; ++k) { h[k].secs = DECAY_HORIZONS[k]; h[k].label = labels[k]; }
+    return h;
+}
+
+// "1s,10s,1m,3m,1h,close": a number with an optional s / m / h unit
+// (seconds by default), or "close".  Labels use the largest unit that
+// divides the horizon (90s → "90s", 120 → "2m").  Empty if malformed,
+// non-positive or longer than MAX_HORIZONS.
+inline std::vector<Horizon> parse_horizons(const std::string& text) {
+    std::vector<Horizon> out;
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) comma = text.size();
+        const std::string tok = text.substr(pos, comma - pos);
+        pos = comma + 1;
+        Horizon h;
+        if (tok == "close") {
+            h.close = true;
+            h.label = "close";
+        } else {
+            char* end = nullptr;
+            const double v = std::strtod(tok.c_str(), &end);
+            if (end == tok.c_str() || !(v > 0.0)) return {};
+            double scale = 1.0;
+            if      (*end == 's') { ++end; }
+            else if (*end == 'm') { scale = 60.0;   ++end; }
+            else if (*end == 'h') { scale = 3600.0; ++end; }
+            if (*end != '\0') return {};
+            h.secs = v * scale;
+            const char* unit = "s";
+            double n = h.secs;
+            if      (std::fmod(h.secs, 3600.0) == 0.0) { n = h.secs / 3600.0; unit = "h"; }
+            else if (std::fmod(h.secs, 60.0) == 0.0)   { n = h.secs / 60.0;   unit = "m"; }
+            std::string num = std::to_string(n);
+            num.erase(num.find_last_not_of('0') + 1);
+            if (num.back() == '.') num.pop_back();
+            h.label = num + unit;
+        }
+        out.push_back(h);
+    }
+    if (out.empty() || (int)out.size() > MAX_HORIZONS) return {};
+    return out;
+}
+
+// "1m,3m,close", for the Settings line.
+inline std::string join_horizons(const std::vector<Horizon>& hs) {
+    std::string s;
+    for (const Horizon& h : hs) s += (s.empty() ? "" : ",") + h.label;
+    return s;
+}
+
+// Longest timed horizon (close excluded).
+inline double longest_horizon(const std::vector<Horizon>& hs) {
+    double l = 0.0;
+    for (const Horizon& h : hs) if (!h.close) l = std::max(l, h.secs);
+    return l;
+}
+
+inline bool has_close_horizon(const std::vector<Horizon>& hs) {
+    for (const Horizon& h : hs) if (h.close) return true;
+    return false;
+}
+
+// ── AsOfCursor ──────────────────────────────────────────────
+// The timeline entry at or just before t — the first one if t is
+// before it.  Ascending queries gallop from the last answer: O(log
+// gap) each.
+class AsOfCursor {
+public:
+    explicit AsOfCursor(const L1Timeline& tl) : tl_(tl) {}
+
+    // Index of the answer; the timeline must not be empty.
+    size_t index(double t) {
+        const size_t n = tl_.size();
+        if (t < last_) {
+            seen_ = tl_.upper_bound(t, 0, seen_);
+        } else {
+            size_t lo = seen_, step = 1;
+            while (lo + step <= n && tl_.time(lo + step - 1) <= t) {
+                lo += step;
+                step <<= 1;
+            }
+            seen_ = tl_.upper_bound(t, lo, std::min(n, lo + step));
+        }
+        last_ = t;
+        if (t <= tl_.time(0)) return 0;
+        return seen_ - 1;
+    }
+
+    // Mid in force at t (0 if the timeline is empty).
+    double mid(double t) { return tl_.empty() ? 0.0 : tl_.mid(index(t)); }
+
+private:
+    const L1Timeline& tl_;
+    size_t seen_ = 0;           // entries at or before last_
+    double last_ = -INFINITY;
+};
+
+// ── PeakSweep ───────────────────────────────────────────────
+// Highest / lowest mid among the mid changes timed in [start, start +
+// tau], for windows taken in order of start: two monotonic deques over
+// a window whose ends only move forward, so every entry is pushed and
+// popped at most once per pass.
+class PeakSweep {
+public:
+    PeakSweep(const L1Timeline& tl, double tau) : tl_(tl), tau_(tau) {}
+
+    // The most extreme price of the window, start_price included:
+    // highest for a buy burst, lowest for a sell burst, whichever
+    // moved further for a mixed one.
+    double peak(double start_time, double start_price, int direction) {
+        const size_t n = tl_.size();
+        if (start_time < last_start_) {   // out of order: start over
+            from_ = next_ = 0;
+            max_.clear();
+            min_.clear();
+        }
+        last_start_ = start_time;
+        from_ = tl_.lower_bound(start_time, from_);
+        if (next_ < from_) {
+            next_ = from_;
+            max_.clear();
+            min_.clear();
+        }
+        max_.drop_before(from_);
+        min_.drop_before(from_);
+        const double end_time = start_time + tau_;
+        for (; next_ < n && tl_.time(next_) <= end_time; ++next_) {
+            if (!tl_.mid_changed(next_)) continue;
+            const double p = tl_.mid(next_);
+            max_.push(next_, [&](size_t k) { return tl_.mid(k) <= p; });
+            min_.push(next_, [&](size_t k) { return tl_.mid(k) >= p; });
+        }
+
+        double max_p = start_price, min_p = start_price;
+        if (!max_.empty()) {
+            max_p = std::max(max_p, tl_.mid(max_.front()));
+            min_p = std::min(min_p, tl_.mid(min_.front()));
+        }
+        if (direction == 1)  return max_p;   // Buy burst → highest price reached
+        if (direction == -1) return min_p;   // Sell burst → lowest price reached
+        // Mixed: whichever moved further from start
+        return (std::abs(max_p - start_price) >= std::abs(min_p - start_price)) ? max_p : min_p;
+    }
+
+private:
+    // Entry indices in window order; push() first drops the ones the
+    // new index beats.
+    struct MonoQueue {
+        std::vector<size_t> idx;
+        size_t head = 0;
+        bool   empty() const { return head == idx.size(); }
+        size_t front() const { return idx[head]; }
+        void   clear() { idx.clear(); head = 0; }
+        void   drop_before(size_t k) { while (!empty() && front() < k) ++head; }
+        template <class Beaten>
+        void push(size_t k, Beaten beaten) {
+            while (!empty() && beaten(idx.back())) idx.pop_back();
+            idx.push_back(k);
+        }
+    };
+
+    const L1Timeline& tl_;
+    const double tau_;
+    double    last_start_ = -INFINITY;
+    size_t    from_ = 0;        // first entry of the current window
+    size_t    next_ = 0;        // first entry not yet pushed
+    MonoQueue max_;             // decreasing prices
+    MonoQueue min_;             // increasing prices
+};
+
+#endif
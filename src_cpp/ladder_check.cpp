@@ -0,0 +1,208 @@
+// ─────────────────────────────────────────────────────────────
+// ladder_check.cpp  –  FlatLadder vs std::map<int,int> (make check)
+// ─────────────────────────────────────────────────────────────
+//
+// Random add/reduce streams are applied to a FlatLadder and to the
+// std::map<int,int> it replaces, for the bid and the ask side.  After
+// every operation the return value, best price/size and empty() must
+// agree; next_worse() and depth() are compared at random prices and
+// level counts, and the whole side is walked level by level now and
+// then.
+//
+// The prices drift around a moving touch that now and then jumps by
+// more than a quarter window (re-centring), with off-tick (sub-penny)
+// quotes and outliers far outside the window mixed in, so levels
+// migrate between the array and the outlier map both ways.
+//
+//     ladder_check [-n runs] [-o ops_per_run]
+//
+// Exit status 0 if every run matched.
+// ─────────────────────────────────────────────────────────────
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <cstdlib>
+
+#include "price_ladder.h"
+
+// The reference: one side as std::map, best = highest bid / lowest ask.
+struct MapSide {
+    bool bid;
+    std::map<int, int> lv;
+
+    int add(int price, int size) {
+        int& v = lv[price];
+        int old = v;
+        v += size;
+        return old;
+    }
+    int reduce(int price, int size_delta) {
+        auto it = lv.find(price);
+        if (it == lv.end()) return 0;
+        int old = it->second;
+        it->second -= size_delta;
+        if (it->second <= 0) lv.erase(it);
+        return old;
+    }
+    int best_price() const {
+        if (lv.empty()) return 0;
+        return bid ? lv.rbegin()->first : lv.begin()->first;
+    }
+    int best_volume() const {
+        if (lv.empty()) return 0;
+        return bid ? lv.rbegin()->second : lv.begin()->second;
+    }
+    int depth(int levels) const {
+        int total = 0, count = 0;
+        if (bid) {
+            for (auto it = lv.rbegin(); it != lv.rend(); ++it) {
+                total += it->second;
+                if (levels > 0 && ++count >= levels) break;
+            }
+        } else {
+            for (auto it = lv.begin(); it != lv.end(); ++it) {
+                total += it->second;
+                if (levels > 0 && ++count >= levels) break;
+            }
+        }
+        return total;
+    }
+    int next_worse(int price, int& vol) const {
+        if (bid) {
+            auto it = lv.lower_bound(price);
+            if (it != lv.begin()) { --it; vol = it->second; return it->first; }
+        } else {
+            auto it = lv.upper_bound(price);
+            if (it != lv.end()) { vol = it->second; return it->first; }
+        }
+        vol = 0;
+        return 0;
+    }
+};
+
+// A price for the next operation.  `mid` is the touch the stream
+// drifts around; it walks by ticks and now and then jumps.
+static int next_price(std::mt19937_64& rng, int& mid) {
+    const int r = (int)(rng() % 100);
+    if (r == 0) {                                            // jump: re-centre
+        const int ticks = LADDER_WIDTH / 4 + (int)(rng() % (2 * LADDER_WIDTH));
+        mid += ((rng() & 1) ? ticks : -ticks) * LADDER_TICK;
+        if (mid < 100 * LADDER_TICK) mid = 100 * LADDER_TICK + (int)(rng() % 1000) * LADDER_TICK;
+    } else if (r < 20) {
+        mid += ((int)(rng() % 5) - 2) * LADDER_TICK;
+        if (mid < 100 * LADDER_TICK) mid = 100 * LADDER_TICK;
+    }
+    const int off = (int)(rng() % 200) - 100;                // ticks from the touch
+    const int on_tick = mid + off * LADDER_TICK;
+    const int k = (int)(rng() % 100);
+    if (k < 8)  return on_tick + 1 + (int)(rng() % (LADDER_TICK - 1));     // sub-penny
+    if (k < 12) return mid + ((rng() & 1) ? 1 : -1) * (LADDER_WIDTH + (int)(rng() % 20000)) * LADDER_TICK;
+    if (k < 14) return LADDER_TICK * (1 + (int)(rng() % 50));               // near zero
+    return on_tick > 0 ? on_tick : LADDER_TICK;
+}
+
+// One random stream against one side; false (and a report) on the
+// first mismatch.
+static bool run(bool bid, uint64_t seed, long ops) {
+    std::mt19937_64 rng(seed);
+    FlatLadder flat(bid);
+    MapSide ref{bid, {}};
+    int mid = 5000000 + (int)(rng() % 1000) * LADDER_TICK;
+    const char* side = bid ? "bid" : "ask";
+    long op = 0;
+
+    auto fail = [&](const std::string& what, long long got, long long want) {
+        std::cerr << "MISMATCH " << side << " seed=" << seed << " op=" << op << ": " << what
+                  << " flat=" << got << " map=" << want << "\n";
+        return false;
+    };
+
+    for (; op < ops; ++op) {
+        const int r = (int)(rng() % 1000);
+        if (r == 0) {
+            flat.clear();
+            ref.lv.clear();
+        } else if (r < 520 || ref.lv.empty()) {
+            const int price = next_price(rng, mid);
+            const int size = 1 + (int)(rng() % 500);
+            const int got = flat.add(price, size), want = ref.add(price, size);
+            if (got != want) return fail("add(" + std::to_string(price) + ")", got, want);
+        } else {
+            // Mostly a level that exists (often the touch), sometimes not.
+            int price;
+            const int k = (int)(rng() % 10);
+            if (k < 3) {
+                price = ref.best_price();
+            } else if (k < 9) {
+                auto it = ref.lv.begin();
+                std::advance(it, (long)(rng() % ref.lv.size() % 64));
+                if (rng() & 1) {
+                    it = ref.lv.end();
+                    std::advance(it, -1 - (long)(rng() % ref.lv.size() % 64));
+                }
+                price = it->first;
+            } else {
+                price = next_price(rng, mid);
+            }
+            auto it = ref.lv.find(price);
+            const int have = it == ref.lv.end() ? 1 : it->second;
+            const int delta = (rng() % 3 == 0) ? have + (int)(rng() % 3) : 1 + (int)(rng() % have);
+            const int got = flat.reduce(price, delta), want = ref.reduce(price, delta);
+            if (got != want) return fail("reduce(" + std::to_string(price) + ")", got, want);
+        }
+
+        if (flat.empty() != ref.lv.empty()) return fail("empty", flat.empty(), ref.lv.empty());
+        if (flat.best_price() != ref.best_price()) return fail("best_price", flat.best_price(), ref.best_price());
+        if (flat.best_volume() != ref.best_volume()) return fail("best_volume", flat.best_volume(), ref.best_volume());
+
+        const int levels = (int)(rng() % 12);
+        if (flat.depth(levels) != ref.depth(levels))
+            return fail("depth(" + std::to_string(levels) + ")", flat.depth(levels), ref.depth(levels));
+
+        const int probe = (rng() & 1) && !ref.lv.empty() ? ref.best_price() + (int)(rng() % 3) - 1
+                                                         : next_price(rng, mid);
+        int fv = -1, mv = -1;
+        const int fp = flat.next_worse(probe, fv), mp = ref.next_worse(probe, mv);
+        if (fp != mp || fv != mv)
+            return fail("next_worse(" + std::to_string(probe) + ")", fp * 1000000LL + fv, mp * 1000000LL + mv);
+
+        // Walk the whole side from the touch.
+        if (op % 997 == 0 && !ref.lv.empty()) {
+            int fpx = flat.best_price(), mpx = ref.best_price();
+            for (size_t n = 0; mpx != 0 && n <= ref.lv.size(); ++n) {
+                if (fpx != mpx) return fail("walk level " + std::to_string(n), fpx, mpx);
+                fpx = flat.next_worse(fpx, fv);
+                mpx = ref.next_worse(mpx, mv);
+            }
+            if (fpx != mpx) return fail("walk end", fpx, mpx);
+        }
+    }
+    std::cout << "ok   " << side << " seed=" << seed << "  ops=" << ops
+              << "  levels=" << ref.lv.size() << "\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int runs = 8;
+    long ops = 200000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        if (a == "-n") runs = std::atoi(argv[i + 1]);
+        else if (a == "-o") ops = std::atol(argv[i + 1]);
+    }
+
+    size_t failed = 0;
+    for (int k = 0; k < runs; ++k) {
+        const uint64_t seed = 20260107 + (uint64_t)k;
+        failed += !run(true, seed, ops);
+        failed += !run(false, seed, ops);
+    }
+    if (failed) {
+        std::cerr << failed << " of " << 2 * runs << " runs differ\n";
+        return 1;
+    }
+    std::cout << "all " << 2 * runs << " runs match\n";
+    return 0;
+}
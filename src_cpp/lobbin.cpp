@@ -0,0 +1,328 @@
+// .lobbin day-cache encoder / decoder (format described in lobbin.h)
+#include "lobbin.h"
+#include "varint.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <cmath>
+#include <algorithm>
+
+#ifdef LOBBIN_ZSTD
+#include <zstd.h>
+#endif
+
+static const char LOBBIN_MAGIC[8] = {'L', 'O', 'B', 'B', 'I', 'N', '1', '\0'};
+
+bool is_lobbin_path(const std::string& path) {
+    static const std::string ext = ".lobbin";
+    return path.size() > ext.size() &&
+           path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool lobbin_has_zstd() {
+#ifdef LOBBIN_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+// Nanoseconds-past-midnight if t round-trips exactly through ns / 1e9.
+static inline bool time_to_ns(double t, int64_t& ns) {
+    if (!(t >= 0.0 && t < 9.0e6)) return false;   // < 2^53 ns, excludes NaN
+    ns = (int64_t)std::llround(t * 1e9);
+    double back = (double)ns / 1e9;
+    return std::memcmp(&back, &t, sizeof(double)) == 0;
+}
+
+// ── Writer ──────────────────────────────────────────────────
+
+LobbinWriter::LobbinWriter(const std::string& path, int zstd_level)
+    : zstd_level_(zstd_level) {
+    if (zstd_level_ > 0 && !lobbin_has_zstd()) {
+        fail("zstd compression requested but this build has no zstd (make ZSTD=1)");
+        return;
+    }
+    fp_ = std::fopen(path.c_str(), "wb");
+    if (!fp_) { fail("cannot open " + path + ": " + std::strerror(errno)); return; }
+
+    // Placeholder header; total_rows is patched in close().
+    LobbinFileHeader hdr{};
+    std::memcpy(hdr.magic, LOBBIN_MAGIC, sizeof(hdr.magic));
+    hdr.version = LOBBIN_VERSION;
+    if (std::fwrite(&hdr, sizeof(hdr), 1, fp_) != 1) fail("header write failed");
+    pending_.reserve(LOBBIN_BLOCK_ROWS);
+}
+
+LobbinWriter::~LobbinWriter() {
+    if (fp_) std::fclose(fp_);
+}
+
+void LobbinWriter::fail(const std::string& why) {
+    if (ok_) error_ = why;
+    ok_ = false;
+}
+
+bool LobbinWriter::push(const LobsterMessage& msg) {
+    if (!ok_) return false;
+    if (msg.type < -128 || msg.type > 127 || msg.direction < -128 || msg.direction > 127) {
+        fail("row " + std::to_string(total_rows_ + pending_.size() + 1) +
+             ": type/direction does not fit the int8 column");
+        return false;
+    }
+    pending_.push_back(msg);
+    if (pending_.size() == LOBBIN_BLOCK_ROWS) flush_block();
+    return ok_;
+}
+
+void LobbinWriter::flush_block() {
+    if (pending_.empty() || !ok_) return;
+    const size_t n = pending_.size();
+
+    LobbinBlockHeader bh{};
+    bh.rows = (uint32_t)n;
+    payload_.clear();
+    size_t mark = 0;
+    auto end_column = [&](int c) {
+        bh.col_bytes[c] = (uint32_t)(payload_.size() - mark);
+        mark = payload_.size();
+    };
+
+    int64_t prev_ns = 0;
+    for (const auto& m : pending_) {
+        int64_t ns;
+        if (time_to_ns(m.time, ns)) {
+            put_varint(payload_, zigzag(ns - prev_ns) << 1);
+            prev_ns = ns;
+        } else {
+            put_varint(payload_, 1);
+            uint8_t raw[8];
+            std::memcpy(raw, &m.time, 8);
+            payload_.insert(payload_.end(), raw, raw + 8);
+        }
+    }
+    end_column(0);
+    for (const auto& m : pending_) payload_.push_back((uint8_t)(int8_t)m.type);
+    end_column(1);
+    for (const auto& m : pending_) payload_.push_back((uint8_t)(int8_t)m.direction);
+    end_column(2);
+    int64_t prev_id = 0;
+    for (const auto& m : pending_) {
+        put_varint(payload_, zigzag((int64_t)m.order_id - prev_id));
+        prev_id = m.order_id;
+    }
+    end_column(3);
+    for (const auto& m : pending_) put_varint(payload_, (uint64_t)(int64_t)m.size);
+    end_column(4);
+    int64_t prev_px = 0;
+    for (const auto& m : pending_) {
+        put_varint(payload_, zigzag((int64_t)m.price - prev_px));
+        prev_px = m.price;
+    }
+    end_column(5);
+
+    bh.raw_bytes = (uint32_t)payload_.size();
+    const std::vector<uint8_t>* body = &payload_;
+    bh.codec = LOBBIN_CODEC_RAW;
+#ifdef LOBBIN_ZSTD
+    if (zstd_level_ > 0) {
+        stored_.resize(ZSTD_compressBound(payload_.size()));
+        size_t z = ZSTD_compress(stored_.data(), stored_.size(),
+                                 payload_.data(), payload_.size(), zstd_level_);
+        if (ZSTD_isError(z)) { fail(std::string("zstd: ") + ZSTD_getErrorName(z)); return; }
+        // Keep incompressible blocks raw.
+        if (z < payload_.size()) {
+            stored_.resize(z);
+            body = &stored_;
+            bh.codec = LOBBIN_CODEC_ZSTD;
+        }
+    }
+#endif
+    bh.stored_bytes = (uint32_t)body->size();
+
+    if (std::fwrite(&bh, sizeof(bh), 1, fp_) != 1 ||
+        std::fwrite(body->data(), 1, body->size(), fp_) != body->size()) {
+        fail(std::string("block write failed: ") + std::strerror(errno));
+        return;
+    }
+    total_rows_ += n;
+    pending_.clear();
+}
+
+bool LobbinWriter::close() {
+    if (!fp_) return ok_;
+    flush_block();
+    if (ok_) {
+        LobbinFileHeader hdr{};
+        std::memcpy(hdr.magic, LOBBIN_MAGIC, sizeof(hdr.magic));
+        hdr.version = LOBBIN_VERSION;
+        hdr.total_rows = total_rows_;
+        if (std::fseek(fp_, 0, SEEK_SET) != 0 ||
+            std::fwrite(&hdr, sizeof(hdr), 1, fp_) != 1) {
+            fail("header rewrite failed");
+        }
+    }
+    if (std::fclose(fp_) != 0) fail(std::string("close failed: ") + std::strerror(errno));
+    fp_ = nullptr;
+    return ok_;
+}
+
+// ── Reader ──────────────────────────────────────────────────
+
+LobbinReader::LobbinReader(const std::string& path) : path_(path) {
+    fp_ = std::fopen(path.c_str(), "rb");
+    if (!fp_) return;
+    LobbinFileHeader hdr;
+    if (std::fread(&hdr, sizeof(hdr), 1, fp_) != 1 ||
+        std::memcmp(hdr.magic, LOBBIN_MAGIC, sizeof(hdr.magic)) != 0) {
+        std::cerr << "Error: " << path << " is not a .lobbin file" << std::endl;
+        return;
+    }
+    if (hdr.version != LOBBIN_VERSION) {
+        std::cerr << "Error: " << path << " has .lobbin version " << hdr.version
+                  << " (expected " << LOBBIN_VERSION << ")" << std::endl;
+        return;
+    }
+    total_rows_ = hdr.total_rows;
+    rows_.reserve(LOBBIN_BLOCK_ROWS);
+    ok_ = true;
+}
+
+LobbinReader::~LobbinReader() {
+    if (fp_) std::fclose(fp_);
+}
+
+// Read and decode the next block into rows_.  False at EOF or on a
+// corrupt block (reported once; the reader then stops).  Running out of
+// blocks before the header's total_rows is corruption too: a file cut
+// on a block boundary looks like a clean EOF.
+bool LobbinReader::load_block() {
+    block_first_ += rows_.size();
+    rows_.clear();
+    pos_ = 0;
+
+    auto corrupt = [&](const std::string& why) {
+        std::cerr << "Error: " << path_ << ": corrupt .lobbin block (" << why << ")" << std::endl;
+        ok_ = false;
+        return false;
+    };
+
+    LobbinBlockHeader bh;
+    if (std::fread(&bh, sizeof(bh), 1, fp_) != 1) {
+        if (block_first_ == total_rows_) return false;   // clean EOF
+        return corrupt("file ends after " + std::to_string(block_first_) + " of " +
+                       std::to_string(total_rows_) + " rows");
+    }
+    if (bh.rows == 0) return corrupt("no rows");
+
+    size_t col_total = 0;
+    for (uint32_t c : bh.col_bytes) col_total += c;
+    if (col_total != bh.raw_bytes) return corrupt("column sizes");
+
+    stored_.resize(bh.stored_bytes);
+    if (std::fread(stored_.data(), 1, stored_.size(), fp_) != stored_.size())
+        return corrupt("truncated");
+
+    const std::vector<uint8_t>* body = &stored_;
+    if (bh.codec == LOBBIN_CODEC_ZSTD) {
+#ifdef LOBBIN_ZSTD
+        payload_.resize(bh.raw_bytes);
+        size_t z = ZSTD_decompress(payload_.data(), payload_.size(),
+                                   stored_.data(), stored_.size());
+        if (ZSTD_isError(z) || z != bh.raw_bytes) return corrupt("zstd");
+        body = &payload_;
+#else
+        return corrupt("zstd block, but this build has no zstd (make ZSTD=1)");
+#endif
+    } else if (bh.codec != LOBBIN_CODEC_RAW || bh.stored_bytes != bh.raw_bytes) {
+        return corrupt("codec");
+    }
+
+    const size_t n = bh.rows;
+    rows_.resize(n);
+    const uint8_t* col = body->data();
+
+    // time
+    const uint8_t* p = col;
+    const uint8_t* end = col + bh.col_bytes[0];
+    int64_t ns = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t v;
+        if (!get_varint(p, end, v)) return corrupt("time");
+        if (v == 1) {
+            if (end - p < 8) return corrupt("time");
+            std::memcpy(&rows_[i].time, p, 8);
+            p += 8;
+        } else {
+            ns += unzigzag(v >> 1);
+            rows_[i].time = (double)ns / 1e9;
+        }
+    }
+    col = end;
+
+    // type, direction
+    if (bh.col_bytes[1] != n || bh.col_bytes[2] != n) return corrupt("int8 columns");
+    for (size_t i = 0; i < n; ++i) rows_[i].type = (int8_t)col[i];
+    col += n;
+    for (size_t i = 0; i < n; ++i) rows_[i].direction = (int8_t)col[i];
+    col += n;
+
+    // order_id, size, price
+    p = col; end = col + bh.col_bytes[3];
+    int64_t id = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t v;
+        if (!get_varint(p, end, v)) return corrupt("order_id");
+        id += unzigzag(v);
+        rows_[i].order_id = (long)id;
+    }
+    col = end;
+    p = col; end = col + bh.col_bytes[4];
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t v;
+        if (!get_varint(p, end, v)) return corrupt("size");
+        rows_[i].size = (int)(int64_t)v;
+    }
+    col = end;
+    p = col; end = col + bh.col_bytes[5];
+    int64_t px = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t v;
+        if (!get_varint(p, end, v)) return corrupt("price");
+        px += unzigzag(v);
+        rows_[i].price = (int)px;
+    }
+    return true;
+}
+
+size_t LobbinReader::next_batch(LobsterMessage* out, size_t cap) {
+    if (!ok_) return 0;
+    size_t n = 0;
+    while (n < cap) {
+        if (pos_ == rows_.size() && !load_block()) break;
+        size_t take = std::min(cap - n, rows_.size() - pos_);
+        std::memcpy(out + n, rows_.data() + pos_, take * sizeof(LobsterMessage));
+        pos_ += take;
+        n += take;
+    }
+    return n;
+}
+
+bool LobbinReader::seek(uint64_t row) {
+    if (!ok_ || row > total_rows_) return false;
+    if (std::fseek(fp_, (long)sizeof(LobbinFileHeader), SEEK_SET) != 0) return false;
+    rows_.clear();
+    pos_ = 0;
+    block_first_ = 0;
+    LobbinBlockHeader bh;
+    while (std::fread(&bh, sizeof(bh), 1, fp_) == 1) {
+        if (block_first_ + bh.rows > row) {
+            if (std::fseek(fp_, -(long)sizeof(bh), SEEK_CUR) != 0 || !load_block()) return false;
+            pos_ = (size_t)(row - block_first_);
+            return true;
+        }
+        if (std::fseek(fp_, (long)bh.stored_bytes, SEEK_CUR) != 0) return false;
+        block_first_ += bh.rows;
+    }
+    return row == block_first_;                // end of the day
+}
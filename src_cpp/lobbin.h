@@ -0,0 +1,133 @@
+#ifndef LOBBIN_H
+#define LOBBIN_H
+
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+#include "types.h"
+
+// ─────────────────────────────────────────────────────────────
+// .lobbin — binary columnar cache of one LOBSTER message day
+// ─────────────────────────────────────────────────────────────
+//
+// Written by lobster_pack, read transparently by LobsterParser
+// (any path ending in ".lobbin").  Replaying a .lobbin yields the
+// exact LobsterMessage sequence the CSV parser would produce.
+//
+// File layout (all integers little-endian):
+//
+//   FileHeader   magic "LOBBIN1\0", version, flags, total rows
+//   Block × N    until EOF
+//
+//   Block:  BlockHeader  then  payload (stored_bytes, raw or zstd)
+//   Payload (after decompression) is six columns back to back:
+//     time       per row: varint(zigzag(Δns) << 1)            exact ns
+//                     or: varint(1) + 8 raw IEEE bytes         escape
+//     type       int8  × rows
+//     direction  int8  × rows
+//     order_id   varint(zigzag(order_id − prev order_id)) × rows
+//     size       varint((uint64)size) × rows      (sizes are ≥ 0)
+//     price      varint(zigzag(price − prev price)) × rows
+//
+//   Δ state (ns, order_id, price) starts at 0 in every block, so
+//   blocks decode independently.  A time is stored as ns when
+//   (double)ns / 1e9 reproduces the parsed double bit-for-bit —
+//   always true for LOBSTER's ≤ 9-decimal timestamps.
+// ─────────────────────────────────────────────────────────────
+
+constexpr uint32_t LOBBIN_VERSION    = 1;
+constexpr uint32_t LOBBIN_BLOCK_ROWS = 65536;
+
+enum LobbinCodec : uint32_t { LOBBIN_CODEC_RAW = 0, LOBBIN_CODEC_ZSTD = 1 };
+
+struct LobbinFileHeader {
+    char     magic[8];     // "LOBBIN1\0"
+    uint32_t version;
+    uint32_t flags;        // reserved, 0
+    uint64_t total_rows;
+};
+
+struct LobbinBlockHeader {
+    uint32_t rows;
+    uint32_t codec;        // LobbinCodec
+    uint32_t raw_bytes;    // payload size after decompression
+    uint32_t stored_bytes; // payload size on disk
+    uint32_t col_bytes[6]; // time, type, direction, order_id, size, price
+};
+
+// True if `path` names a .lobbin day file.
+bool is_lobbin_path(const std::string& path);
+
+// True if this build can read/write zstd-compressed blocks (make ZSTD=1).
+bool lobbin_has_zstd();
+
+// Streaming writer: push rows in file order, then close().
+class LobbinWriter {
+public:
+    // zstd_level 0 stores raw blocks; > 0 requires lobbin_has_zstd().
+    LobbinWriter(const std::string& path, int zstd_level = 0);
+    ~LobbinWriter();
+
+    LobbinWriter(const LobbinWriter&) = delete;
+    LobbinWriter& operator=(const LobbinWriter&) = delete;
+
+    bool ok() const { return ok_; }
+    const std::string& error() const { return error_; }
+
+    // Fails (ok() == false) if type/direction do not fit in int8.
+    bool push(const LobsterMessage& msg);
+
+    // Flush the last block and finalise the header.  Returns ok().
+    bool close();
+
+private:
+    FILE* fp_ = nullptr;
+    int zstd_level_;
+    bool ok_ = true;
+    std::string error_;
+    uint64_t total_rows_ = 0;
+    std::vector<LobsterMessage> pending_;
+    std::vector<uint8_t> payload_, stored_;
+
+    void flush_block();
+    void fail(const std::string& why);
+};
+
+// Block-at-a-time reader with the LobsterParser batch interface.
+class LobbinReader {
+public:
+    explicit LobbinReader(const std::string& path);
+    ~LobbinReader();
+
+    LobbinReader(const LobbinReader&) = delete;
+    LobbinReader& operator=(const LobbinReader&) = delete;
+
+    // False if the file did not open, or once a block turned out
+    // corrupt or the blocks ended short of total_rows() (reported once;
+    // the reader then stops).
+    bool ok() const { return ok_; }
+    uint64_t total_rows() const { return total_rows_; }
+
+    size_t next_batch(LobsterMessage* out, size_t cap);
+
+    // Rows consumed so far / continue from row `row` (skips whole
+    // blocks by their headers, decodes only the one holding `row`).
+    uint64_t tell() const { return block_first_ + pos_; }
+    bool     seek(uint64_t row);
+
+private:
+    std::string path_;
+    FILE* fp_ = nullptr;
+    bool ok_ = false;
+    uint64_t total_rows_ = 0;
+    std::vector<LobsterMessage> rows_;   // decoded current block
+    size_t pos_ = 0;
+    uint64_t block_first_ = 0;           // row number of rows_[0]
+    std::vector<uint8_t> payload_, stored_;
+
+    bool load_block();
+};
+
+#endif
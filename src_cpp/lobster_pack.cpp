@@ -0,0 +1,255 @@
+// ─────────────────────────────────────────────────────────────
+// lobster_pack.cpp  –  LOBSTER message CSV → .lobbin converter
+// ─────────────────────────────────────────────────────────────
+//
+// Input:  one *_message_*.csv, or a stock folder of them.
+// Output: a .lobbin next to each CSV (or under -o <dir>) that
+//         data_processor / passive_data_processor pick up in place
+//         of the CSV.  Format: see lobbin.h.
+//
+// Every file is written to <name>.lobbin.tmp, re-read and compared
+// row-by-row against the CSV, and only then renamed into place, so
+// a .lobbin on disk is always a verified copy.  With -r 1 the CSV
+// is deleted after verification (quota relief on scratch).
+// ─────────────────────────────────────────────────────────────
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <cstdio>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "parser.h"
+#include "lobbin.h"
+
+constexpr size_t PACK_BATCH = 4096;
+
+static bool is_directory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+static long long file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (long long)st.st_size : -1;
+}
+
+// All *message*.csv files in a folder, sorted by name.
+static std::vector<std::string> find_csv_message_files(const std::string& folder) {
+    std::vector<std::string> files;
+    DIR* dir = opendir(folder.c_str());
+    if (!dir) return files;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name.find("message") != std::string::npos &&
+            name.size() > 4 && name.substr(name.size() - 4) == ".csv") {
+            std::string path = folder;
+            if (!path.empty() && path.back() != '/') path += '/';
+            files.push_back(path + name);
+        }
+    }
+    closedir(dir);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+// .../X_message_10.csv → <out_dir or same dir>/X_message_10.lobbin
+static std::string lobbin_path_for(const std::string& csv, const std::string& out_dir) {
+    std::string base = csv.substr(0, csv.size() - 4) + ".lobbin";
+    if (out_dir.empty()) return base;
+    auto slash = base.rfind('/');
+    std::string fname = (slash != std::string::npos) ? base.substr(slash + 1) : base;
+    std::string dir = out_dir;
+    if (dir.back() != '/') dir += '/';
+    return dir + fname;
+}
+
+static bool same_message(const LobsterMessage& a, const LobsterMessage& b) {
+    return std::memcmp(&a.time, &b.time, sizeof(double)) == 0 &&
+           a.type == b.type && a.order_id == b.order_id && a.size == b.size &&
+           a.price == b.price && a.direction == b.direction;
+}
+
+struct PackResult {
+    bool ok = false;
+    long long rows = 0;
+    long long csv_bytes = 0;
+    long long bin_bytes = 0;
+    std::string error;
+};
+
+static PackResult pack_one(const std::string& csv, const std::string& out_path, int zstd_level) {
+    PackResult res;
+    res.csv_bytes = file_size(csv);
+    const std::string tmp = out_path + ".tmp";
+
+    // 1. Encode.  A CSV that cannot be read in full is never packed: an
+    // empty or short .lobbin would shadow it in the processors.
+    {
+        LobsterParser parser(csv);
+        if (parser.failed()) {
+            res.error = "cannot open the CSV";
+            return res;
+        }
+        LobbinWriter writer(tmp, zstd_level);
+        std::vector<LobsterMessage> batch(PACK_BATCH);
+        size_t n;
+        while (writer.ok() && (n = parser.next_batch(batch.data(), batch.size())) > 0) {
+            for (size_t k = 0; k < n && writer.push(batch[k]); ++k) {}
+            res.rows += (long long)n;
+        }
+        if (parser.failed()) {
+            writer.close();
+            res.error = "read error in the CSV after " + std::to_string(res.rows) + " rows";
+            std::remove(tmp.c_str());
+            return res;
+        }
+        if (!writer.close()) {
+            res.error = writer.error();
+            std::remove(tmp.c_str());
+            return res;
+        }
+    }
+
+    // 2. Verify against a fresh CSV parse
+    {
+        LobsterParser csv_parser(csv);
+        LobbinReader  bin_reader(tmp);
+        std::vector<LobsterMessage> a(PACK_BATCH), b(PACK_BATCH);
+        long long row = 0;
+        while (true) {
+            size_t na = csv_parser.next_batch(a.data(), a.size());
+            size_t nb = bin_reader.next_batch(b.data(), b.size());
+            if (na != nb) { res.error = "row count mismatch near row " + std::to_string(row); break; }
+            if (na == 0) break;
+            for (size_t k = 0; k < na; ++k, ++row) {
+                if (!same_message(a[k], b[k])) {
+                    res.error = "row " + std::to_string(row + 1) + " differs after round-trip";
+                    break;
+                }
+            }
+            if (!res.error.empty()) break;
+        }
+        if (res.error.empty() && (csv_parser.failed() || !bin_reader.ok()))
+            res.error = "could not re-read both files in full";
+        if (!res.error.empty()) {
+            std::remove(tmp.c_str());
+            return res;
+        }
+    }
+
+    // 3. Publish
+    if (std::rename(tmp.c_str(), out_path.c_str()) != 0) {
+        res.error = std::string("rename failed: ") + std::strerror(errno);
+        std::remove(tmp.c_str());
+        return res;
+    }
+    res.bin_bytes = file_size(out_path);
+    res.ok = true;
+    return res;
+}
+
+void print_usage(const char* prog) {
+    std::cerr << "Usage: " << prog << " <message_csv | stock_folder> [options]\n"
+              << "  Converts LOBSTER *_message_*.csv day files to .lobbin.\n"
+              << "Options:\n"
+              << "  -o <dir>        output directory           (default: next to each CSV)\n"
+              << "  -z <level>      zstd level, 0 = raw blocks (default: "
+              << (lobbin_has_zstd() ? 3 : 0) << ")\n"
+              << "  -j <workers>    files converted in parallel (default: 1)\n"
+              << "  -r <0|1>        remove each CSV once its .lobbin is verified (default: 0)\n";
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::string input = argv[1];
+    std::string out_dir;
+    int zstd_level = lobbin_has_zstd() ? 3 : 0;
+    int workers = 1;
+    bool remove_csv = false;
+
+    for (int i = 2; i < argc; i += 2) {
+        if (i + 1 >= argc) break;
+        std::string opt = argv[i];
+        if      (opt == "-o") out_dir    = argv[i+1];
+        else if (opt == "-z") zstd_level = std::max(0, std::stoi(argv[i+1]));
+        else if (opt == "-j") workers    = std::max(1, std::stoi(argv[i+1]));
+        else if (opt == "-r") remove_csv = std::stoi(argv[i+1]) != 0;
+    }
+
+    if (zstd_level > 0 && !lobbin_has_zstd()) {
+        std::cerr << "Error: -z " << zstd_level << " needs a zstd build (make ZSTD=1)\n";
+        return 1;
+    }
+
+    std::vector<std::string> csvs = is_directory(input)
+        ? find_csv_message_files(input)
+        : std::vector<std::string>{input};
+    if (csvs.empty()) {
+        std::cerr << "Error: No *_message_*.csv files found in " << input << "\n";
+        return 1;
+    }
+
+    std::cout << "Packing " << csvs.size() << " file(s)  zstd=" << zstd_level
+              << "  workers=" << workers << "  remove_csv=" << remove_csv << "\n";
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<PackResult> results(csvs.size());
+    std::atomic<size_t> next_idx{0};
+    std::mutex log_mutex;
+
+    auto worker = [&]() {
+        while (true) {
+            size_t i = next_idx.fetch_add(1);
+            if (i >= csvs.size()) break;
+            std::string out_path = lobbin_path_for(csvs[i], out_dir);
+            PackResult r = pack_one(csvs[i], out_path, zstd_level);
+            if (r.ok && remove_csv) std::remove(csvs[i].c_str());
+            results[i] = r;
+
+            std::lock_guard<std::mutex> lk(log_mutex);
+            if (r.ok) {
+                std::cout << "  " << out_path << " … " << r.rows << " rows, "
+                          << std::fixed << std::setprecision(2)
+                          << (r.bin_bytes > 0 ? (double)r.csv_bytes / r.bin_bytes : 0.0)
+                          << "x smaller\n";
+            } else {
+                std::cerr << "  FAILED " << csvs[i] << ": " << r.error << "\n";
+            }
+        }
+    };
+
+    int nthreads = std::min<int>(workers, (int)csvs.size());
+    std::vector<std::thread> pool;
+    for (int t = 0; t < nthreads; ++t) pool.emplace_back(worker);
+    for (auto& th : pool) th.join();
+
+    long long csv_total = 0, bin_total = 0;
+    size_t failed = 0;
+    for (const auto& r : results) {
+        if (!r.ok) { ++failed; continue; }
+        csv_total += r.csv_bytes;
+        bin_total += r.bin_bytes;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    std::cout << "\nPacked " << (csvs.size() - failed) << "/" << csvs.size() << " file(s): "
+              << csv_total << " → " << bin_total << " bytes ("
+              << std::fixed << std::setprecision(2)
+              << (bin_total > 0 ? (double)csv_total / bin_total : 0.0) << "x)\n"
+              << "Elapsed seconds: " << std::setprecision(1) << elapsed << "\n";
+    return failed ? 1 : 0;
+}
@@ -2,9 +2,13 @@
 // main.cpp  –  Burst Detection with Top-of-Book Reconstruction
 // ─────────────────────────────────────────────────────────────
 //
-// Input:  A stock folder containing one *_message_0.csv per day.
+// Input:  A stock folder containing one *_message_0.csv per day
+//         (or its .lobbin cache written by lobster_pack).
 //         Each day file starts with pre-open orders (~4 AM) so the
 //         full visible book can be reconstructed from scratch.
+//         Or "-" / a FIFO carrying the day files back to back, e.g.
+//         7z x -so TICKER.7z '*message*' | data_processor - out.csv
+//         (see LobsterDayStream in parser.h for day splitting).
 //
 // Output: A single CSV with all bursts across all days, including:
 //         Ticker, Date, forward-return mid-prices, and close mid.
@@ -25,16 +29,33 @@
 #include <thread>
 #include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
 #include <cerrno>
 #include <cstring>
+#include <cstdio>
+#include <cctype>
+#include <functional>
+#include <memory>
 #include <dirent.h>
+#include <sys/stat.h>
 #include <numeric>
 
 #include "parser.h"
 #include "types.h"
 #include "burst.h"
 #include "orderbook.h"
+#include "daysum.h"
+#include "book_index.h"
+#include "spsc_queue.h"
+#include "work_steal.h"
+#include "mem_budget.h"
+#include "ring_buffer.h"
+#include "rolling.h"
+#include "timeline.h"
+#include "forward.h"
+#include "burst_table.h"
+#include "output_writer.h"
 
 // ── Helpers ─────────────────────────────────────────────────
 
@@ -45,7 +66,20 @@
 constexpr double RTH_DEFAULT_START = 34200.0;   // 09:30
 constexpr double RTH_DEFAULT_END   = 57600.0;   // 16:00
 
-// Collect all *message*.csv files in a directory, sorted by name (= by date).
+// With -j, finished days waiting for an earlier one to commit are
+// bounded by this many per worker (see the worker pool).
+constexpr size_t REORDER_DAYS_PER_WORKER = 4;
+
+// Day footprint per byte of day file (CSV / .lobbin), for --mem-budget
+// estimates before any footprint has been recorded.
+constexpr double DEFAULT_MEM_PER_BYTE[2] = {3.0, 10.0};
+
+// Rows handed out per LobsterParser::next_batch call.  4096 × 32 B keeps
+// the batch comfortably inside L1/L2 while amortising the call overhead.
+constexpr size_t PARSE_BATCH = 4096;
+
+// Collect all *message*.csv / *message*.lobbin files in a directory, sorted by
+// name (= by date).  When a day exists in both forms the .lobbin wins.
 std::vector<std::string> find_message_files(const std::string& folder) {
     std::vector<std::string> files;
     DIR* dir = opendir(folder.c_str());
@@ -54,8 +88,9 @@ std::vector<std::string> find_message_files(const std::string& folder) {
     struct dirent* entry;
     while ((entry = readdir(dir)) != nullptr) {
         std::string name = entry->d_name;
+        bool is_csv = name.size() > 4 && name.substr(name.size() - 4) == ".csv";
         if (name.find("message") != std::string::npos &&
-            name.size() > 4 && name.substr(name.size() - 4) == ".csv") {
+            (is_csv || is_lobbin_path(name))) {
             // Ensure folder path ends with '/'
             std::string path = folder;
             if (!path.empty() && path.back() != '/') path += '/';
@@ -64,7 +99,17 @@ std::vector<std::string> find_message_files(const std::string& folder) {
     }
     closedir(dir);
     std::sort(files.begin(), files.end());
-    return files;
+
+    // Drop X.csv when X.lobbin is also present.
+    std::vector<std::string> unique;
+    for (const auto& f : files) {
+        if (!is_lobbin_path(f)) {
+            std::string packed = f.substr(0, f.size() - 4) + ".lobbin";
+            if (std::binary_search(files.begin(), files.end(), packed)) continue;
+        }
+        unique.push_back(f);
+    }
+    return unique;
 }
 
 // Extract date from filename: TICKER_2026-01-02_..._message_0.csv → "2026-01-02"
@@ -90,69 +135,6 @@ std::string extract_ticker(const std::string& folder) {
     return (upos != std::string::npos) ? dirname.substr(0, upos) : dirname;
 }
 
-// Binary-search the mid-price snapshot timeline for the value at (or just before) target_time.
-double lookup_mid(const std::vector<std::pair<double, double>>& snaps, double target_time) {
-    if (snaps.empty()) return 0.0;
-    if (target_time <= snaps.front().first) return snaps.front().second;
-    if (target_time >= snaps.back().first)  return snaps.back().second;
-
-    // upper_bound gives the first element with time > target_time
-    auto it = std::upper_bound(
-        snaps.begin(), snaps.end(), target_time,
-        [](double t, const std::pair<double, double>& p) { return t < p.first; });
-
-    // Step back to the snapshot at or just before target_time
-    if (it != snaps.begin()) --it;
-    return it->second;
-}
-
-struct BboSnapshot {
-    double time;
-    double bid;
-    double ask;
-};
-
-// Binary-search the BBO snapshot timeline for bid/ask at (or just before) target_time.
-std::pair<double, double> lookup_bbo(const std::vector<BboSnapshot>& snaps, double target_time) {
-    if (snaps.empty()) return {0.0, 0.0};
-    if (target_time <= snaps.front().time) return {snaps.front().bid, snaps.front().ask};
-    if (target_time >= snaps.back().time)  return {snaps.back().bid, snaps.back().ask};
-
-    auto it = std::upper_bound(
-        snaps.begin(), snaps.end(), target_time,
-        [](double t, const BboSnapshot& p) { return t < p.time; });
-
-    if (it != snaps.begin()) --it;
-    return {it->bid, it->ask};
-}
-
-// Scan mid-price snapshots to find the most extreme price within [start_time, start_time + tau_max].
-// This is the true forward-looking PeakImpact defined by the proposal.
-double find_peak_price(const std::vector<std::pair<double, double>>& snaps,
-                       double start_time, double start_price, double tau_max, int direction) {
-    if (snaps.empty()) return start_price;
-
-    // Binary search to the first snapshot at or after start_time
-    auto it = std::lower_bound(snaps.begin(), snaps.end(), start_time,
-        [](const std::pair<double, double>& p, double t) { return p.first < t; });
-
-    double end_time = start_time + tau_max;
-    double max_p = start_price;
-    double min_p = start_price;
-
-    while (it != snaps.end() && it->first <= end_time) {
-        max_p = std::max(max_p, it->second);
-        min_p = std::min(min_p, it->second);
-        ++it;
-    }
-
-    if (direction == 1)  return max_p;   // Buy burst → highest price reached
-    if (direction == -1) return min_p;   // Sell burst → lowest price reached
-
-    // Mixed: whichever moved further from start
-    return (std::abs(max_p - start_price) >= std::abs(min_p - start_price)) ? max_p : min_p;
-}
-
 // ── Per-day burst record with forward-return data ───────────
 
 // ── Market state snapshot — captured at burst START time ─────
@@ -166,19 +148,13 @@ struct MarketState {
     int    bid_depth_5;       // total bid volume across top 5 levels
     int    ask_depth_5;       // total ask volume across top 5 levels
     double book_imbalance;    // (bid_depth_5 − ask_depth_5) / (bid + ask)
-    double volatility_60s;    // realised volatility of mid-returns, 60 s window
-    double momentum_5s;       // mid-price change over prior 5 seconds
-    double momentum_30s;      //   ... 30 seconds
-    double momentum_60s;      //   ... 60 seconds
+    double volatility[MAX_FEATURE_WINDOWS];   // realised volatility of mid-returns, per -V window
+    double momentum[MAX_FEATURE_WINDOWS];     // relative mid change over each -M lag
     int    trade_count_5m;    // number of trades in prior 5 minutes
     int    trade_volume_5m;   // total shares traded in prior 5 minutes
-};
-
-// ── Cancel event for Path 3: Pre-Burst Quote Depletion ──────
-struct CancelEvent {
-    double time;
-    int    direction;   // 1 = bid-side cancel, -1 = ask-side cancel
-    int    size;
+    int    bid_levels[BOOK_TOP_LEVELS];   // size at bid levels L1..L10 (0 = none)
+    int    ask_levels[BOOK_TOP_LEVELS];   // size at ask levels L1..L10
+    CancelTotals pre_cancels[MAX_FEATURE_WINDOWS];   // Path 3: cancels by side, per -w window
 };
 
 struct BurstRecord {
@@ -188,40 +164,419 @@ struct BurstRecord {
     double close_mid;
     double end_bid;
     double end_ask;
-    double mid_1m;      // mid at end_time + 60 s
-    double mid_3m;      // mid at end_time + 180 s
-    double mid_5m;      // mid at end_time + 300 s
-    double mid_10m;     // mid at end_time + 600 s
+    double mids[MAX_HORIZONS];   // mid at end_time + each -T horizon (or at the close)
     double d_b;         // short-horizon decay metric
     MarketState mkt;    // book state at burst start
 };
 
+// ── Output row ──────────────────────────────────────────────
+
+// Names of the columns set by the run's -T / -V / -M / -w lists, and
+// of the book levels; a Config column under -G.
+struct OutputColumns {
+    std::vector<std::string> mids, volatility, momentum;
+    std::vector<std::string> cancels;   // four per -w window
+    std::vector<std::string> bid_levels, ask_levels;
+    bool config;
+
+    OutputColumns(const std::vector<Horizon>& horizons, const FeatureWindows& fw, bool grid)
+        : config(grid) {
+        for (const Horizon& h : horizons) mids.push_back("Mid_" + h.label);
+        for (double w : fw.volatility)    volatility.push_back("Volatility" + window_label(w));
+        for (double l : fw.momentum)      momentum.push_back("Momentum" + window_label(l));
+        for (double w : fw.cancels) {
+            const std::string l = window_label(w);
+            for (const char* c : {"PreBidCancelCount", "PreAskCancelCount", "PreBidCancelVolume", "PreAskCancelVolume"})
+                cancels.push_back(c + l);
+        }
+        for (int k = 1; k <= BOOK_TOP_LEVELS; ++k) {
+            bid_levels.push_back("BidL" + std::to_string(k));
+            ask_levels.push_back("AskL" + std::to_string(k));
+        }
+    }
+};
+
+// One output row, column by column, into a burst_table.h sink: the CSV
+// header and rows and the .bcol columns all come from here.
+template <class Sink>
+void burst_row(Sink& s, const BurstRecord& rec, const OutputColumns& oc) {
+    const Burst& b = rec.burst;
+    const MarketState& ms = rec.mkt;
+    s.text("Ticker", rec.ticker);
+    s.text("Date", rec.date);
+    if (oc.config) s.integer("Config", b.config);
+    s.integer("BurstID", b.id);
+    s.real("StartTime", b.start_time, 6);
+    s.real("EndTime", b.end_time, 6);
+    s.integer("Direction", b.direction);
+    s.integer("Volume", b.volume);
+    s.integer("TradeCount", b.trade_count);
+    s.integer("BuyCount", b.buy_count);
+    s.integer("SellCount", b.sell_count);
+    s.integer("BuyVolume", b.buy_volume);
+    s.integer("SellVolume", b.sell_volume);
+    s.real("BuyRatio", b.buy_ratio, 6);
+    s.real("SellRatio", b.sell_ratio, 6);
+    s.real("MinMaxVolRatio", b.minmax_vol_ratio, 6);
+    s.real("D_b", rec.d_b, 6);
+    s.real("StartPrice", b.start_price, 4);
+    s.real("EndPrice", b.end_price, 4);
+    s.real("PeakPrice", b.peak_price, 4);
+    s.real("CloseMid", rec.close_mid, 4);
+    s.real("EndBid", rec.end_bid, 4);
+    s.real("EndAsk", rec.end_ask, 4);
+    for (size_t k = 0; k < oc.mids.size(); ++k) s.real(oc.mids[k].c_str(), rec.mids[k], 4);
+    s.real("Spread", ms.spread, 6);
+    s.integer("BidVolBest", ms.bid_vol_best);
+    s.integer("AskVolBest", ms.ask_vol_best);
+    s.integer("BidDepth5", ms.bid_depth_5);
+    s.integer("AskDepth5", ms.ask_depth_5);
+    s.real("BookImbalance", ms.book_imbalance, 6);
+    for (size_t w = 0; w < oc.volatility.size(); ++w) s.real(oc.volatility[w].c_str(), ms.volatility[w], 8);
+    for (size_t l = 0; l < oc.momentum.size(); ++l)   s.real(oc.momentum[l].c_str(), ms.momentum[l], 8);
+    s.integer("TradeCount5m", ms.trade_count_5m);
+    s.integer("TradeVolume5m", ms.trade_volume_5m);
+    s.real("TradeSizeVariance", b.trade_size_variance, 4);
+    s.real("RoundLotPct", b.round_lot_pct, 6);
+    s.real("TradeSizeSkew", b.trade_size_skew, 6);
+    s.real("TradeSizeEntropy", b.trade_size_entropy, 6);
+    s.real("InterTradeCV", b.inter_trade_cv, 6);
+    s.real("HawkesPeakIntensity", b.hawkes_peak_intensity, 4);
+    s.real("PreBurstCancelRate", b.preburst_cancel_rate, 6);
+    for (size_t w = 0; w < oc.cancels.size() / 4; ++w) {
+        const CancelTotals& c = ms.pre_cancels[w];
+        s.integer(oc.cancels[4 * w].c_str(),     c.bid_count);
+        s.integer(oc.cancels[4 * w + 1].c_str(), c.ask_count);
+        s.integer(oc.cancels[4 * w + 2].c_str(), c.bid_volume);
+        s.integer(oc.cancels[4 * w + 3].c_str(), c.ask_volume);
+    }
+    for (int k = 0; k < BOOK_TOP_LEVELS; ++k) s.integer(oc.bid_levels[k].c_str(), ms.bid_levels[k]);
+    for (int k = 0; k < BOOK_TOP_LEVELS; ++k) s.integer(oc.ask_levels[k].c_str(), ms.ask_levels[k]);
+}
+
 struct DayResult {
     std::string date;
     long msg_count = 0;
+    double resumed_at = -1.0;    // checkpoint time the replay started from
+    double stopped_at = -1.0;    // time of the row the replay stopped before
+    int    chunks = 1;           // intra-day chunks replayed in parallel (-S)
+    bool   pipelined = false;    // -Q: parse / book / detect stage queues
+    QueueStats parse_q, book_q, spare_q;
     size_t bbo_updates = 0;
     size_t burst_candidates = 0;
     size_t burst_kept = 0;
+    long long mem_peak = 0;      // measured footprint: heap peak + input mapping
+    long long mem_est  = 0;      // footprint reserved for it (--mem-budget)
+    long long allocs   = 0;      // heap allocations made by the day's replay
+};
+
+// A replayed day whose rows are formatted but not yet written.  In the
+// single-pass mode a day may run before its trailing-ADV threshold is
+// known; it then runs with no volume floor and the threshold is applied
+// when the day is committed (in date order, once all prior days are in).
+// Burst segmentation does not depend on the floor — it only gates which
+// finished bursts are emitted — so filtering afterwards is exact.
+struct PendingDay {
+    DayResult res;
+    DaySummary summary;                       // volumes etc., measured in the replay
+    OrderTableStats order_stats;              // book order-table sizing
+    std::vector<int> candidate_volumes;       // every burst the detector emitted
+    std::string csv;                          // rows of bursts that passed kappa (CSV)
+    std::vector<uint64_t> cells;              // ... or their .bcol cells (CellSink)
+    std::vector<std::string> texts;           // ... and text values
+    std::vector<std::pair<int, size_t>> rows; // (burst volume, end offset in csv / cells)
+    bool input_failed = false;                // the day file was not read in full
+};
+
+// One batch on its way through the pipelined replay (-Q): the parse
+// stage fills rows, the book stage the mid after each row and, for rows
+// the detector may close a burst on, the book's side of MarketState
+// (top[k] indexes tops; -1 = none).
+struct PipeBatch {
+    std::vector<LobsterMessage> rows;
+    std::vector<double> mid;
+    std::vector<int> top;
+    std::vector<MarketState> tops;
+};
+
+// A day, or one intra-day chunk of it, as replayed: every burst the
+// detector emitted with its lookups done, before the kappa filter and
+// formatting (which need the day's close).
+struct DayReplay {
+    DayResult res;
+    DaySummary summary;
+    OrderTableStats order_stats;
+    std::vector<BurstRecord> bursts;               // by detector config, then in time order
+    std::vector<double> next_start;                // per config; see ReplayWindow::own_to
+};
+
+// ─────────────────────────────────────────────────────────────
+// DayContext: a replay's working state, recycled day after day
+// ─────────────────────────────────────────────────────────────
+// A replay borrows one from the DayContextPool for its duration.
+// The book and its order table, the detector, the L1
+// timeline, the feature rings, the burst vectors and the CSV buffer
+// survive from one day to the next; begin_day() empties them but
+// keeps their capacity.  Once the pool's contexts have seen the
+// busiest days, a replay allocates almost nothing (allocs= on the
+// [done] line).
+struct DayContext {
+    OrderTable    orders;
+    OrderBook     book;
+    BurstDetector detector;
+
+    L1Timeline    timeline;                                 // BBO updates (timeline.h)
+    RollingFeatures features;                               // volatility / momentum / trades
+    CancelWindows cancels;                                  // pre-burst cancels
+    std::vector<CancelTotals> burst_cancels;                // per config: as of its open burst's start
+    std::vector<std::pair<Burst, MarketState>> day_bursts;  // burst + state at initiation
+    std::vector<uint32_t> lookup_order;                     // day_bursts in forward-lookup order
+    std::vector<uint32_t> record_row;                       // ... and where each one's record goes
+    std::vector<BurstRecord> bursts;   // lent to DayReplay::bursts; format_day returns it
+    std::vector<PipeBatch> pipe_batches;   // -Q stage buffers
+
+    DayContext(LadderKind ladder, const BurstDetector& proto, const FeatureWindows& windows)
+        : book(ladder, &orders), detector(proto) {
+        timeline.reserve(500000);
+        features.configure(windows);
+        cancels.configure(windows.cancels);
+        burst_cancels.resize(proto.configs() * windows.cancels.size());
+    }
+
+    void begin_day(OrderTableKind table, double min_volume) {
+        orders.set_kind(table);
+        book.reset();
+        book.unsubscribe_all();
+        detector.reset();
+        detector.set_min_volume(min_volume);
+        timeline.clear();
+        features.clear();
+        cancels.clear();
+        day_bursts.clear();
+        bursts.clear();
+    }
+};
+
+// Idle DayContexts.  There are only ever as many as replays have run
+// at once (-j workers, times -S chunks); most recently returned first.
+class DayContextPool {
+public:
+    DayContextPool(LadderKind ladder, const BurstDetector& proto, const FeatureWindows& windows)
+        : ladder_(ladder), proto_(proto), windows_(windows) {}
+
+    // A context for the holder's use until the lease ends.
+    class Lease {
+    public:
+        explicit Lease(DayContextPool& pool) : pool_(pool), ctx_(pool.take()) {}
+        ~Lease() { pool_.give(std::move(ctx_)); }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+        DayContext& operator*() const { return *ctx_; }
+    private:
+        DayContextPool& pool_;
+        std::unique_ptr<DayContext> ctx_;
+    };
+
+private:
+    const LadderKind    ladder_;
+    const BurstDetector proto_;
+    const FeatureWindows windows_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<DayContext>> idle_;
+
+    std::unique_ptr<DayContext> take() {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (!idle_.empty()) {
+                std::unique_ptr<DayContext> ctx = std::move(idle_.back());
+                idle_.pop_back();
+                return ctx;
+            }
+        }
+        return std::unique_ptr<DayContext>(new DayContext(ladder_, proto_, windows_));
+    }
+    void give(std::unique_ptr<DayContext> ctx) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        idle_.push_back(std::move(ctx));
+    }
 };
 
 // Compute total RTH trade volume (LOBSTER types 4/5) for one day file.
-long long compute_rth_trade_volume(const std::string& msg_file, double rth_start, double rth_end) {
-    LobsterParser parser(msg_file);
-    LobsterMessage msg;
+// Only used by the -A 2 pre-pass; the default mode measures the same sum
+// inside process_day.  -1 if the file could not be read in full.
+long long compute_rth_trade_volume(const std::string& msg_file, double rth_start, double rth_end,
+                                   ParseMode parse_mode) {
+    LobsterParser parser(msg_file, parse_mode);
+    std::vector<LobsterMessage> batch(PARSE_BATCH);
     long long vol = 0;
-    while (parser.next_message(msg)) {
-        if (msg.time < rth_start || msg.time > rth_end) continue;
-        if (msg.type == 4 || msg.type == 5) vol += (long long)msg.size;
+    size_t n;
+    while ((n = parser.next_batch(batch.data(), batch.size())) > 0) {
+        for (size_t k = 0; k < n; ++k) {
+            const LobsterMessage& msg = batch[k];
+            if (msg.time > rth_end) return vol;     // rows are in time order
+            if (msg.time < rth_start) continue;
+            if (msg.type == 4 || msg.type == 5) vol += (long long)msg.size;
+        }
+    }
+    return parser.failed() ? -1 : vol;
+}
+
+// Trailing average daily RTH trade volume, fed one day at a time in
+// strict date order.  With no history yet, a day is bootstrapped with
+// its own volume.
+struct TrailingAdv {
+    size_t window;
+    std::deque<long long> history;
+    long long sum = 0;
+
+    explicit TrailingAdv(size_t w) : window(w) {}
+
+    bool empty() const { return history.empty(); }
+
+    double value(long long day_vol) const {
+        return history.empty() ? (double)day_vol : (double)sum / (double)history.size();
+    }
+
+    void push(long long day_vol) {
+        history.push_back(day_vol);
+        sum += day_vol;
+        if (history.size() > window) {
+            sum -= history.front();
+            history.pop_front();
+        }
+    }
+};
+
+// A day's message rows, one batch at a time: points `rows` at the next
+// batch and returns its size (0 at end of day).
+using DaySource = std::function<size_t(const LobsterMessage*& rows)>;
+
+// Which rows of a day file a replay reads (see book_index.h).  The
+// default is every row from the first.
+struct ReplayWindow {
+    // Resume from this checkpoint: restore `start_book` and seek there.
+    const BookCheckpoint*       start = nullptr;
+    const std::vector<uint8_t>* start_book = nullptr;
+
+    // End-of-window pushdown: stop at the first row later than this.
+    // The day's totals then come from msg_count / close_mid.
+    double stop_after = std::numeric_limits<double>::infinity();
+    long   msg_count  = 0;
+    double close_mid  = 0.0;
+
+    // Take checkpoints while replaying (whole day only).
+    BookIndexWriter* record = nullptr;
+
+    // Intra-day chunk (-S): only rows timed in [own_from, own_to) are
+    // counted.  With own_to set, the detector stops once each of its
+    // configs has started a burst at or after own_to (DayReplay::
+    // next_start) or at the close, and rows are read on only until its
+    // bursts' lookups are covered.
+    double own_from = -std::numeric_limits<double>::infinity();
+    double own_to   =  std::numeric_limits<double>::infinity();
+
+    std::function<uint64_t()>     tell;   // position of the next row
+    std::function<bool(uint64_t)> seek;
+};
+
+// Trailing window of the per-day volume threshold, in days.
+constexpr size_t ADV_WINDOW = 14;
+
+// One ticker's run: its day files, what is known of them up front, the
+// ordered commit of its days and its output.  A plain run has one;
+// --universe has one per ticker and interleaves their days on one pool.
+struct TickerJob {
+    std::string ticker;
+    std::string stock_folder;
+    std::string output_file;
+    std::string log_tag;                           // "<ticker> " in log lines (universe)
+
+    std::vector<std::string> msg_files;
+    std::vector<std::string> day_dates;
+    std::vector<char> day_cached;                  // summary cache hit
+    std::vector<DaySummary> day_cache;
+    std::vector<double> known_floor;               // threshold known up front, or -1
+    std::vector<long long> day_bytes;              // file sizes
+    size_t cache_hits = 0;
+
+    // Ordered commit (see commit_ready_days), under commit_mutex.
+    std::mutex commit_mutex;
+    TrailingAdv adv{ADV_WINDOW};
+    std::vector<PendingDay> pending_days;
+    std::vector<char> day_ready;
+    std::vector<DayResult> day_results;
+    std::vector<long long> day_trade_volumes;
+    size_t next_commit = 0;
+    int out = -1;                                  // output file (OutputWriter)
+    std::condition_variable committed;             // next_commit moved
+    bool finished = false;                         // finish_job ran: the output is complete
+};
+
+// Day labels for unframed stream days (-D): one per line, either a date
+// or a LOBSTER file name the date is taken from.
+std::vector<std::string> read_day_labels(const std::string& path) {
+    std::vector<std::string> labels;
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Error: cannot open day label file '" << path << "'\n";
+        return labels;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        while (!line.empty() && std::isspace((unsigned char)line.back())) line.pop_back();
+        if (line.empty()) continue;
+        bool plain_date = line.size() == 10 && line[4] == '-' && line[7] == '-';
+        labels.push_back(plain_date ? line : extract_date(line));
+    }
+    return labels;
+}
+
+bool is_directory(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// File size in bytes, 0 if it cannot be stat'ed.
+long long file_size(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (long long)st.st_size : 0;
+}
+
+// Tickers of a universe file (--universe): one per line, '#' starts a
+// comment, blank lines and repeats are skipped.
+std::vector<std::string> read_universe(const std::string& path) {
+    std::vector<std::string> tickers;
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cerr << "Error: cannot open universe file " << path << "\n";
+        return tickers;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string t;
+        while (words >> t) {
+            if (std::find(tickers.begin(), tickers.end(), t) == tickers.end()) tickers.push_back(t);
+        }
     }
-    return vol;
+    if (tickers.empty()) std::cerr << "Error: universe file " << path << " lists no tickers\n";
+    return tickers;
 }
 
 // ── Usage ───────────────────────────────────────────────────
 
 void print_usage(const char* prog) {
-    std::cerr << "Usage: " << prog << " <stock_folder> <output_file> [options]\n"
-              << "  stock_folder: folder containing *_message_0.csv day files\n"
+    std::cerr << "Usage: " << prog << " <stock_folder | - | stream> <output_file> [options]\n"
+              << "       " << prog << " --universe <file> --root <dir> [--out <dir>] [options]\n"
+              << "  stock_folder: folder containing *_message_0.csv (or .lobbin) day files\n"
+              << "  - | stream:   stdin, a FIFO or a file carrying concatenated day CSVs,\n"
+              << "                split on '# <file or date>' lines / timestamp resets\n"
               << "  output_file:  output CSV path\n"
+              << "  --universe:   tickers, one per line; each one's day files are read from\n"
+              << "                <root>/<TICKER> and its bursts written to\n"
+              << "                <out>/bursts_<TICKER>_baseline.csv (out default: .).\n"
+              << "                All days of all tickers share one -j pool, largest first\n"
               << "Options:\n"
               << "  -s <silence>    silence threshold in seconds (legacy, used when -H 0)  (default: 1.0)\n"
               << "  -v <vol_frac>   burst volume fraction of trailing\n"
@@ -230,12 +585,50 @@ void print_usage(const char* prog) {
               << "  -r <vol_ratio>  volume ratio cap for directional   (default: 0.5)\n"
               << "  -k <kappa>      kappa filter parameter             (default: 0.5)\n"
               << "  -t <tau_max>    peak-impact horizon in seconds     (default: 10.0)\n"
+              << "  -T <h,...>      forward horizons, one Mid_<h> column each: 30s, 10m,\n"
+              << "                  2h, ... or close (mid at -e)  (default: 1m,3m,5m,10m;\n"
+              << "                  at most " << MAX_HORIZONS << "; D_b always uses 1m,3m,5m,10m)\n"
               << "  -j <workers>    number of parallel day workers     (default: 1)\n"
+              << "  -S <chunks>     split each day's RTH into <chunks> spans replayed\n"
+              << "                  on their own threads from book checkpoints; output\n"
+              << "                  is unchanged (default: 1; not for stream input)\n"
+              << "  -Q <batches>    pipelined replay: parse, book and detect stages on\n"
+              << "                  their own threads, joined by queues of <batches>\n"
+              << "                  (default: 0 = one thread; -S chunks other than the\n"
+              << "                  last, and index builds, stay on one thread)\n"
               << "  -b <rth_start>  RTH start in sec-past-midnight     (default: 34200 = 09:30)\n"
               << "  -e <rth_end>    RTH end   in sec-past-midnight     (default: 57600 = 16:00)\n"
               << "  -H <beta>       Hawkes decay rate (0=disable, use -s) (default: 1.0)\n"
               << "  -I <intensity>  Hawkes trigger intensity threshold (default: 0.5)\n"
-              << "  -w <window>     Pre-burst cancel window in seconds (default: 0.050)\n";
+              << "  -G <grid>       detector grid in one replay, e.g. \"beta=0.5,1,2 I=0.3,0.5\"\n"
+              << "                  (axes beta, I, s; others from -H / -I / -s); adds a\n"
+              << "                  Config column and a <output>_configs.csv key\n"
+              << "  -w <secs,...>   pre-burst cancel windows; each adds bid / ask cancel\n"
+              << "                  count and volume columns, the first also sets\n"
+              << "                  PreBurstCancelRate (default: 0.050; at most " << MAX_FEATURE_WINDOWS << ")\n"
+              << "  -V <secs,...>   volatility windows, one Volatility<W>s column each\n"
+              << "                  (default: 60; at most " << MAX_FEATURE_WINDOWS << ")\n"
+              << "  -M <secs,...>   momentum lags, one Momentum<L>s column each\n"
+              << "                  (default: 5,30,60; at most " << MAX_FEATURE_WINDOWS << ")\n"
+              << "  -P <mode>       input parser: mmap | stream        (default: mmap)\n"
+              << "  -B <ladder>     book price ladder: map | flat     (default: " << ladder_kind_name(DEFAULT_LADDER) << ")\n"
+              << "  -O <table>      book order table: hash | dense     (default: hash)\n"
+              << "  -A <passes>     1 = measure ADV during the replay, 2 = separate\n"
+              << "                  ADV pre-pass over every file      (default: 1)\n"
+              << "  -C <dir|off>    day summary cache (.daysum) folder (default: next to\n"
+              << "                  each day file); book indexes (.lobidx) go there too\n"
+              << "  -X <secs|off>   book index: build one with a checkpoint every <secs>\n"
+              << "                  of message time where missing; off = ignore indexes\n"
+              << "                  (default: use existing ones, build none)\n"
+              << "  -N <ticker>     ticker name (default: from folder / framing line)\n"
+              << "  -D <file>       stream input: dates for unframed days, one per line;\n"
+              << "                  a count that does not match is an error\n"
+              << "  --mem-budget <size>  admit a day to -j only while the estimated\n"
+              << "                  footprints of the days in flight fit in <size>\n"
+              << "                  (e.g. 6G, 512M); estimates come from footprints\n"
+              << "                  recorded in the summary cache (default: no limit)\n"
+              << "  --format <fmt>  csv | bcol: typed columnar file, one block per day, same\n"
+              << "                  columns as the CSV (src_py/burstcol.py) (default: csv)\n";
 }
 
 // ── Main ────────────────────────────────────────────────────
@@ -246,11 +639,41 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    std::string stock_folder = argv[1];
-    std::string output_file  = argv[2];
+    // Universe mode: --universe <file> --root <dir> [--out <dir>] before
+    // the options.  Otherwise the folder / stream and the output file.
+    std::string stock_folder, output_file;
+    std::string universe_file, universe_root, universe_out = ".";
+    int first_opt = 3;
+    const bool universe = std::string(argv[1]) == "--universe";
+    if (universe) {
+        for (first_opt = 1; first_opt + 1 < argc && std::string(argv[first_opt]).rfind("--", 0) == 0;
+             first_opt += 2) {
+            std::string opt = argv[first_opt];
+            if      (opt == "--universe") universe_file = argv[first_opt + 1];
+            else if (opt == "--root")     universe_root = argv[first_opt + 1];
+            else if (opt == "--out")      universe_out  = argv[first_opt + 1];
+            else if (opt == "--mem-budget" || opt == "--format") break;   // run options
+            else {
+                std::cerr << "Error: unknown option " << opt << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        }
+        if (universe_root.empty()) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (!is_directory(universe_out)) {
+            std::cerr << "Error: output folder '" << universe_out << "' does not exist\n";
+            return 1;
+        }
+    } else {
+        stock_folder = argv[1];
+        output_file  = argv[2];
+    }
 
     // Fail fast if output path is not writable (common shell continuation typo: "\\  ").
-    {
+    if (!universe) {
         std::ofstream out_probe(output_file);
         if (!out_probe.is_open()) {
             std::cerr << "Error: cannot open output file path: '" << output_file << "'\n"
@@ -271,9 +694,24 @@ int main(int argc, char* argv[]) {
     int workers                 = 1;
     double hawkes_beta          = 1.0;   // Hawkes decay rate (0 = legacy silence mode)
     double trigger_intensity    = 0.5;   // Hawkes trigger threshold
-    double cancel_window        = 0.050; // Pre-burst cancel lookback in seconds
-
-    for (int i = 3; i < argc; i += 2) {
+    ParseMode parse_mode        = ParseMode::MMAP;
+    LadderKind ladder           = DEFAULT_LADDER;
+    OrderTableKind order_table  = OrderTableKind::HASH;
+    std::string ticker;                  // -N; otherwise derived from the input
+    std::string day_label_file;          // -D (stream input only)
+    int adv_passes              = 1;     // -A: 1 = fused single pass, 2 = pre-pass
+    std::string summary_cache;           // -C: "" = beside day files, "off" = disabled
+    bool use_index              = true;  // -X off: ignore book indexes
+    double checkpoint_interval  = 0.0;   // -X secs: build indexes (0 = build none)
+    int day_chunks              = 1;     // -S: intra-day chunks per day file
+    int pipeline_depth          = 0;     // -Q: batches per stage queue (0 = one thread)
+    long long mem_budget        = 0;     // --mem-budget: bytes of days in flight (0 = no limit)
+    bool columnar               = false; // --format bcol: .bcol output instead of CSV
+    std::string detector_grid;           // -G: detector configurations, one replay
+    FeatureWindows feature_windows;      // -V / -M rolling feature windows
+    std::vector<Horizon> horizons = default_horizons();   // -T forward lookups
+
+    for (int i = first_opt; i < argc; i += 2) {
         if (i + 1 >= argc) break;
         std::string opt = argv[i];
         if      (opt == "-s") silence_threshold   = std::stod(argv[i+1]);
@@ -287,79 +725,275 @@ int main(int argc, char* argv[]) {
         else if (opt == "-e") rth_end             = std::stod(argv[i+1]);
         else if (opt == "-H") hawkes_beta         = std::stod(argv[i+1]);
         else if (opt == "-I") trigger_intensity   = std::stod(argv[i+1]);
-        else if (opt == "-w") cancel_window       = std::stod(argv[i+1]);
-    }
-
-    // ── Discover day files ──────────────────────────────────
-    auto msg_files = find_message_files(stock_folder);
-    if (msg_files.empty()) {
-        std::cerr << "Error: No *_message_*.csv files found in " << stock_folder << "\n";
-        return 1;
+        else if (opt == "-P") {
+            if (!parse_mode_from_string(argv[i+1], &parse_mode)) {
+                std::cerr << "Error: -P takes mmap or stream. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-B") {
+            if (!ladder_kind_from_string(argv[i+1], &ladder)) {
+                std::cerr << "Error: -B takes map or flat. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-O") {
+            if (!order_table_kind_from_string(argv[i+1], &order_table)) {
+                std::cerr << "Error: -O takes hash or dense. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-N") ticker              = argv[i+1];
+        else if (opt == "-D") day_label_file      = argv[i+1];
+        else if (opt == "-A") adv_passes          = (std::stoi(argv[i+1]) == 2) ? 2 : 1;
+        else if (opt == "-C") summary_cache       = argv[i+1];
+        else if (opt == "-S") day_chunks          = std::max(1, std::stoi(argv[i+1]));
+        else if (opt == "-Q") pipeline_depth      = std::max(0, std::stoi(argv[i+1]));
+        else if (opt == "-G") detector_grid       = argv[i+1];
+        else if (opt == "--mem-budget") {
+            mem_budget = parse_mem_size(argv[i+1]);
+            if (mem_budget < 0) {
+                std::cerr << "Error: --mem-budget takes a size such as 8G or 512M. Received: "
+                          << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "--format") {
+            const std::string f = argv[i+1];
+            if (f != "csv" && f != "bcol") {
+                std::cerr << "Error: --format takes csv or bcol. Received: " << f << "\n";
+                return 1;
+            }
+            columnar = f == "bcol";
+        }
+        else if (opt == "-V" || opt == "-M" || opt == "-w") {
+            std::vector<double> list = parse_window_list(argv[i+1]);
+            if (list.empty()) {
+                std::cerr << "Error: " << opt << " takes up to " << MAX_FEATURE_WINDOWS
+                          << " comma-separated windows in seconds, e.g. 5,30,60. Received: "
+                          << argv[i+1] << "\n";
+                return 1;
+            }
+            (opt == "-V" ? feature_windows.volatility
+             : opt == "-M" ? feature_windows.momentum : feature_windows.cancels) = list;
+        }
+        else if (opt == "-T") {
+            horizons = parse_horizons(argv[i+1]);
+            if (horizons.empty()) {
+                std::cerr << "Error: -T takes up to " << MAX_HORIZONS << " comma-separated horizons such as "
+                          << "30s,10m,1h,close. Received: " << argv[i+1] << "\n";
+                return 1;
+            }
+        }
+        else if (opt == "-X") {
+            use_index = std::string(argv[i+1]) != "off";
+            checkpoint_interval = use_index ? std::max(0.0, std::stod(argv[i+1])) : 0.0;
+        }
     }
 
-    std::string ticker = extract_ticker(stock_folder);
-
     if (volume_fraction < 0.0 || volume_fraction > 1.0) {
         std::cerr << "Error: -v must be a fraction in [0, 1]. Received: " << volume_fraction << "\n"
                   << "Example: -v 0.0001 means burst volume >= 0.01% of trailing 14-day avg daily RTH trade volume.\n";
         return 1;
     }
 
-    // Precompute per-day dynamic thresholds in strict date order.
+    // Detector configurations: -s / -H / -I, or the -G grid over them.
+    const DetectorConfig base_config{silence_threshold, hawkes_beta, trigger_intensity};
+    std::vector<DetectorConfig> detector_configs = {base_config};
+    size_t grid_points = 1;
+    if (!detector_grid.empty()) {
+        detector_configs = parse_detector_grid(detector_grid, base_config, &grid_points);
+        if (detector_configs.empty()) {
+            std::cerr << "Error: -G takes axes beta=, I= and s= with comma-separated values, e.g. "
+                      << "\"beta=0.5,1,2 I=0.3,0.5,0.8\" (at most " << MAX_DETECTOR_CONFIGS
+                      << " points). Received: " << detector_grid << "\n";
+            return 1;
+        }
+    }
+
+    // Forward lookups: the D_b horizons, then any other -T horizon;
+    // horizon_slot maps -T entries onto them.  A replay reads
+    // forward_reach past the close (and a -S chunk past its last burst
+    // start), and up to the close itself when -T asks for it.
+    std::vector<double> forward_offsets(std::begin(DECAY_HORIZONS), std::end(DECAY_HORIZONS));
+    std::vector<size_t> horizon_slot(horizons.size(), 0);
+    for (size_t k = 0; k < horizons.size(); ++k) {
+        if (horizons[k].close) continue;
+        auto it = std::find(forward_offsets.begin(), forward_offsets.end(), horizons[k].secs);
+        horizon_slot[k] = it - forward_offsets.begin();
+        if (it == forward_offsets.end()) forward_offsets.push_back(horizons[k].secs);
+    }
+    const double forward_reach = std::max({longest_horizon(horizons), DECAY_HORIZONS[3], tau_max});
+    const bool   close_horizon = has_close_horizon(horizons);
+    const double close_until   = close_horizon ? rth_end : 0.0;
+
+    // Per-day dynamic thresholds, in strict date order:
     // Threshold(day) = vol_frac * mean(RTH daily trade volume over prior 14 days).
     // For first day(s) with no prior history, bootstrap with current day volume.
-    const size_t ADV_WINDOW = 14;
-    std::vector<long long> day_trade_volumes(msg_files.size(), 0);
-    
-    // Parallelize the trade volume pre-computation
-    {
-        int nthreads_pre = std::min<int>(workers, (int)msg_files.size());
-        std::atomic<size_t> next_idx_pre{0};
-        std::atomic<size_t> done_pre{0};
-        std::vector<std::thread> pool_pre;
-        pool_pre.reserve(nthreads_pre);
-        for (int t = 0; t < nthreads_pre; ++t) {
-            pool_pre.emplace_back([&]() {
-                while (true) {
-                    size_t i = next_idx_pre.fetch_add(1);
-                    if (i >= msg_files.size()) break;
-                    day_trade_volumes[i] = compute_rth_trade_volume(msg_files[i], rth_start, rth_end);
-                    size_t d = done_pre.fetch_add(1) + 1;
-                    if (d % 20 == 0) {
-                        std::cout << "[ADV Precompute] " << d << "/" << msg_files.size() << " days done..." << std::endl;
+    // By default (-A 1) each day's volume is measured during its own replay and
+    // thresholds are applied as days are committed in order (see PendingDay).
+    // -A 2 keeps the separate pre-pass, so every day runs with its final floor.
+    // Days found in the summary cache (daysum.h) need neither.
+    //
+    // prepare_job discovers a ticker's day files and works out what it can
+    // before any replay.  A day file the pre-pass cannot read in full
+    // fails the run (unreadable_day), not just the ticker.
+    bool unreadable_day = false;
+    auto prepare_job = [&](TickerJob& job) -> bool {
+        job.msg_files = find_message_files(job.stock_folder);
+        if (job.msg_files.empty()) {
+            std::cerr << "Error: No *_message_*.csv / .lobbin files found in " << job.stock_folder << "\n";
+            return false;
+        }
+        const size_t n_days = job.msg_files.size();
+        job.day_cached.assign(n_days, 0);
+        job.day_cache.resize(n_days);
+        for (size_t i = 0; i < n_days; ++i) {
+            job.day_dates.push_back(extract_date(job.msg_files[i]));
+            job.day_bytes.push_back(file_size(job.msg_files[i]));
+            job.day_cached[i] = load_day_summary(job.msg_files[i], summary_cache, rth_start, rth_end,
+                                                 job.day_cache[i]);
+            job.cache_hits += job.day_cached[i];
+        }
+
+        // Parallelize the trade volume pre-computation
+        if (adv_passes == 2) {
+            std::vector<size_t> todo;
+            for (size_t i = 0; i < n_days; ++i) {
+                if (!job.day_cached[i]) todo.push_back(i);
+            }
+            int nthreads_pre = std::min<int>(workers, (int)todo.size());
+            std::atomic<size_t> next_idx_pre{0};
+            std::atomic<size_t> done_pre{0};
+            std::vector<std::thread> pool_pre;
+            pool_pre.reserve(nthreads_pre);
+            for (int t = 0; t < nthreads_pre; ++t) {
+                pool_pre.emplace_back([&]() {
+                    while (true) {
+                        size_t k = next_idx_pre.fetch_add(1);
+                        if (k >= todo.size()) break;
+                        size_t i = todo[k];
+                        job.day_cache[i].rth_trade_volume =
+                            compute_rth_trade_volume(job.msg_files[i], rth_start, rth_end, parse_mode);
+                        size_t d = done_pre.fetch_add(1) + 1;
+                        if (d % 20 == 0) {
+                            std::cout << "[ADV Precompute] " << job.log_tag << d << "/" << todo.size()
+                                      << " days done..." << std::endl;
+                        }
                     }
+                });
+            }
+            for (auto& th : pool_pre) th.join();
+            for (size_t i : todo) {
+                if (job.day_cache[i].rth_trade_volume < 0) {
+                    std::cerr << "Error: " << job.msg_files[i] << " could not be read in full\n";
+                    unreadable_day = true;
+                    return false;
                 }
-            });
+            }
+            std::cout << "[ADV Precompute] " << job.log_tag << "Completed all " << todo.size() << " days ("
+                      << job.cache_hits << " from cache)." << std::endl;
         }
-        for (auto& th : pool_pre) th.join();
-        std::cout << "[ADV Precompute] Completed all " << msg_files.size() << " days." << std::endl;
-    }
 
-    std::vector<double> day_min_volume_thresholds(msg_files.size(), 0.0);
-    std::deque<long long> adv_history;
-    long long adv_history_sum = 0;
-
-    for (size_t i = 0; i < msg_files.size(); ++i) {
-        long long day_vol = day_trade_volumes[i];
-
-        double trailing_adv = 0.0;
-        if (!adv_history.empty()) {
-            trailing_adv = (double)adv_history_sum / (double)adv_history.size();
-        } else {
-            trailing_adv = (double)day_vol;
+        // Thresholds computable before any replay: day i needs the volumes of
+        // days < i (and its own volume for i = 0), from the cache or pre-pass.
+        job.known_floor.assign(n_days, -1.0);
+        TrailingAdv adv(ADV_WINDOW);
+        for (size_t i = 0; i < n_days; ++i) {
+            bool have_vol = job.day_cached[i] || adv_passes == 2;
+            if (i == 0 && !have_vol) break;
+            job.known_floor[i] = volume_fraction * adv.value(job.day_cache[i].rth_trade_volume);
+            if (!have_vol) break;
+            adv.push(job.day_cache[i].rth_trade_volume);
         }
-        day_min_volume_thresholds[i] = volume_fraction * trailing_adv;
+        return true;
+    };
 
-        adv_history.push_back(day_vol);
-        adv_history_sum += day_vol;
-        if (adv_history.size() > ADV_WINDOW) {
-            adv_history_sum -= adv_history.front();
-            adv_history.pop_front();
+    // ── Jobs ────────────────────────────────────────────────
+    // Anything that is not a directory ("-", a FIFO, a file) is read as
+    // a stream of concatenated day files and split on the fly.
+    const bool stream_input = !universe && ((stock_folder == "-") || !is_directory(stock_folder));
+    std::vector<std::unique_ptr<TickerJob>> jobs;
+    if (universe) {
+        const std::vector<std::string> tickers = read_universe(universe_file);
+        if (tickers.empty()) return 1;
+        for (const std::string& t : tickers) {
+            std::unique_ptr<TickerJob> job(new TickerJob);
+            job->ticker       = t;
+            job->stock_folder = universe_root + "/" + t;
+            job->output_file  = universe_out + "/bursts_" + t + "_baseline" + (columnar ? ".bcol" : ".csv");
+            job->log_tag      = t + " ";
+            if (!is_directory(job->stock_folder)) {
+                std::cout << "SKIP: Missing " << job->stock_folder << "\n";
+                continue;
+            }
+            if (prepare_job(*job)) jobs.push_back(std::move(job));
+        }
+        if (unreadable_day) return 1;
+        if (jobs.empty()) {
+            std::cerr << "Error: no ticker of '" << universe_file << "' has day files under "
+                      << universe_root << "\n";
+            return 1;
+        }
+    } else {
+        std::unique_ptr<TickerJob> job(new TickerJob);
+        job->ticker       = ticker;
+        job->stock_folder = stock_folder;
+        job->output_file  = output_file;
+        if (!stream_input) {
+            if (!prepare_job(*job)) {
+                if (unreadable_day) std::remove(output_file.c_str());   // the probe's empty file
+                return 1;
+            }
+            if (job->ticker.empty()) job->ticker = extract_ticker(stock_folder);
+        }
+        jobs.push_back(std::move(job));
+    }
+    TickerJob& first_job = *jobs.front();
+
+    // Stream input: open it and read up to the first day's framing line,
+    // which may carry the ticker.
+    std::unique_ptr<LobsterDayStream> stream;
+    std::vector<std::string> day_labels;
+    bool have_day = false;
+    if (stream_input) {
+        if (!day_label_file.empty()) {
+            day_labels = read_day_labels(day_label_file);
+            if (day_labels.empty()) return 1;
+        }
+        stream.reset(new LobsterDayStream(stock_folder));
+        if (!stream->ok()) return 1;
+        have_day = stream->next_day();
+        if (!have_day) {
+            std::cerr << "Error: no message rows on input stream " << stock_folder << "\n";
+            return 1;
+        }
+        if (first_job.ticker.empty()) {
+            first_job.ticker = !stream->ticker().empty() ? stream->ticker()
+                             : (stock_folder == "-") ? std::string("STDIN")
+                             : extract_ticker(stock_folder);
         }
     }
 
-    std::cout << "Ticker: " << ticker << "\n";
-    std::cout << "Found " << msg_files.size() << " day file(s)\n";
+    if (universe) {
+        size_t n_days = 0, n_hits = 0;
+        for (const auto& job : jobs) {
+            n_days += job->msg_files.size();
+            n_hits += job->cache_hits;
+        }
+        std::cout << "Universe: '" << universe_file << "' — " << jobs.size() << " ticker(s) under "
+                  << universe_root << ", " << n_days << " day file(s), "
+                  << n_hits << " in the summary cache\n";
+    } else {
+        std::cout << "Ticker: " << first_job.ticker << "\n";
+        if (stream_input) {
+            std::cout << "Input: stream '" << stock_folder
+                      << "' (days split on framing lines / timestamp resets)\n";
+        } else {
+            std::cout << "Found " << first_job.msg_files.size() << " day file(s)"
+                      << ", " << first_job.cache_hits << " in the summary cache\n";
+        }
+    }
     std::cout << "Settings: silence=" << silence_threshold
               << "  vol_frac=" << volume_fraction
               << "  adv_window=14"
@@ -367,296 +1001,533 @@ int main(int argc, char* argv[]) {
               << "  vol_ratio_thresh=" << volume_ratio_threshold
               << "  kappa=" << kappa
               << "  tau_max=" << tau_max
+              << "  horizons=" << join_horizons(horizons)
               << "  hawkes_beta=" << hawkes_beta
               << "  trigger_intensity=" << trigger_intensity
-              << "  cancel_window=" << cancel_window
+              << "  cancel_windows=" << join_windows(feature_windows.cancels)
+              << "  vol_windows=" << join_windows(feature_windows.volatility)
+              << "  mom_lags=" << join_windows(feature_windows.momentum)
               << "  workers=" << workers
-              << "  RTH=[" << rth_start << "," << rth_end << "]\n\n";
-
-    // Open output once and stream results as each day finishes.
-    std::ofstream out(output_file);
-    if (!out.is_open()) {
-        std::cerr << "Error: cannot open output file path: '" << output_file << "'\n"
-                  << "Reason: " << std::strerror(errno) << "\n";
-        return 1;
+              << "  day_chunks=" << day_chunks
+              << "  pipeline=" << (pipeline_depth ? std::to_string(pipeline_depth) : std::string("off"))
+              << "  adv_passes=" << adv_passes
+              << "  mem_budget=" << (mem_budget > 0 ? format_mem(mem_budget) : std::string("off"))
+              << "  format=" << (columnar ? "bcol" : "csv")
+              << "  parser=" << (stream_input ? std::string("pipe")
+                                : parse_mode == ParseMode::MMAP ? std::string("mmap/") + parser_simd_level()
+                                : std::string("stream"))
+              << "  book=" << ladder_kind_name(ladder) << "/" << order_table_kind_name(order_table)
+              << "  index=" << (!use_index ? std::string("off")
+                               : checkpoint_interval > 0.0 ? "build/" + std::to_string((long)checkpoint_interval) + "s"
+                               : std::string("use"))
+              << "  RTH=[" << rth_start << "," << rth_end << "]\n";
+    if (!detector_grid.empty()) {
+        std::cout << "Detector grid: " << detector_configs.size() << " config(s)";
+        if (grid_points > detector_configs.size()) {
+            std::cout << " of " << grid_points << " points (s applies only with beta=0, I only with beta>0)";
+        }
+        std::cout << ", one replay; Config column:\n";
+        for (size_t k = 0; k < detector_configs.size(); ++k) {
+            const DetectorConfig& c = detector_configs[k];
+            std::cout << "  " << k << ": ";
+            if (c.hawkes()) std::cout << "beta=" << c.hawkes_beta << " I=" << c.trigger_intensity << "\n";
+            else            std::cout << "beta=0 s=" << c.silence_threshold << "\n";
+        }
+    }
+    std::cout << "\n";
+
+    // Output columns (burst_row): the CSV header, or the .bcol column table.
+    const OutputColumns output_columns(horizons, feature_windows, !detector_grid.empty());
+    SchemaSink schema;
+    burst_row(schema, BurstRecord(), output_columns);
+    size_t numeric_columns = 0;   // cells per .bcol row
+    for (const BcolColumn& c : schema.columns) numeric_columns += c.type != BCOL_TEXT;
+    for (const BcolColumn& c : schema.columns) {
+        if (columnar && c.name.size() >= BCOL_NAME_SIZE) {
+            std::cerr << "Error: column name too long for --format bcol: " << c.name << "\n";
+            return 1;
+        }
     }
-    out << "Ticker,Date,BurstID,StartTime,EndTime,Direction,Volume,TradeCount,"
-        << "BuyCount,SellCount,BuyVolume,SellVolume,BuyRatio,SellRatio,MinMaxVolRatio,D_b,"
-        << "StartPrice,EndPrice,PeakPrice,CloseMid,EndBid,EndAsk,"
-        << "Mid_1m,Mid_3m,Mid_5m,Mid_10m,"
-        << "Spread,BidVolBest,AskVolBest,BidDepth5,AskDepth5,BookImbalance,"
-        << "Volatility60s,Momentum5s,Momentum30s,Momentum60s,"
-        << "TradeCount5m,TradeVolume5m,"
-        << "TradeSizeVariance,RoundLotPct,HawkesPeakIntensity,PreBurstCancelRate\n";
+
+    // Committed days go to the output through one writer thread; a few
+    // blocks per worker may wait for it.
+    OutputWriter writer(2 * (size_t)std::max(1, workers) + 2);
+
+    // Open a ticker's output and write the header; days are appended as
+    // they commit (in date order).
+    auto open_output = [&](TickerJob& job) -> bool {
+        job.out = OutputWriter::open(job.output_file);
+        if (job.out < 0) {
+            std::cerr << "Error: cannot open output file path: '" << job.output_file << "'\n"
+                      << "Reason: " << std::strerror(errno) << "\n";
+            return false;
+        }
+        std::string header = writer.buffer();
+        if (columnar) bcol_header(schema.columns, header);
+        else          header += schema.csv_header() + "\n";
+        writer.write(job.out, std::move(header));
+        return true;
+    };
+    // A universe run opens each output at its ticker's first commit.
+    if (!universe && !open_output(first_job)) return 1;
 
     std::mutex log_mutex;
-    std::mutex write_mutex;
     auto t0 = std::chrono::steady_clock::now();
 
-    auto process_day_file = [&](const std::string& msg_file, size_t day_idx, size_t total_days,
-                                std::atomic<size_t>& done_counter) -> DayResult {
-        DayResult day_res;
-        day_res.date = extract_date(msg_file);
+    // "k/total" progress tag; total is 0 (unknown) for stream input.
+    auto progress = [](size_t k, size_t total) {
+        return total ? std::to_string(k) + "/" + std::to_string(total) : std::to_string(k);
+    };
 
-        {
-            std::lock_guard<std::mutex> lk(log_mutex);
-            std::cout << "[start " << (day_idx + 1) << "/" << total_days << "] "
-                      << day_res.date << " thread=" << std::this_thread::get_id()
-                      << " min_vol=" << std::fixed << std::setprecision(1)
-                      << day_min_volume_thresholds[day_idx] << "\n";
-        }
-
-        // Fresh book & detector per day (pre-open rebuilds the book)
-        OrderBook     book;
-        BurstDetector detector(
-            silence_threshold,
-            day_min_volume_thresholds[day_idx],
-            direction_threshold,
-            volume_ratio_threshold,
-            hawkes_beta,
-            trigger_intensity
-        );
-        LobsterParser parser(msg_file);
-
-        // Mid-price snapshots: only recorded when mid actually changes.
+    auto log_day_start = [&](const TickerJob& job, const std::string& date, double min_volume,
+                             size_t day_idx, size_t total_days) {
+        std::lock_guard<std::mutex> lk(log_mutex);
+        std::cout << "[start " << progress(day_idx + 1, total_days) << "] "
+                  << job.log_tag << date << " thread=" << std::this_thread::get_id();
+        if (min_volume < 0.0) std::cout << " min_vol=deferred\n";
+        else std::cout << " min_vol=" << std::fixed << std::setprecision(1) << min_volume << "\n";
+    };
+
+    DayContextPool contexts(ladder, BurstDetector(detector_configs, 0.0, direction_threshold,
+                                                  volume_ratio_threshold),
+                            feature_windows);
+
+    // Replay one day, or the part of it `win` selects, up to the lookups
+    // of each burst.  min_volume < 0 means the threshold is not known
+    // yet: run with no floor and let commit_ready_days apply it.
+    auto replay_day = [&](double min_volume, const DaySource& next_rows,
+                          const ReplayWindow& win) -> DayReplay {
+        DayReplay replay;
+        DayResult& day_res = replay.res;
+
+        // Empty book & detector per day (pre-open rebuilds the book), on
+        // recycled buffers.
+        DayContextPool::Lease lease(contexts);
+        DayContext& ctx = *lease;
+        ctx.begin_day(order_table, std::max(0.0, min_volume));
+        OrderBook&     book     = ctx.book;
+        BurstDetector& detector = ctx.detector;
+        replay.bursts.swap(ctx.bursts);
+
+        // BBO updates, tick-encoded, with the mid changes marked.
         // Used after the day loop for forward-return lookups.
-        std::vector<std::pair<double, double>> mid_snapshots;
-        mid_snapshots.reserve(500000);
-        std::vector<BboSnapshot> bbo_snapshots;
-        bbo_snapshots.reserve(500000);
+        L1Timeline& timeline = ctx.timeline;
 
         // ── Rolling statistics accumulators ──────────────────
-        // (a) Mid-return ring buffer for 60-second realized volatility
-        //     Each entry = (time, mid_price).  We compute returns on the fly.
-        std::deque<std::pair<double, double>> mid_ring;  // (time, mid)
-        const double VOL_WINDOW = 60.0;
-
-        // (b) Trade ring buffer for 5-minute trade intensity
-        struct TradeStamp { double time; int size; };
-        std::deque<TradeStamp> trade_ring;
-        const double TRADE_WINDOW = 300.0;
-
-        // (c) Burst start-time ring buffer for recent-burst features
-        struct BurstStamp { double time; int direction; int volume; };
-        std::deque<BurstStamp> burst_ring;
-
-        // ── Path 3: Cancel event ring buffer for pre-burst depletion ──
-        std::deque<CancelEvent> cancel_ring;
-
-        LobsterMessage msg;
-        Burst finished;
-        std::vector<std::pair<Burst, MarketState>> day_bursts;  // burst + state at initiation
-        double current_mid = 0.0;
+        // Mid returns (volatility), lagged mids (momentum) and trades
+        // (intensity) over the -V / -M / 5-minute windows.
+        RollingFeatures& features = ctx.features;
+
+        // ── Path 3: Cancels by side per -w window, for pre-burst depletion ──
+        // burst_cancels holds each config's, as of its open burst's start.
+        CancelWindows& cancels = ctx.cancels;
+        const size_t n_cancels = cancels.windows();
+        CancelTotals* burst_cancels = ctx.burst_cancels.data();
+
+        const LobsterMessage* batch = nullptr;
+        size_t batch_n = 0;
+        auto& day_bursts = ctx.day_bursts;
+        double current_mid = 0.0;     // kept by the book subscription below
+        double feature_mid = 0.0;     // current_mid as of the row being detected
         long   msg_count   = 0;
         bool   flushed_at_rth_end = false;
 
-        // Helper lambda: compute realized volatility from mid_ring
-        auto calc_volatility = [&](double now) -> double {
-            // Prune old entries
-            while (!mid_ring.empty() && mid_ring.front().first < now - VOL_WINDOW)
-                mid_ring.pop_front();
-            if (mid_ring.size() < 2) return 0.0;
-            double sum_sq = 0.0;
-            int n = 0;
-            for (size_t k = 1; k < mid_ring.size(); ++k) {
-                double prev = mid_ring[k-1].second;
-                if (prev == 0.0) continue;
-                double ret = (mid_ring[k].second - prev) / prev;
-                sum_sq += ret * ret;
-                ++n;
-            }
-            return (n > 0) ? std::sqrt(sum_sq / n) : 0.0;
-        };
-
-        // Helper lambda: momentum = (current_mid − mid_at(now − delta)) / mid_at(now − delta)
-        auto calc_momentum = [&](double now, double delta) -> double {
-            double target = now - delta;
-            // Find the latest mid_ring entry at or before target
-            double ref_mid = 0.0;
-            for (auto it = mid_ring.rbegin(); it != mid_ring.rend(); ++it) {
-                if (it->first <= target) { ref_mid = it->second; break; }
-            }
-            if (ref_mid == 0.0 || current_mid == 0.0) return 0.0;
-            return (current_mid - ref_mid) / ref_mid;
-        };
-
-        // Helper lambda: trade intensity in prior TRADE_WINDOW
-        auto calc_trade_stats = [&](double now) -> std::pair<int, int> {
-            while (!trade_ring.empty() && trade_ring.front().time < now - TRADE_WINDOW)
-                trade_ring.pop_front();
-            int cnt = 0, vol = 0;
-            for (auto& t : trade_ring) { ++cnt; vol += t.size; }
-            return {cnt, vol};
-        };
-
-        // Helper lambda: snapshot full MarketState
-        auto snapshot_market_state = [&](double now) -> MarketState {
+        // Helper lambda: the order book's side of MarketState
+        auto book_state = [&]() -> MarketState {
             MarketState s{};
             s.spread        = book.get_spread();
             s.bid_vol_best  = book.get_bid_volume_at_best();
             s.ask_vol_best  = book.get_ask_volume_at_best();
             s.bid_depth_5   = book.get_bid_depth(5);
             s.ask_depth_5   = book.get_ask_depth(5);
+            for (int k = 0; k < BOOK_TOP_LEVELS; ++k) {
+                s.bid_levels[k] = book.get_bid_level_volume(k + 1);
+                s.ask_levels[k] = book.get_ask_level_volume(k + 1);
+            }
+            return s;
+        };
 
+        // Helper lambda: complete MarketState from the book's side of it
+        auto snapshot_market_state = [&](double now, MarketState s) -> MarketState {
             double total_depth = (double)(s.bid_depth_5 + s.ask_depth_5);
             s.book_imbalance = (total_depth > 0)
                 ? (double)(s.bid_depth_5 - s.ask_depth_5) / total_depth
                 : 0.0;
 
-            s.volatility_60s  = calc_volatility(now);
-            s.momentum_5s     = calc_momentum(now, 5.0);
-            s.momentum_30s    = calc_momentum(now, 30.0);
-            s.momentum_60s    = calc_momentum(now, 60.0);
+            for (size_t w = 0; w < feature_windows.volatility.size(); ++w)
+                s.volatility[w] = features.volatility(w, now);
+            // momentum = (feature_mid − mid_at(now − lag)) / mid_at(now − lag)
+            for (size_t l = 0; l < feature_windows.momentum.size(); ++l)
+                s.momentum[l] = features.momentum(l, now, feature_mid);
 
-            auto [tc, tv]     = calc_trade_stats(now);
+            auto [tc, tv]     = features.trades(now);
             s.trade_count_5m  = tc;
             s.trade_volume_5m = tv;
             return s;
         };
 
-        // Helper lambda: compute pre-burst cancellation rate on opposing side
-        // within cancel_window seconds before burst_start_time.
-        // opposing_direction: +1 for buy bursts (cancel on ask), -1 for sell bursts (cancel on bid)
-        // Since we don't know direction yet, we compute rate for BOTH sides and take the max.
-        auto calc_preburst_cancel_rate = [&](double burst_start_time) -> double {
-            // Prune events older than a generous lookback (e.g., 1 second) to bound memory
-            double prune_cutoff = burst_start_time - 1.0;
-            while (!cancel_ring.empty() && cancel_ring.front().time < prune_cutoff)
-                cancel_ring.pop_front();
-
-            double window_start = burst_start_time - cancel_window;
-            int ask_cancels = 0, bid_cancels = 0, total_events = 0;
-            for (auto it = cancel_ring.rbegin(); it != cancel_ring.rend(); ++it) {
-                if (it->time < window_start) break;
-                if (it->time > burst_start_time) continue;
-                total_events++;
-                if (it->direction == -1) ask_cancels++;  // ask-side cancel
-                else bid_cancels++;                       // bid-side cancel
-            }
-            if (total_events == 0) return 0.0;
-            // Return the higher of the two sides — the actual opposing side
-            // will be determined downstream when burst direction is known.
-            return (double)std::max(ask_cancels, bid_cancels) / (double)total_events;
+        // Helper lambda: record the detector's finished bursts with their
+        // MarketState.  A burst's direction is known now, so
+        // PreBurstCancelRate takes the side it traded into (first -w
+        // window).  Under -G the starts go back and forth from one
+        // config to the next; the features keep what the earliest
+        // still needs.
+        auto close_bursts = [&](const MarketState& top) {
+            features.hold(detector.earliest_start());
+            for (Burst finished : detector.finished()) {
+                MarketState ms = snapshot_market_state(finished.start_time, top);
+                const CancelTotals* c = burst_cancels + (size_t)finished.config * n_cancels;
+                std::copy(c, c + n_cancels, ms.pre_cancels);
+                finished.preburst_cancel_rate = opposing_side_rate(ms.pre_cancels[0], finished.direction);
+                day_bursts.push_back({finished, ms});
+            }
         };
 
-        while (parser.next_message(msg)) {
-            ++msg_count;
-
-            // 1. ALWAYS update the order book — pre-open messages
-            //    rebuild the full visible book before RTH opens.
-            bool bbo_changed = book.process_message(msg);
-
-            // 2. Track mid-price (only when book has both sides).
-            //    We record snapshots even outside RTH so that
-            //    forward-return lookups (e.g. Mid_10m for a 3:55 PM
-            //    burst) have prices right up to the close.
-            if (book.is_valid()) {
-                double new_mid = book.get_mid_price();
-                if (new_mid != current_mid) {
-                    current_mid = new_mid;
-                    mid_snapshots.push_back({msg.time, current_mid});
-                }
-                if (bbo_changed) {
-                    bbo_snapshots.push_back({
-                        msg.time,
-                        (double)book.get_best_bid() / 10000.0,
-                        (double)book.get_best_ask() / 10000.0,
-                    });
-                }
+        // Track mid-price and BBO (only when book has both sides).
+        // The mid can only move when a best price does, so this runs on
+        // BBO deltas alone.  Updates are recorded even outside RTH so
+        // that forward-return lookups (e.g. Mid_10m for a 3:55 PM burst)
+        // have prices right up to the close.
+        book.subscribe(BOOK_BID_PRICE | BOOK_ASK_PRICE, [&](const BookDelta& d) {
+            if (!d.valid()) return;
+            double new_mid = d.mid();
+            const bool moved = new_mid != current_mid;
+            current_mid = new_mid;
+            timeline.push(d.time, d.best_bid, d.best_ask, moved);
+        });
+
+        // Resume from a checkpoint: the book, row count and last mid /
+        // BBO as they were after its last row.  Nothing else carries
+        // over, so the checkpoint must precede every row the detector
+        // and rolling features look at (see process_day_file).
+        if (win.start) {
+            const BookCheckpoint& c = *win.start;
+            if (book.restore_checkpoint(win.start_book->data(), win.start_book->size()) &&
+                win.seek(c.position)) {
+                if (c.time >= win.own_from) msg_count = (long)c.rows;
+                current_mid = c.mid;
+                if (c.bbo_time >= 0.0) timeline.seed(c.bbo_time, c.bbo_bid, c.bbo_ask, c.mid_time);
+                day_res.resumed_at = c.time;
+            } else {
+                book.reset();
+                win.seek(0);
             }
+        }
+
+        // A chunk stops detecting once every config has started a burst
+        // at or after own_to (or at the close) and then reads on only
+        // until the lookups of its bursts are covered.
+        const double horizon = forward_reach;
+        const bool   chunked = win.own_to < std::numeric_limits<double>::infinity();
+        replay.next_start.assign(detector.configs(), std::numeric_limits<double>::infinity());
+        size_t unsynced   = detector.configs();
+        bool   detecting  = true;
+        double read_until = win.stop_after;
+        bool   done = false;
+
+        // Everything after the book update for one row: the rolling
+        // features, the detector and the day's RTH counters.  `mid` is
+        // the mid after the row and top() the book's side of MarketState
+        // as of it (asked for only on RTH trades and the first row past
+        // the close).
+        auto detect_row = [&](const LobsterMessage& msg, bool owned, double mid, auto&& top) {
+            feature_mid = mid;
 
             // 3. Burst detection is restricted to Regular Trading Hours.
             //    Pre-market, opening auction, and post-close are excluded.
             // Path 3: Track cancellations/deletions for pre-burst depletion
             if (msg.type == 2 || msg.type == 3) {
                 // direction from LOBSTER: 1=buy-side, -1=sell-side
-                cancel_ring.push_back({msg.time, msg.direction, msg.size});
+                cancels.on_cancel(msg.time, msg.direction, msg.size);
             }
 
-            if (msg.time < rth_start) continue;     // pre-market: skip
+            if (msg.time < rth_start) return;       // pre-market: skip
 
             // ── Update rolling accumulators (RTH only) ──────
-            if (current_mid > 0.0) {
-                // Only push when mid changes (same condition as mid_snapshots)
-                if (mid_ring.empty() || mid_ring.back().second != current_mid) {
-                    mid_ring.push_back({msg.time, current_mid});
-                }
-            }
+            // Only recorded when mid changes (the timeline's mid-changed bit)
+            if (mid > 0.0) features.on_mid(msg.time, mid);
             // Track every trade for intensity
             bool is_trade = (msg.type == 4 || msg.type == 5);
             if (is_trade) {
-                trade_ring.push_back({msg.time, msg.size});
+                features.on_trade(msg.time, msg.size);
+                if (msg.time <= rth_end && owned) replay.summary.rth_trade_volume += (long long)msg.size;
+            }
+            if (msg.type == 1 && msg.time <= rth_end && owned) {
+                replay.summary.rth_submission_volume += (long long)msg.size;
             }
 
             if (msg.time > rth_end) {
                 // Past RTH — flush once, then just keep reading for mid snapshots
                 if (!flushed_at_rth_end) {
-                    if (detector.flush(finished)) {
-                        MarketState ms = snapshot_market_state(finished.start_time);
-                        day_bursts.push_back({finished, ms});
-                    }
+                    detector.flush();
+                    if (!detector.finished().empty()) close_bursts(top());
                     flushed_at_rth_end = true;
+                    if (chunked) {
+                        detecting  = false;
+                        read_until = std::min(read_until, rth_end + horizon);
+                    }
                 }
-                continue;
+                return;
             }
 
             // Inside RTH — feed to burst detector
-            if (current_mid > 0.0) {
-                // Path 3: compute and set pre-burst cancel rate before processing
-                bool is_trade_msg = (msg.type == 4 || msg.type == 5);
-                if (is_trade_msg) {
-                    double cancel_rate = calc_preburst_cancel_rate(msg.time);
-                    detector.set_preburst_cancel_rate(cancel_rate);
-                }
-                if (detector.process(msg, current_mid, finished)) {
+            if (mid > 0.0) {
+                detector.process(msg, mid);
+                if (!detector.finished().empty()) {
                     // Snapshot market state AT THE TIME THE BURST STARTED
-                    MarketState ms = snapshot_market_state(finished.start_time);
-                    day_bursts.push_back({finished, ms});
+                    close_bursts(top());
+                }
+                // Path 3: pre-burst cancels, taken once per burst as it starts
+                const std::vector<uint32_t>& started = detector.started();
+                if (!started.empty()) {
+                    CancelTotals* first = burst_cancels + (size_t)started[0] * n_cancels;
+                    for (size_t w = 0; w < n_cancels; ++w) first[w] = cancels.at(w, msg.time);
+                    for (size_t k = 1; k < started.size(); ++k)
+                        std::copy(first, first + n_cancels, burst_cancels + (size_t)started[k] * n_cancels);
+                }
+                if (chunked && msg.time >= win.own_to) {
+                    for (uint32_t k : started) {
+                        if (replay.next_start[k] != std::numeric_limits<double>::infinity()) continue;
+                        replay.next_start[k] = msg.time;
+                        --unsynced;
+                    }
+                    if (unsynced == 0) {
+                        detecting  = false;
+                        read_until = std::min(read_until, std::max(msg.time + horizon, close_until));
+                    }
+                }
+            }
+        };
+
+        if (pipeline_depth > 0 && !chunked && !win.record) {
+            // ── Pipelined replay (-Q) ────────────────────────
+            // parse thread → book thread → this thread (detect_row),
+            // batches passed by pointer through SPSC rings.  The book
+            // stage records each row's mid and, where detect_row may
+            // ask for it, the book's side of MarketState; buffers go
+            // back to the parser through `spare`.
+            const size_t depth = (size_t)pipeline_depth;
+            std::vector<PipeBatch>& buffers = ctx.pipe_batches;
+            buffers.resize(2 * depth + 2);
+            SpscQueue<PipeBatch*> spare(buffers.size()), parsed(depth), booked(depth);
+            for (auto& b : buffers) {
+                b.rows.reserve(PARSE_BATCH);
+                b.mid.resize(PARSE_BATCH);
+                b.top.resize(PARSE_BATCH);
+                spare.try_push(&b);
+            }
+            std::atomic<bool> stop{false};         // pushdown reached: stop parsing
+            MemAccount* account = mem_account();
+
+            std::thread parse_stage([&]() {
+                MemScope mem(account);
+                PipeBatch* b = nullptr;
+                while (spare.pop(b, &stop)) {
+                    const LobsterMessage* rows = nullptr;
+                    const size_t n = next_rows(rows);
+                    if (n == 0) break;
+                    b->rows.assign(rows, rows + n);
+                    if (!parsed.push(b, &stop)) break;
+                }
+                parsed.close();
+            });
+
+            std::thread book_stage([&]() {
+                MemScope mem(account);
+                PipeBatch* b = nullptr;
+                bool past_close = false;
+                while (parsed.pop(b)) {
+                    size_t k = 0;
+                    b->tops.clear();
+                    for (; !stop.load(std::memory_order_relaxed) && k < b->rows.size(); ++k) {
+                        const LobsterMessage& msg = b->rows[k];
+                        if (msg.time > read_until) {   // every lookup is covered
+                            day_res.stopped_at = msg.time;
+                            stop.store(true);
+                            break;
+                        }
+                        if (msg.time >= win.own_from) ++msg_count;
+                        book.process_message(msg);
+                        b->mid[k] = current_mid;
+                        b->top[k] = -1;
+                        if (msg.time >= rth_start &&
+                            (msg.time > rth_end ? !past_close : (msg.type == 4 || msg.type == 5))) {
+                            past_close = msg.time > rth_end;
+                            b->top[k] = (int)b->tops.size();
+                            b->tops.push_back(book_state());
+                        }
+                    }
+                    b->rows.resize(k);
+                    booked.push(b);
+                }
+                booked.close();
+            });
+
+            PipeBatch* b = nullptr;
+            while (booked.pop(b)) {
+                for (size_t k = 0; k < b->rows.size(); ++k) {
+                    const LobsterMessage& msg = b->rows[k];
+                    detect_row(msg, msg.time >= win.own_from, b->mid[k], [&]() { return b->tops[b->top[k]]; });
+                }
+                spare.push(b);
+            }
+            parse_stage.join();
+            book_stage.join();
+            day_res.pipelined  = true;
+            day_res.parse_q    = parsed.stats();
+            day_res.book_q     = booked.stats();
+            day_res.spare_q    = spare.stats();
+        } else {
+            while (!done && (batch_n = next_rows(batch)) > 0) {
+                for (size_t bi = 0; bi < batch_n; ++bi) {
+                    const LobsterMessage& msg = batch[bi];
+                    if (msg.time > read_until) {         // every lookup is covered
+                        if (detecting) day_res.stopped_at = msg.time;
+                        done = true;
+                        break;
+                    }
+                    const bool owned = msg.time >= win.own_from && msg.time < win.own_to;
+                    if (owned) ++msg_count;
+
+                    // 1. ALWAYS update the order book — pre-open messages
+                    //    rebuild the full visible book before RTH opens.
+                    //    2. (mid / BBO tracking) runs from the subscription above.
+                    book.process_message(msg);
+                    if (detecting) detect_row(msg, owned, current_mid, book_state);
+                }
+
+                if (win.record && win.record->due(batch[batch_n - 1].time)) {
+                    BookCheckpoint c;
+                    c.time     = batch[batch_n - 1].time;
+                    c.position = win.tell();
+                    c.rows     = (uint64_t)msg_count;
+                    c.mid      = current_mid;
+                    c.mid_time = timeline.last_mid_time();
+                    c.bbo_time = -1.0;
+                    if (!timeline.empty()) {
+                        const size_t last = timeline.size() - 1;
+                        c.bbo_time = timeline.time(last);
+                        c.bbo_bid  = timeline.bid(last);
+                        c.bbo_ask  = timeline.ask(last);
+                    }
+                    win.record->add(c, book);
                 }
             }
         }
 
         // Flush any burst still active at file end
-        if (!flushed_at_rth_end && detector.flush(finished)) {
-            MarketState ms = snapshot_market_state(finished.start_time);
-            day_bursts.push_back({finished, ms});
+        if (detecting && !flushed_at_rth_end) {
+            detector.flush();
+            if (!detector.finished().empty()) close_bursts(book_state());
         }
 
         double close_mid = current_mid;
+        if (day_res.stopped_at >= 0.0) {
+            msg_count = win.msg_count;
+            close_mid = win.close_mid;
+        }
 
-        // 4. Compute peak impact (tau_max) and forward-return mid-prices
-        std::ostringstream day_csv;
-        for (auto& [b, ms] : day_bursts) {
-            b.peak_price = find_peak_price(mid_snapshots, b.start_time, b.start_price, tau_max, b.direction);
+        // 4. Compute peak impact (tau_max) and forward-return mid-prices:
+        //    the bursts are in time order, so one sweep of cursors over
+        //    the L1 timeline answers them all (forward.h).  Under -G the
+        //    sweep visits every config's bursts together — peaks in order
+        //    of start, the other lookups in order of end — and row[i]
+        //    groups the records by config.
+        std::vector<uint32_t>& order = ctx.lookup_order;
+        std::vector<uint32_t>& row   = ctx.record_row;
+        order.resize(day_bursts.size());
+        row.resize(day_bursts.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::iota(row.begin(), row.end(), 0u);
+        const bool grid = detector.configs() > 1;
+        if (grid) {
+            std::vector<uint32_t> next(detector.configs() + 1, 0);
+            for (const auto& bm : day_bursts) ++next[bm.first.config + 1];
+            std::partial_sum(next.begin(), next.end(), next.begin());
+            for (size_t i = 0; i < day_bursts.size(); ++i) row[i] = next[day_bursts[i].first.config]++;
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return day_bursts[a].first.start_time < day_bursts[b].first.start_time;
+            });
+        }
+        PeakSweep peaks(timeline, tau_max);
+        for (uint32_t i : order) {
+            Burst& b = day_bursts[i].first;
+            b.peak_price = peaks.peak(b.start_time, b.start_price, b.direction);
+        }
+        if (grid) {
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return day_bursts[a].first.end_time < day_bursts[b].first.end_time;
+            });
+        }
 
-            BurstRecord rec;
-            rec.ticker    = ticker;
-            rec.date      = day_res.date;
+        std::vector<AsOfCursor> mid_at(forward_offsets.size(), AsOfCursor(timeline));
+        AsOfCursor bbo_at(timeline);
+        const double mid_at_close = close_horizon ? AsOfCursor(timeline).mid(rth_end) : 0.0;
+        double fwd[MAX_HORIZONS + 4];
+
+        replay.bursts.resize(day_bursts.size());
+        for (uint32_t i : order) {
+            const auto& [b, ms] = day_bursts[i];
+
+            BurstRecord& rec = replay.bursts[row[i]];
             rec.burst     = b;
-            rec.close_mid = close_mid;
-            auto [end_bid, end_ask] = lookup_bbo(bbo_snapshots, b.end_time);
-            rec.end_bid   = end_bid;
-            rec.end_ask   = end_ask;
-            rec.mid_1m    = lookup_mid(mid_snapshots, b.end_time + 60.0);
-            rec.mid_3m    = lookup_mid(mid_snapshots, b.end_time + 180.0);
-            rec.mid_5m    = lookup_mid(mid_snapshots, b.end_time + 300.0);
-            rec.mid_10m   = lookup_mid(mid_snapshots, b.end_time + 600.0);
-            // D_b = (1/4) Σ Q_b × Direction × (Mid_τ − StartPrice)
+            rec.end_bid   = 0.0;
+            rec.end_ask   = 0.0;
+            if (!timeline.empty()) {
+                const size_t e = bbo_at.index(b.end_time);
+                rec.end_bid = timeline.bid(e);
+                rec.end_ask = timeline.ask(e);
+            }
+            for (size_t o = 0; o < forward_offsets.size(); ++o) {
+                fwd[o] = mid_at[o].mid(b.end_time + forward_offsets[o]);
+            }
+            for (size_t k = 0; k < horizons.size(); ++k)
+                rec.mids[k] = horizons[k].close ? mid_at_close : fwd[horizon_slot[k]];
+            // D_b = (1/4) Σ Q_b × Direction × (Mid_τ − StartPrice), τ = 1, 3, 5, 10 min
             double dsum = 0.0;
             int dcount = 0;
-            auto accum = [&](double mid) {
-                if (mid > 0.0) {
-                    dsum += (double)b.volume * (double)b.direction * (mid - b.start_price);
+            for (int o = 0; o < 4; ++o) {
+                if (fwd[o] > 0.0) {
+                    dsum += (double)b.volume * (double)b.direction * (fwd[o] - b.start_price);
                     dcount++;
                 }
-            };
-            accum(rec.mid_1m);
-            accum(rec.mid_3m);
-            accum(rec.mid_5m);
-            accum(rec.mid_10m);
+            }
             rec.d_b = (dcount > 0)
                 ? (dsum / dcount)
                 : std::numeric_limits<double>::quiet_NaN();
+            rec.mkt       = ms;
+        }
+
+        day_res.msg_count = msg_count;
+        day_res.bbo_updates = timeline.mid_changes(win.own_from, win.own_to);
+        replay.summary.msg_count = msg_count;
+        replay.summary.close_mid = close_mid;
+        replay.order_stats = book.order_stats();
+        return replay;
+    };
+
+    // Every replayed burst is a candidate; the ones that pass kappa
+    // become CSV rows, priced against the day's close.
+    auto format_day = [&](const std::string& ticker, const std::string& date,
+                          DayReplay&& replay) -> PendingDay {
+        PendingDay pending;
+        pending.res         = replay.res;
+        pending.res.date    = date;
+        pending.summary     = replay.summary;
+        pending.order_stats = replay.order_stats;
+        pending.candidate_volumes.reserve(replay.bursts.size());
+        pending.rows.reserve(replay.bursts.size());
+
+        // Rows are formatted into a buffer recycled by the writer
+        // (burst_row gives every column its own precision), or kept as
+        // .bcol cells.
+        DayContextPool::Lease lease(contexts);
+        DayContext& ctx = *lease;
+        if (!columnar) pending.csv = writer.buffer();
+        CsvRowSink csv_row(pending.csv);
+        CellSink   cell_row(pending.cells, pending.texts);
+        for (auto& rec : replay.bursts) {
+            pending.candidate_volumes.push_back(rec.burst.volume);
 
             // Apply kappa filter here to drop bursts before output
             if (kappa > 0.0) {
@@ -665,71 +1536,609 @@ int main(int argc, char* argv[]) {
                 }
             }
 
-            rec.mkt       = ms;
-            day_csv << rec.ticker << "," << rec.date << ","
-                    << b.id << ","
-                    << std::fixed << std::setprecision(6)
-                    << b.start_time << "," << b.end_time << ","
-                    << b.direction << "," << b.volume << ","
-                    << b.trade_count << ","
-                    << b.buy_count << "," << b.sell_count << ","
-                    << b.buy_volume << "," << b.sell_volume << ","
-                    << b.buy_ratio << "," << b.sell_ratio << ","
-                    << b.minmax_vol_ratio << ","
-                    << rec.d_b << ","
-                    << std::setprecision(4)
-                    << b.start_price << "," << b.end_price << "," << b.peak_price << ","
-                    << rec.close_mid << ","
-                    << rec.end_bid << "," << rec.end_ask << ","
-                    << rec.mid_1m << "," << rec.mid_3m << ","
-                    << rec.mid_5m << "," << rec.mid_10m << ","
-                    << std::setprecision(6)
-                    << ms.spread << ","
-                    << ms.bid_vol_best << "," << ms.ask_vol_best << ","
-                    << ms.bid_depth_5 << "," << ms.ask_depth_5 << ","
-                    << std::setprecision(6) << ms.book_imbalance << ","
-                    << std::setprecision(8) << ms.volatility_60s << ","
-                    << ms.momentum_5s << "," << ms.momentum_30s << "," << ms.momentum_60s << ","
-                    << ms.trade_count_5m << "," << ms.trade_volume_5m << ","
-                    << std::setprecision(4) << b.trade_size_variance << ","
-                    << std::setprecision(6) << b.round_lot_pct << ","
-                    << std::setprecision(4) << b.hawkes_peak_intensity << ","
-                    << std::setprecision(6) << b.preburst_cancel_rate
-                    << "\n";
-            day_res.burst_kept++;
+            rec.ticker    = ticker;
+            rec.date      = date;
+            rec.close_mid = replay.summary.close_mid;
+            if (columnar) {
+                burst_row(cell_row, rec, output_columns);
+                cell_row.end_row();
+                pending.rows.push_back({rec.burst.volume, pending.cells.size()});
+            } else {
+                burst_row(csv_row, rec, output_columns);
+                csv_row.end_row();
+                pending.rows.push_back({rec.burst.volume, pending.csv.size()});
+            }
         }
+        replay.bursts.clear();
+        ctx.bursts.swap(replay.bursts);
+        return pending;
+    };
 
-        {
-            std::lock_guard<std::mutex> lk(write_mutex);
-            out << day_csv.str();
+    auto process_day = [&](const TickerJob& job, const std::string& date, double min_volume,
+                           size_t day_idx, size_t total_days, const DaySource& next_rows,
+                           const ReplayWindow& win) -> PendingDay {
+        log_day_start(job, date, min_volume, day_idx, total_days);
+        return format_day(job.ticker, date, replay_day(min_volume, next_rows, win));
+    };
+
+    // ── Ordered commit ──────────────────────────────────────
+    // Days are committed strictly in date order: the day's threshold is
+    // fixed from the trailing ADV of the committed days, its rows are
+    // filtered by it and written, and its volume joins the history.
+    // Each ticker keeps its own order (TickerJob); a universe run
+    // interleaves tickers freely.
+
+    // Volume floor for a day about to start (-1 = deferred to commit time).
+    // Exact when known up front or every prior day is already committed.
+    auto volume_floor = [&](TickerJob& job, size_t day_idx) -> double {
+        if (day_idx < job.known_floor.size() && job.known_floor[day_idx] >= 0.0) {
+            return job.known_floor[day_idx];
         }
+        std::lock_guard<std::mutex> lk(job.commit_mutex);
+        if (job.next_commit == day_idx && !job.adv.empty()) return volume_fraction * job.adv.value(0);
+        return -1.0;
+    };
 
-        day_res.msg_count = msg_count;
-        day_res.bbo_updates = mid_snapshots.size();
-        day_res.burst_candidates = day_bursts.size();
+    // Caller holds job.commit_mutex.  False if the output cannot be opened.
+    auto commit_ready_days = [&](TickerJob& job, size_t total_days) -> bool {
+        if (job.out < 0 && !open_output(job)) return false;
+        std::vector<size_t> kept;
+        while (job.next_commit < job.pending_days.size() && job.day_ready[job.next_commit]) {
+            PendingDay& p = job.pending_days[job.next_commit];
+            DayResult& day_res = p.res;
+            const long long day_vol = p.summary.rth_trade_volume;
+            double threshold = volume_fraction * job.adv.value(day_vol);
+
+            for (int v : p.candidate_volumes) {
+                if ((double)v >= threshold) day_res.burst_candidates++;
+            }
+            // The kept rows move up in place (CSV) or are transposed
+            // into a block (.bcol); the writer thread writes it.
+            size_t begin = 0, at = 0;
+            kept.clear();
+            for (size_t r = 0; r < p.rows.size(); ++r) {
+                const auto& [v, end] = p.rows[r];
+                if ((double)v >= threshold) {
+                    if (columnar) kept.push_back(r);
+                    else if (at != begin) std::memmove(&p.csv[at], &p.csv[begin], end - begin);
+                    at += end - begin;
+                    day_res.burst_kept++;
+                }
+                begin = end;
+            }
+            if (columnar && !kept.empty()) {
+                std::string block = writer.buffer();
+                bcol_block(p.texts, p.cells.data(), numeric_columns, kept, block);
+                writer.write(job.out, std::move(block));
+            } else if (!columnar && at > 0) {
+                p.csv.resize(at);
+                writer.write(job.out, std::move(p.csv));
+            } else {
+                writer.recycle(std::move(p.csv));
+            }
+
+            job.adv.push(day_vol);
+            job.day_trade_volumes.push_back(day_vol);
+            job.day_results.push_back(day_res);
+            const OrderTableStats os = p.order_stats;
+            ++job.next_commit;
 
-        size_t done = done_counter.fetch_add(1) + 1;
-        {
             std::lock_guard<std::mutex> lk(log_mutex);
-            std::cout << "[done  " << done << "/" << total_days << "] "
-                      << day_res.date << " thread=" << std::this_thread::get_id()
+            std::cout << "[done  " << progress(job.next_commit, total_days) << "] "
+                      << job.log_tag << day_res.date << " thread=" << std::this_thread::get_id()
+                      << " min_vol=" << std::fixed << std::setprecision(1) << threshold
                       << " msgs=" << day_res.msg_count
                       << " bursts=" << day_res.burst_candidates
-                      << " kept=" << day_res.burst_kept << "\n";
+                      << " kept=" << day_res.burst_kept
+                      << " orders_peak=" << os.peak_live
+                      << " probe=" << std::setprecision(2) << os.mean_probe() << "/" << os.max_probe;
+            if (os.dense_hits) std::cout << " dense_hits=" << os.dense_hits;
+            if (day_res.resumed_at >= 0.0) std::cout << " resumed@" << std::setprecision(0) << day_res.resumed_at;
+            if (day_res.stopped_at >= 0.0) std::cout << " stopped@" << std::setprecision(0) << day_res.stopped_at;
+            if (day_res.chunks > 1) std::cout << " chunks=" << day_res.chunks;
+            if (day_res.mem_peak > 0) {
+                std::cout << " mem=" << format_mem(day_res.mem_peak);
+                if (mem_budget > 0) std::cout << "/est=" << format_mem(day_res.mem_est);
+                std::cout << " allocs=" << day_res.allocs;
+            }
+            if (day_res.pipelined) {
+                // Mean depth / full waits / empty waits per queue; full
+                // waits point at the consumer, empty waits at the producer.
+                auto q = [](const QueueStats& st) {
+                    std::ostringstream o;
+                    o << std::fixed << std::setprecision(1) << st.mean_depth()
+                      << "/" << st.full_waits << "/" << st.empty_waits;
+                    return o.str();
+                };
+                std::cout << " parse>book=" << q(day_res.parse_q)
+                          << " book>detect=" << q(day_res.book_q)
+                          << " buffer_waits=" << day_res.spare_q.empty_waits;
+            }
+            std::cout << "\n";
+            p = PendingDay();   // day_res refers into p
+        }
+        return true;
+    };
+
+    // Per-day summary, output close and the ADV side-output of a ticker
+    // whose days are all committed.
+    auto finish_job = [&](TickerJob& job) {
+        if (universe) {
+            size_t kept = 0;
+            long long mem = 0;
+            for (const auto& d : job.day_results) {
+                kept += d.burst_kept;
+                mem = std::max(mem, d.mem_peak);
+            }
+            std::lock_guard<std::mutex> lk(log_mutex);
+            std::cout << "[ticker] " << job.ticker << " " << job.day_results.size() << " days, "
+                      << kept << " bursts kept, largest day " << format_mem(mem)
+                      << " → '" << job.output_file << "'\n";
+        } else {
+            for (size_t i = 0; i < job.day_results.size(); ++i) {
+                const auto& d = job.day_results[i];
+                std::cout << "  " << d.date << " … "
+                          << d.msg_count << " msgs, "
+                          << d.bbo_updates << " BBO updates, "
+                          << d.burst_candidates << " bursts"
+                          << " (kept " << d.burst_kept << ")";
+                if (d.mem_peak > 0) std::cout << ", peak " << format_mem(d.mem_peak);
+                std::cout << "\n";
+            }
+        }
+        writer.close(job.out);
+        job.out = -1;
+
+        // <output_file_stem><suffix>
+        auto side_file = [&](const char* suffix) {
+            const auto dot_pos = job.output_file.rfind('.');
+            return (dot_pos != std::string::npos) ? job.output_file.substr(0, dot_pos) + suffix
+                                                  : job.output_file + suffix;
+        };
+
+        // ── Side-output: the -G configurations, by Config ─────────
+        if (!detector_grid.empty()) {
+            std::ofstream cfg_out(side_file("_configs.csv"));
+            if (cfg_out.is_open()) {
+                cfg_out << "Config,HawkesBeta,TriggerIntensity,Silence\n";
+                for (size_t k = 0; k < detector_configs.size(); ++k) {
+                    const DetectorConfig& c = detector_configs[k];
+                    cfg_out << k << "," << (c.hawkes() ? c.hawkes_beta : 0.0) << ",";
+                    if (c.hawkes()) cfg_out << c.trigger_intensity << ",\n";
+                    else            cfg_out << "," << c.silence_threshold << "\n";
+                }
+            }
         }
 
-        return day_res;
+        // ── Side-output: daily RTH traded volume CSV ──────────────
+        // This eliminates the need for a separate precompute_lob_volume.py pass.
+        // Output file: <output_file_stem>_adv.csv
+        const std::string adv_file = side_file("_adv.csv");
+        std::ofstream adv_out(adv_file);
+        if (adv_out.is_open()) {
+            adv_out << "Ticker,Date,TradedVolume\n";
+            for (size_t i = 0; i < job.day_dates.size(); ++i) {
+                adv_out << job.ticker << "," << job.day_dates[i] << ","
+                        << job.day_trade_volumes[i] << "\n";
+            }
+            adv_out.close();
+            if (!universe) {
+                std::cout << "ADV side-output: '" << adv_file << "' ("
+                          << job.day_dates.size() << " days)\n";
+            }
+        }
+        job.finished = true;
     };
 
-    std::vector<DayResult> day_results(msg_files.size());
-    std::atomic<size_t> done_counter{0};
+    std::atomic<bool> output_failed{false};
+    // A day file that could not be read in full, or a -D mismatch: the
+    // run stops and keeps no output it has not finished.
+    std::atomic<bool> input_failed{false};
+    auto finish_day = [&](TickerJob& job, size_t day_idx, size_t total_days, PendingDay&& p) {
+        {
+            std::lock_guard<std::mutex> lk(job.commit_mutex);
+            if (job.pending_days.size() <= day_idx) {
+                job.pending_days.resize(day_idx + 1);
+                job.day_ready.resize(day_idx + 1, 0);
+            }
+            job.pending_days[day_idx] = std::move(p);
+            job.day_ready[day_idx] = 1;
+            if (!commit_ready_days(job, total_days)) output_failed = true;
+            else if (universe && job.next_commit == total_days) finish_job(job);
+        }
+        job.committed.notify_all();
+    };
 
-    if (workers <= 1 || msg_files.size() <= 1) {
-        for (size_t i = 0; i < msg_files.size(); ++i) {
-            day_results[i] = process_day_file(msg_files[i], i, msg_files.size(), done_counter);
+    // ── Intra-day chunks (-S) ───────────────────────────────
+    // RTH is cut into equal spans at B_1 < … < B_{n−1}.  Chunk k counts
+    // the rows timed in [B_k, B_{k+1}) and replays on its own thread
+    // from a book checkpoint — the day's index, or one taken by a
+    // book-only first pass — at least `warmup` seconds before B_k, so
+    // every rolling feature it computes from B_k on is exact.
+    //
+    // Its detector starts cold, perhaps inside a burst of the whole-day
+    // run.  The cold run's intensity sums a suffix of that burst's
+    // trades, so it never outlasts it, and both start a new burst on the
+    // trade that ends it; from there on the two agree.  Stitching is a
+    // short sequential pass: chunk k−1 runs past B_k to its first burst
+    // start S_k at or after B_k, and chunk k's bursts count from S_k.
+    // A burst spanning a whole chunk pushes S_k past B_{k+1}; that
+    // chunk then contributes no bursts.  Under -G every config is
+    // stitched at its own S_k, and a chunk runs on until all have one.
+    auto process_day_chunked = [&](TickerJob& job, size_t i, double min_volume,
+                                   const ReplayWindow& day_win, const BookIndex* index) -> PendingDay {
+        const std::vector<std::string>& msg_files = job.msg_files;
+        const size_t n = (size_t)day_chunks;
+        const double warmup = feature_windows.lookback() + 1.0;
+        log_day_start(job, job.day_dates[i], min_volume, i, msg_files.size());
+
+        struct Chunk {
+            ReplayWindow win;
+            BookCheckpoint start;
+            std::vector<uint8_t> start_book;
+            DayReplay replay;
+            bool input_failed = false;
+            std::thread thread;
+        };
+        std::vector<Chunk> chunks(n);
+        for (size_t k = 0; k < n; ++k) {
+            if (k > 0)     chunks[k].win.own_from = rth_start + (rth_end - rth_start) * (double)k / (double)n;
+            if (k + 1 < n) chunks[k].win.own_to   = rth_start + (rth_end - rth_start) * (double)(k + 1) / (double)n;
+        }
+        chunks[0].win.start      = day_win.start;
+        chunks[0].win.start_book = day_win.start_book;
+        chunks[n - 1].win.stop_after = day_win.stop_after;
+        chunks[n - 1].win.msg_count  = day_win.msg_count;
+        chunks[n - 1].win.close_mid  = day_win.close_mid;
+
+        MemAccount* account = mem_account();
+        auto launch = [&](Chunk& ch) {
+            ch.thread = std::thread([&, cp = &ch]() {
+                MemScope mem(account);
+                LobsterParser parser(msg_files[i], parse_mode);
+                std::vector<LobsterMessage> batch(PARSE_BATCH);
+                cp->win.tell = [&]() { return parser.tell(); };
+                cp->win.seek = [&](uint64_t pos) { return parser.seek(pos); };
+                cp->replay = replay_day(min_volume, [&](const LobsterMessage*& rows) {
+                    rows = batch.data();
+                    return parser.next_batch(batch.data(), batch.size());
+                }, cp->win);
+                cp->input_failed = parser.failed();
+            });
+        };
+        auto set_start = [](Chunk& ch) {
+            ch.win.start      = &ch.start;
+            ch.win.start_book = &ch.start_book;
+        };
+
+        launch(chunks[0]);
+        size_t next = 1;
+        bool input_failed = false;
+        if (index) {
+            for (; next < n; ++next) {
+                Chunk& ch = chunks[next];
+                const BookCheckpoint* c = index->latest_before(ch.win.own_from - warmup);
+                if (c && index->read_book(*c, ch.start_book)) {
+                    ch.start = *c;
+                    set_start(ch);
+                }
+                launch(ch);
+            }
+        } else {
+            // First pass: book only.  A chunk's checkpoint is the state
+            // before the batch holding its first warm-up row, and the
+            // chunk starts as soon as it is taken.
+            static thread_local OrderTable scan_orders;
+            scan_orders.set_kind(order_table);
+            OrderBook book(ladder, &scan_orders);
+            BookCheckpoint at;
+            at.bbo_time = -1.0;
+            book.subscribe(BOOK_BID_PRICE | BOOK_ASK_PRICE, [&](const BookDelta& d) {
+                if (!d.valid()) return;
+                if (d.mid() != at.mid) {
+                    at.mid      = d.mid();
+                    at.mid_time = d.time;
+                }
+                at.bbo_time = d.time;
+                at.bbo_bid  = (double)d.best_bid / 10000.0;
+                at.bbo_ask  = (double)d.best_ask / 10000.0;
+            });
+
+            LobsterParser scan(msg_files[i], parse_mode);
+            std::vector<LobsterMessage> batch(PARSE_BATCH);
+            while (next < n) {
+                const uint64_t pos = scan.tell();
+                const size_t got = scan.next_batch(batch.data(), batch.size());
+                if (got == 0) break;
+                while (next < n && batch[got - 1].time >= chunks[next].win.own_from - warmup) {
+                    Chunk& ch = chunks[next++];
+                    if (at.rows > 0) {
+                        ch.start = at;
+                        ch.start.position = pos;
+                        book.save_checkpoint(ch.start_book);
+                        set_start(ch);
+                    }
+                    launch(ch);
+                }
+                for (size_t k = 0; k < got; ++k) book.process_message(batch[k]);
+                at.rows += got;
+                at.time  = batch[got - 1].time;
+            }
+            input_failed = scan.failed();
+        }
+        for (; next < n; ++next) launch(chunks[next]);     // no checkpoint: from the first row
+        for (auto& ch : chunks) ch.thread.join();
+        for (const auto& ch : chunks) input_failed |= ch.input_failed;
+
+        // Stitch.  `sync` is S_k, the whole-day run's first burst start
+        // at or after B_k; chunk k's own run agrees with it from there.
+        // Each -G config has its own.
+        DayReplay day;
+        day.res.resumed_at = chunks[0].replay.res.resumed_at;
+        day.res.chunks     = (int)n;
+        const size_t n_configs = detector_configs.size();
+        std::vector<double> sync(n_configs, -std::numeric_limits<double>::infinity()), upto(n_configs);
+        long   msg_count = 0;
+        for (size_t k = 0; k < n; ++k) {
+            DayReplay& r = chunks[k].replay;
+            for (size_t c = 0; c < n_configs; ++c) {
+                upto[c] = std::numeric_limits<double>::infinity();
+                if (k + 1 < n) upto[c] = (sync[c] < chunks[k + 1].win.own_from) ? r.next_start[c] : sync[c];
+            }
+            for (auto& rec : r.bursts) {
+                const int c = rec.burst.config;
+                if (rec.burst.start_time >= sync[c] && rec.burst.start_time < upto[c])
+                    day.bursts.push_back(std::move(rec));
+            }
+            sync = upto;
+
+            msg_count += r.res.msg_count;
+            day.res.bbo_updates += r.res.bbo_updates;
+            day.summary.rth_trade_volume      += r.summary.rth_trade_volume;
+            day.summary.rth_submission_volume += r.summary.rth_submission_volume;
+            OrderTableStats& os = day.order_stats;
+            os.peak_live  = std::max(os.peak_live, r.order_stats.peak_live);
+            os.lookups   += r.order_stats.lookups;
+            os.probes    += r.order_stats.probes;
+            os.max_probe  = std::max(os.max_probe, r.order_stats.max_probe);
+            os.dense_hits += r.order_stats.dense_hits;
+            os.capacity   = std::max(os.capacity, r.order_stats.capacity);
+        }
+        // A pushed-down last chunk already reports the day's total.
+        const DayReplay& last = chunks[n - 1].replay;
+        if (last.res.stopped_at >= 0.0) msg_count = last.res.msg_count;
+        if (n_configs > 1) {
+            std::stable_sort(day.bursts.begin(), day.bursts.end(), [](const BurstRecord& a, const BurstRecord& b) {
+                return a.burst.config < b.burst.config;
+            });
+        }
+        day.res.stopped_at        = last.res.stopped_at;
+        day.res.msg_count         = msg_count;
+        day.summary.msg_count     = msg_count;
+        day.summary.close_mid     = last.summary.close_mid;
+        PendingDay p = format_day(job.ticker, job.day_dates[i], std::move(day));
+        p.input_failed = input_failed;
+        return p;
+    };
+
+    auto replay_day_file = [&](TickerJob& job, size_t i) -> PendingDay {
+        const std::vector<std::string>& msg_files = job.msg_files;
+        LobsterParser parser(msg_files[i], parse_mode);
+        std::vector<LobsterMessage> batch(PARSE_BATCH);
+
+        ReplayWindow win;
+        win.tell = [&]() { return parser.tell(); };
+        win.seek = [&](uint64_t pos) { return parser.seek(pos); };
+
+        // With a book index, start from its last checkpoint before the
+        // earliest row the output depends on: the first pre-burst cancel
+        // window of RTH.  Pre-RTH rows only build the book.
+        BookIndex index;
+        std::vector<uint8_t> start_book;
+        std::unique_ptr<BookIndexWriter> writer;
+        const bool indexed = use_index &&
+                             load_book_index(msg_files[i], summary_cache, index) &&
+                             (checkpoint_interval <= 0.0 || index.interval == checkpoint_interval);
+        if (indexed) {
+            win.start = index.latest_before(rth_start - longest(feature_windows.cancels));
+            if (win.start && !index.read_book(*win.start, start_book)) win.start = nullptr;
+            win.start_book = &start_book;
+        } else if (checkpoint_interval > 0.0) {
+            writer.reset(new BookIndexWriter(msg_files[i], summary_cache, checkpoint_interval));
+            if (writer->ok()) win.record = writer.get();
+        }
+
+        // End-of-window pushdown: once the day's totals are known, rows
+        // past the last forward lookup (rth_end + horizon) are not read.
+        if (!win.record && (indexed || job.day_cached[i])) {
+            win.stop_after = rth_end + forward_reach;
+            win.msg_count  = indexed ? index.msg_count : job.day_cache[i].msg_count;
+            win.close_mid  = indexed ? index.close_mid : job.day_cache[i].close_mid;
+        }
+
+        // Building an index takes a whole-day replay, so -S waits for it.
+        const double floor = volume_floor(job, i);
+        PendingDay p = (day_chunks > 1 && !win.record)
+            ? process_day_chunked(job, i, floor, win, indexed ? &index : nullptr)
+            : process_day(job, job.day_dates[i], floor, i, msg_files.size(),
+                          [&](const LobsterMessage*& rows) {
+                rows = batch.data();
+                return parser.next_batch(batch.data(), batch.size());
+            }, win);
+        p.input_failed |= parser.failed();
+        if (writer && !p.input_failed) writer->finish(p.summary.msg_count, p.summary.close_mid);
+        return p;
+    };
+
+    // ── Memory admission (--mem-budget) ─────────────────────
+    // A day's footprint is its heap peak (MemAccount) plus the file the
+    // mmap parser maps.  Its estimate is the footprint recorded for the
+    // file in the summary cache, else the file size times the largest
+    // footprint / size ratio known for its format: from the cache entries
+    // of this run's days, then also from the days it has finished.
+    std::unique_ptr<MemBudget> budget;
+    if (mem_budget > 0) budget.reset(new MemBudget(mem_budget));
+    auto is_lobbin = [](const std::string& f) {
+        return f.size() >= 7 && f.compare(f.size() - 7, 7, ".lobbin") == 0;
+    };
+    std::mutex mem_model_mutex;
+    double mem_per_byte[2] = {0.0, 0.0};                  // [CSV, .lobbin]
+    auto calibrate = [&](const TickerJob& job, size_t i, long long footprint) {
+        if (footprint <= 0 || job.day_bytes[i] <= 0) return;
+        double& r = mem_per_byte[is_lobbin(job.msg_files[i])];
+        r = std::max(r, (double)footprint / (double)job.day_bytes[i]);
+    };
+    for (const auto& job : jobs) {
+        for (size_t i = 0; i < job->day_bytes.size(); ++i) calibrate(*job, i, job->day_cache[i].peak_bytes);
+    }
+    auto estimate_footprint = [&](const TickerJob& job, size_t i) -> long long {
+        if (job.day_cache[i].peak_bytes > 0) return job.day_cache[i].peak_bytes;
+        const int kind = is_lobbin(job.msg_files[i]);
+        std::lock_guard<std::mutex> lk(mem_model_mutex);
+        const double per_byte = mem_per_byte[kind] > 0.0 ? mem_per_byte[kind] : DEFAULT_MEM_PER_BYTE[kind];
+        return (long long)(per_byte * (double)job.day_bytes[i]);
+    };
+
+    auto process_day_file = [&](TickerJob& job, size_t i) {
+        if (output_failed) return;
+        const long long est = estimate_footprint(job, i);
+        if (budget) budget->reserve(est);
+        MemAccount account;
+        PendingDay p;
+        {
+            MemScope mem(&account);
+            p = replay_day_file(job, i);
+        }
+        if (budget) budget->release(est);
+        if (p.input_failed) {
+            std::cerr << "Error: " << job.msg_files[i] << " could not be read in full; "
+                      << "stopping without output for " << job.ticker << "\n";
+            input_failed = true;
+            output_failed = true;
+            job.committed.notify_all();
+            return;
+        }
+        const bool mapped = parse_mode == ParseMode::MMAP && !is_lobbin(job.msg_files[i]);
+        const long long footprint = account.peak.load() + (mapped ? job.day_bytes[i] : 0);
+        p.res.mem_peak = footprint;
+        p.res.mem_est  = est;
+        p.res.allocs   = account.allocs.load();
+        {
+            std::lock_guard<std::mutex> lk(mem_model_mutex);
+            calibrate(job, i, footprint);
+        }
+
+        // Record the footprint with the day's summary; a cached entry is
+        // rewritten only when this run's footprint exceeds its record.
+        if (!job.day_cached[i]) {
+            p.summary.peak_bytes = footprint;
+            store_day_summary(job.msg_files[i], summary_cache, rth_start, rth_end, p.summary);
+        } else if (footprint > job.day_cache[i].peak_bytes) {
+            DaySummary sum = job.day_cache[i];
+            sum.peak_bytes = footprint;
+            store_day_summary(job.msg_files[i], summary_cache, rth_start, rth_end, sum);
+        }
+        finish_day(job, i, job.msg_files.size(), std::move(p));
+    };
+
+    if (stream_input) {
+        // Days are processed as they arrive; -j does not apply.  The first
+        // day runs with a deferred floor (it bootstraps from its own
+        // volume); every later one already has its threshold at the start.
+        std::vector<LobsterMessage> batch(PARSE_BATCH);
+        size_t unframed = 0;
+        std::string last_date;
+        for (size_t i = 0; have_day; ++i, have_day = stream->next_day()) {
+            std::string date = stream->date();
+            if (date.empty()) {
+                if (!day_labels.empty() && unframed == day_labels.size()) {
+                    ++unframed;   // one too many: reported below
+                    break;
+                }
+                date = day_labels.empty() ? "day" + std::to_string(i + 1) : day_labels[unframed];
+                ++unframed;
+            }
+            if (!last_date.empty() && date.size() == 10 && date < last_date) {
+                std::cerr << "Warning: day " << date << " arrives after " << last_date
+                          << "; trailing ADV assumes date order\n";
+            }
+            if (date.size() == 10) last_date = date;
+            first_job.day_dates.push_back(date);
+
+            MemAccount account;
+            PendingDay p;
+            {
+                MemScope mem(&account);
+                p = process_day(first_job, date, volume_floor(first_job, i), i, 0,
+                                [&](const LobsterMessage*& rows) {
+                    rows = batch.data();
+                    return stream->next_batch(batch.data(), batch.size());
+                }, ReplayWindow());
+            }
+            p.res.mem_peak = account.peak.load();
+            p.res.allocs   = account.allocs.load();
+            finish_day(first_job, i, 0, std::move(p));
+        }
+        // Labels are matched to days by position, so with one too few or
+        // too many every date may be off: write nothing.
+        if (!day_labels.empty() && unframed != day_labels.size()) {
+            std::cerr << "Error: " << day_labels.size() << " day label(s) given (-D) for "
+                      << (unframed > day_labels.size() ? "more than that many" : std::to_string(unframed))
+                      << " unframed day(s); output discarded\n";
+            input_failed = true;
+            output_failed = true;
+        }
+    } else if (universe) {
+        // Every day of every ticker is one task, largest file first: the
+        // long days start early and the short ones fill the gaps at the
+        // end.  Each ticker still commits its days in date order, so a
+        // finished day waits in its ticker's pending_days until the days
+        // before it are done; its threshold is deferred unless known.
+        struct DayUnit {
+            TickerJob* job;
+            size_t day;
+            long long bytes;
+        };
+        std::vector<DayUnit> units;
+        for (const auto& job : jobs) {
+            for (size_t i = 0; i < job->msg_files.size(); ++i) {
+                units.push_back({job.get(), i, job->day_bytes[i]});
+            }
+        }
+        std::stable_sort(units.begin(), units.end(), [](const DayUnit& a, const DayUnit& b) {
+            return a.bytes > b.bytes;
+        });
+
+        const size_t nthreads = std::min<size_t>((size_t)std::max(1, workers), units.size());
+        StealQueues<DayUnit> queues(nthreads);
+        for (size_t k = 0; k < units.size(); ++k) queues.push(k % nthreads, units[k]);
+
+        auto run_worker = [&](size_t w) {
+            DayUnit u;
+            while (queues.pop(w, u)) process_day_file(*u.job, u.day);
+        };
+        if (nthreads <= 1) {
+            run_worker(0);
+        } else {
+            std::vector<std::thread> pool;
+            pool.reserve(nthreads);
+            for (size_t w = 0; w < nthreads; ++w) pool.emplace_back(run_worker, w);
+            for (auto& th : pool) th.join();
+        }
+        std::cout << "Scheduler: " << units.size() << " day(s) on " << nthreads
+                  << " worker(s), " << queues.steals() << " stolen\n";
+    } else if (workers <= 1 || first_job.msg_files.size() <= 1) {
+        for (size_t i = 0; i < first_job.msg_files.size(); ++i) {
+            process_day_file(first_job, i);
         }
     } else {
-        int nthreads = std::min<int>(workers, (int)msg_files.size());
+        // Days are taken in date order, and a worker does not start a
+        // day more than REORDER_DAYS_PER_WORKER × workers past the
+        // oldest uncommitted one, which bounds the finished days held
+        // back by a slow one.  Every day before it is already running,
+        // so the wait always ends.
+        int nthreads = std::min<int>(workers, (int)first_job.msg_files.size());
+        const size_t reorder_window = REORDER_DAYS_PER_WORKER * (size_t)nthreads;
         std::atomic<size_t> next_idx{0};
         std::vector<std::thread> pool;
         pool.reserve(nthreads);
@@ -738,57 +2147,65 @@ int main(int argc, char* argv[]) {
             pool.emplace_back([&]() {
                 while (true) {
                     size_t i = next_idx.fetch_add(1);
-                    if (i >= msg_files.size()) break;
-                    day_results[i] = process_day_file(msg_files[i], i, msg_files.size(), done_counter);
+                    if (i >= first_job.msg_files.size()) break;
+                    {
+                        std::unique_lock<std::mutex> lk(first_job.commit_mutex);
+                        first_job.committed.wait(lk, [&] {
+                            return i < first_job.next_commit + reorder_window || output_failed;
+                        });
+                    }
+                    if (output_failed) break;
+                    process_day_file(first_job, i);
                 }
             });
         }
         for (auto& th : pool) th.join();
     }
-
-    for (size_t i = 0; i < day_results.size(); ++i) {
-        const auto& d = day_results[i];
-        std::cout << "  " << d.date << " … "
-                  << d.msg_count << " msgs, "
-                  << d.bbo_updates << " BBO updates, "
-                  << d.burst_candidates << " bursts"
-                  << " (kept " << d.burst_kept << ")\n";
-    }
-    out.flush();
-    out.close();
-
-    // ── Side-output: daily RTH traded volume CSV ──────────────
-    // This eliminates the need for a separate precompute_lob_volume.py pass.
-    // Output file: <output_file_stem>_adv.csv
-    {
-        std::string adv_file = output_file;
-        auto dot_pos = adv_file.rfind('.');
-        if (dot_pos != std::string::npos)
-            adv_file = adv_file.substr(0, dot_pos) + "_adv.csv";
-        else
-            adv_file += "_adv.csv";
-
-        std::ofstream adv_out(adv_file);
-        if (adv_out.is_open()) {
-            adv_out << "Ticker,Date,TradedVolume\n";
-            for (size_t i = 0; i < msg_files.size(); ++i) {
-                std::string date = extract_date(msg_files[i]);
-                adv_out << ticker << "," << date << "," << day_trade_volumes[i] << "\n";
-            }
-            adv_out.close();
-            std::cout << "ADV side-output: '" << adv_file << "' ("
-                      << msg_files.size() << " days)\n";
+    if (!output_failed && !universe) finish_job(first_job);
+    writer.finish();
+    if (input_failed) {
+        for (const auto& job : jobs) {
+            if (!job->finished) std::remove(job->output_file.c_str());
         }
+        return 1;
+    }
+    if (!writer.error().empty()) {
+        std::cerr << "Error: writing output failed (" << writer.error() << ")\n";
+        return 1;
     }
+    if (output_failed) return 1;
 
     auto t1 = std::chrono::steady_clock::now();
     double elapsed_sec = std::chrono::duration<double>(t1 - t0).count();
 
-    size_t total_kept = 0;
-    for (const auto& d : day_results) total_kept += d.burst_kept;
-    std::cout << "\nTotal bursts across all days: " << total_kept << "\n";
-    std::cout << "Elapsed seconds: " << std::fixed << std::setprecision(1) << elapsed_sec << "\n";
-    std::cout << "Output: '" << output_file << "'\n";
+    size_t total_kept = 0, total_days = 0;
+    long long largest_day = 0;
+    for (const auto& job : jobs) {
+        for (const auto& d : job->day_results) {
+            total_kept += d.burst_kept;
+            largest_day = std::max(largest_day, d.mem_peak);
+        }
+        total_days += job->day_results.size();
+    }
+    std::cout << "Memory: largest day " << format_mem(largest_day);
+    const long long rss = process_peak_rss();
+    if (rss > 0) std::cout << ", process peak RSS " << format_mem(rss);
+    if (budget) {
+        std::cout << "; budget " << format_mem(budget->budget())
+                  << ", most reserved at once " << format_mem(budget->peak_in_flight())
+                  << ", " << budget->waits() << " admission wait(s)";
+    }
+    std::cout << "\n";
+    if (universe) {
+        std::cout << "\nTotal bursts across " << jobs.size() << " tickers / "
+                  << total_days << " days: " << total_kept << "\n";
+        std::cout << "Elapsed seconds: " << std::fixed << std::setprecision(1) << elapsed_sec << "\n";
+        std::cout << "Output: '" << universe_out << "/bursts_<ticker>_baseline" << (columnar ? ".bcol" : ".csv") << "'\n";
+    } else {
+        std::cout << "\nTotal bursts across all days: " << total_kept << "\n";
+        std::cout << "Elapsed seconds: " << std::fixed << std::setprecision(1) << elapsed_sec << "\n";
+        std::cout << "Output: '" << output_file << "'\n";
+    }
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+// Per-day memory accounting and admission (see mem_budget.h)
+#include "mem_budget.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <malloc.h>
+
+static thread_local MemAccount* tl_account = nullptr;
+
+MemAccount* mem_account() { return tl_account; }
+
+MemScope::MemScope(MemAccount* account) : prev_(tl_account) { tl_account = account; }
+MemScope::~MemScope() { tl_account = prev_; }
+
+// ── Global operator new / delete ────────────────────────────
+
+static inline void charge(void* p) {
+    MemAccount* a = tl_account;
+    if (!a || !p) return;
+    const long long n = (long long)malloc_usable_size(p);
+    const long long live = a->live.fetch_add(n, std::memory_order_relaxed) + n;
+    long long peak = a->peak.load(std::memory_order_relaxed);
+    while (live > peak &&
+           !a->peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+    a->allocs.fetch_add(1, std::memory_order_relaxed);
+}
+
+static inline void credit(void* p) {
+    MemAccount* a = tl_account;
+    if (!a || !p) return;
+    a->live.fetch_sub((long long)malloc_usable_size(p), std::memory_order_relaxed);
+}
+
+static void* alloc_or_throw(size_t n) {
+    for (;;) {
+        if (void* p = std::malloc(n ? n : 1)) { charge(p); return p; }
+        std::new_handler h = std::get_new_handler();
+        if (!h) throw std::bad_alloc();
+        h();
+    }
+}
+
+static void* aligned_or_throw(size_t n, std::align_val_t al) {
+    size_t a = std::max(sizeof(void*), (size_t)al);
+    for (;;) {
+        void* p = nullptr;
+        if (posix_memalign(&p, a, n ? n : 1) == 0) { charge(p); return p; }
+        std::new_handler h = std::get_new_handler();
+        if (!h) throw std::bad_alloc();
+        h();
+    }
+}
+
+static void release_block(void* p) {
+    credit(p);
+    std::free(p);
+}
+
+void* operator new(size_t n)   { return alloc_or_throw(n); }
+void* operator new[](size_t n) { return alloc_or_throw(n); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept {
+    try { return alloc_or_throw(n); } catch (...) { return nullptr; }
+}
+void* operator new[](size_t n, const std::nothrow_t&) noexcept {
+    try { return alloc_or_throw(n); } catch (...) { return nullptr; }
+}
+void* operator new(size_t n, std::align_val_t al)   { return aligned_or_throw(n, al); }
+void* operator new[](size_t n, std::align_val_t al) { return aligned_or_throw(n, al); }
+
+void operator delete(void* p) noexcept                          { release_block(p); }
+void operator delete[](void* p) noexcept                        { release_block(p); }
+void operator delete(void* p, size_t) noexcept                  { release_block(p); }
+void operator delete[](void* p, size_t) noexcept                { release_block(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept   { release_block(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release_block(p); }
+void operator delete(void* p, std::align_val_t) noexcept            { release_block(p); }
+void operator delete[](void* p, std::align_val_t) noexcept          { release_block(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept    { release_block(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept  { release_block(p); }
+
+// ── MemBudget ───────────────────────────────────────────────
+
+void MemBudget::reserve(long long bytes) {
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (budget_ > 0 && days_ > 0 && in_flight_ + bytes > budget_) {
+        ++waits_;
+        freed_.wait(lk, [&] { return days_ == 0 || in_flight_ + bytes <= budget_; });
+    }
+    in_flight_ += bytes;
+    ++days_;
+    if (in_flight_ > peak_) peak_ = in_flight_;
+}
+
+void MemBudget::release(long long bytes) {
+    {
+        std::lock_guard<std::mutex> lk(mutex_);
+        in_flight_ -= bytes;
+        --days_;
+    }
+    freed_.notify_all();
+}
+
+long long MemBudget::peak_in_flight() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return peak_;
+}
+
+size_t MemBudget::waits() const {
+    std::lock_guard<std::mutex> lk(mutex_);
+    return waits_;
+}
+
+// ── Helpers ─────────────────────────────────────────────────
+
+long long parse_mem_size(const std::string& text) {
+    char* end = nullptr;
+    double v = std::strtod(text.c_str(), &end);
+    if (end == text.c_str() || v < 0.0) return -1;
+    double scale = 1.0;
+    switch (*end) {
+        case 'k': case 'K': scale = 1024.0;                   ++end; break;
+        case 'm': case 'M': scale = 1024.0 * 1024.0;          ++end; break;
+        case 'g': case 'G': scale = 1024.0 * 1024.0 * 1024.0; ++end; break;
+        default: break;
+    }
+    if (*end == 'b' || *end == 'B') ++end;
+    if (*end != '\0') return -1;
+    return (long long)(v * scale);
+}
+
+std::string format_mem(long long bytes) {
+    char buf[32];
+    const double mb = (double)bytes / (1024.0 * 1024.0);
+    if (mb >= 1024.0) std::snprintf(buf, sizeof(buf), "%.2fGB", mb / 1024.0);
+    else              std::snprintf(buf, sizeof(buf), "%.1fMB", mb);
+    return buf;
+}
+
+long long process_peak_rss() {
+    FILE* fp = std::fopen("/proc/self/status", "r");
+    if (!fp) return -1;
+    long long kb = -1;
+    char line[256];
+    while (std::fgets(line, sizeof(line), fp)) {
+        if (std::strncmp(line, "VmHWM:", 6) == 0) {
+            kb = std::atoll(line + 6);
+            break;
+        }
+    }
+    std::fclose(fp);
+    return kb < 0 ? -1 : kb * 1024;
+}
@@ -0,0 +1,84 @@
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// Per-day memory accounting and admission (--mem-budget)
+// ─────────────────────────────────────────────────────────────
+//
+// MemAccount: heap bytes live / peak and allocations made by the
+// threads attached to it.  mem_budget.cpp replaces the global
+// operator new / delete; every allocation or free on a thread with an
+// attached account (MemScope) is charged to it, by malloc_usable_size.
+// A day attaches one account to its worker and to every thread it
+// starts (-S chunks, -Q stages), so the account's peak is the day's
+// heap footprint.  A block freed on another thread than the one that
+// allocated it is credited to the freeing thread's account, if any;
+// days detach before their rows are committed, so in practice each
+// day frees what it allocated.
+//
+// MemBudget: admission control.  A day reserves its estimated
+// footprint before it starts and releases it when its replay is done;
+// reserve() waits while the days in flight leave too little room.  A
+// day is always admitted when none is in flight, so one larger than
+// the whole budget still runs (alone).
+// ─────────────────────────────────────────────────────────────
+
+struct MemAccount {
+    std::atomic<long long> live{0};
+    std::atomic<long long> peak{0};
+    std::atomic<long long> allocs{0};
+};
+
+// The calling thread's account (nullptr = not charged).
+MemAccount* mem_account();
+
+// Attach `account` to the calling thread for the scope's lifetime.
+class MemScope {
+public:
+    explicit MemScope(MemAccount* account);
+    ~MemScope();
+    MemScope(const MemScope&) = delete;
+    MemScope& operator=(const MemScope&) = delete;
+private:
+    MemAccount* prev_;
+};
+
+class MemBudget {
+public:
+    explicit MemBudget(long long bytes) : budget_(bytes) {}
+
+    long long budget() const { return budget_; }
+
+    // Waits until `bytes` fits next to the days in flight.
+    void reserve(long long bytes);
+    void release(long long bytes);
+
+    long long peak_in_flight() const;   // most bytes reserved at once
+    size_t waits() const;               // reserve() calls that had to wait
+
+private:
+    const long long budget_;
+    mutable std::mutex mutex_;
+    std::condition_variable freed_;
+    long long in_flight_ = 0;
+    size_t    days_      = 0;
+    long long peak_      = 0;
+    size_t    waits_     = 0;
+};
+
+// "8G", "512M", "64K" or plain bytes → bytes; -1 if malformed.
+long long parse_mem_size(const std::string& text);
+
+// "41.3MB" / "1.25GB"
+std::string format_mem(long long bytes);
+
+// Peak resident set size of the process (VmHWM), or -1.
+long long process_peak_rss();
+
+#endif
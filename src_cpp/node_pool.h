@@ -0,0 +1,107 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+
+#include <new>
+#include <vector>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// NodePool: arena of fixed-size nodes for node-based containers
+// ─────────────────────────────────────────────────────────────
+//
+// A std::map allocates one node per element and frees it on erase; a
+// day of level churn is tens of thousands of malloc/free pairs.  With
+// PoolAllocator the map takes its nodes from a NodePool instead: nodes
+// are cut from blocks of BLOCK_NODES and an erased node goes onto a
+// free list for the next insert.  Blocks are only returned when the
+// pool is destroyed, so a pool that outlives clear() — a book reused
+// from day to day — stops allocating once it has seen its busiest day.
+//
+// The first single-object allocation fixes the node size; anything
+// else (arrays, another node type) goes to the global operator new.
+// One pool per container owner, used from one thread at a time.
+// ─────────────────────────────────────────────────────────────
+
+class NodePool {
+public:
+    static constexpr size_t BLOCK_NODES = 256;
+
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    ~NodePool() {
+        for (void* b : blocks_) ::operator delete(b);
+    }
+
+    void* allocate(size_t bytes) {
+        if (node_ == 0) node_ = round_up(bytes);
+        if (round_up(bytes) != node_) return ::operator new(bytes);
+        if (free_) {
+            Free* f = free_;
+            free_ = f->next;
+            return f;
+        }
+        if (left_ == 0) {
+            cur_ = static_cast<char*>(::operator new(node_ * BLOCK_NODES));
+            blocks_.push_back(cur_);
+            left_ = BLOCK_NODES;
+        }
+        void* p = cur_;
+        cur_ += node_;
+        --left_;
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        if (round_up(bytes) != node_) { ::operator delete(p); return; }
+        Free* f = static_cast<Free*>(p);
+        f->next = free_;
+        free_ = f;
+    }
+
+    size_t blocks() const { return blocks_.size(); }
+
+private:
+    struct Free { Free* next; };
+
+    static size_t round_up(size_t bytes) {
+        const size_t a = alignof(std::max_align_t);
+        bytes = bytes < sizeof(Free) ? sizeof(Free) : bytes;
+        return (bytes + a - 1) / a * a;
+    }
+
+    size_t node_ = 0;
+    Free*  free_ = nullptr;
+    char*  cur_  = nullptr;
+    size_t left_ = 0;
+    std::vector<void*> blocks_;
+};
+
+// Allocator handing single nodes to a NodePool.
+template <class T>
+struct PoolAllocator {
+    using value_type = T;
+
+    NodePool* pool;
+
+    explicit PoolAllocator(NodePool* p) noexcept : pool(p) {}
+    template <class U>
+    PoolAllocator(const PoolAllocator<U>& o) noexcept : pool(o.pool) {}
+
+    T* allocate(size_t n) {
+        if (n == 1) return static_cast<T*>(pool->allocate(sizeof(T)));
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    void deallocate(T* p, size_t n) noexcept {
+        if (n == 1) pool->deallocate(p, sizeof(T));
+        else        ::operator delete(p);
+    }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U>& o) const noexcept { return pool == o.pool; }
+    template <class U>
+    bool operator!=(const PoolAllocator<U>& o) const noexcept { return pool != o.pool; }
+};
+
+#endif
@@ -0,0 +1,380 @@
+// ─────────────────────────────────────────────────────────────
+// order_check.cpp  –  OrderTable and OrderBook level cache (make check)
+// ─────────────────────────────────────────────────────────────
+//
+// 1. OrderTable vs std::unordered_map<long, BookOrder>, -O hash and
+//    -O dense: random insert / insert-over-a-live-id / find / erase
+//    streams over several days on one recycled table.  The live set
+//    grows past a few grow()s and shrinks again; ids come in order
+//    from the day's first id, below it, across the dense span (it
+//    widens up to DENSE_MAX_SPAN) and past it, far off, and from a set
+//    that all hash to one home slot, so erases land mid-cluster and
+//    exercise the backward shift.  size() and every find() must
+//    agree; for_each() is compared entry by entry now and then.
+//
+// 2. OrderBook vs a std::map reference book, for each ladder (-B) and
+//    order table (-O): random LOBSTER messages (types 1-5, unknown
+//    ids, re-used ids, sub-penny and jumping prices).  After every
+//    message the best prices, the BOOK_TOP_LEVELS level sizes and the
+//    depths served from the top-of-book cache must match; now and
+//    then the book goes through a checkpoint into a fresh one.
+//
+//     order_check [-n runs] [-o ops_per_run]
+//
+// Exit status 0 if every run matched.
+// ─────────────────────────────────────────────────────────────
+
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdlib>
+
+#include "orderbook.h"
+#include "order_table.h"
+
+static bool same_order(const BookOrder& a, const BookOrder& b) {
+    return a.price == b.price && a.size == b.size && a.direction == b.direction;
+}
+
+// Ids that share one home slot at the table's initial size (and so
+// pairwise at every size after it), none of them near the day bases.
+static std::vector<long> colliding_ids(size_t count) {
+    const size_t mask = OrderTable::INITIAL_SLOTS - 1;
+    auto home = [&](long id) {
+        return (size_t)(((uint64_t)id * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+    };
+    std::vector<long> ids;
+    const long first = 900000000L;
+    const size_t target = home(first);
+    for (long id = first; ids.size() < count; ++id) {
+        if (home(id) == target) ids.push_back(id);
+    }
+    return ids;
+}
+
+// ── 1. OrderTable ───────────────────────────────────────────
+
+static bool table_run(OrderTableKind kind, uint64_t seed, long ops) {
+    std::mt19937_64 rng(seed);
+    static const std::vector<long> collide = colliding_ids(300);
+    OrderTable table(kind);
+    std::unordered_map<long, BookOrder> ref;
+    std::vector<long> live;                    // ids, possibly stale
+    const char* name = order_table_kind_name(kind);
+    long op = 0;
+
+    auto fail = [&](const std::string& what) {
+        std::cerr << "MISMATCH table=" << name << " seed=" << seed << " op=" << op << ": " << what << "\n";
+        return false;
+    };
+    auto random_order = [&]() {
+        return BookOrder{100 * (1 + (int)(rng() % 100000)), 1 + (int)(rng() % 1000),
+                         (rng() & 1) ? 1 : -1};
+    };
+    // A live id, or 0 if there is none.
+    auto pick_live = [&]() -> long {
+        while (!live.empty()) {
+            const size_t k = rng() % live.size();
+            if (ref.count(live[k])) return live[k];
+            live[k] = live.back();
+            live.pop_back();
+        }
+        return 0;
+    };
+    auto compare_all = [&]() {
+        size_t n = 0;
+        bool ok = true;
+        std::unordered_set<long> seen;
+        table.for_each([&](long id, const BookOrder& o) {
+            ++n;
+            auto it = ref.find(id);
+            if (it == ref.end() || !same_order(it->second, o) || !seen.insert(id).second) ok = false;
+        });
+        return ok && n == ref.size();
+    };
+
+    const int days = 3;
+    for (int day = 0; day < days; ++day) {
+        table.set_kind(kind);
+        table.clear();
+        ref.clear();
+        live.clear();
+        const long base = 10000000L + (long)(rng() % 1000000);
+        long next_id = base;
+        const long day_ops = ops / days;
+        const size_t peak = 150000 + rng() % 100000;
+        bool growing = true;
+
+        for (long k = 0; k < day_ops; ++k, ++op) {
+            if (growing && ref.size() >= peak) growing = false;
+            if (!growing && ref.size() < 1000) growing = true;
+            const int r = (int)(rng() % 100);
+            const int insert_pct = growing ? 75 : 30;
+
+            if (r < insert_pct) {
+                long id;
+                const int c = (int)(rng() % 100);
+                if      (c < 60) id = next_id++;
+                else if (c < 70) id = collide[rng() % collide.size()];
+                else if (c < 78) id = base - 1 - (long)(rng() % 100000);
+                else if (c < 86) id = base + (long)OrderTable::INITIAL_SLOTS +
+                                      (long)(rng() % OrderTable::DENSE_MAX_SPAN);
+                else if (c < 92) id = base + (long)OrderTable::DENSE_MAX_SPAN + (long)(rng() % 1000000);
+                else             id = (long)(rng() % 1000000000000L);
+                const BookOrder o = random_order();
+                table.insert(id, o);
+                if (!ref.count(id)) live.push_back(id);
+                ref[id] = o;
+            } else if (r < insert_pct + 8) {   // overwrite a live order
+                const long id = pick_live();
+                if (!id) continue;
+                const BookOrder o = random_order();
+                table.insert(id, o);
+                ref[id] = o;
+            } else if (r < insert_pct + (growing ? 15 : 20)) {   // find, half of them absent
+                const long id = (rng() & 1) ? pick_live()
+                                            : base - 200000 + (long)(rng() % 3000000);
+                BookOrder* got = table.find(id);
+                auto it = ref.find(id);
+                if ((got != nullptr) != (it != ref.end()) || (got && !same_order(*got, it->second)))
+                    return fail("find(" + std::to_string(id) + ")");
+            } else {                           // erase a live order
+                const long id = pick_live();
+                if (!id) continue;
+                BookOrder* got = table.find(id);
+                if (!got || !same_order(*got, ref[id])) return fail("find before erase(" + std::to_string(id) + ")");
+                table.erase(got);
+                ref.erase(id);
+                if (table.find(id)) return fail("erased id " + std::to_string(id) + " still found");
+            }
+
+            if (table.size() != ref.size())
+                return fail("size " + std::to_string(table.size()) + " vs " + std::to_string(ref.size()));
+            if (k % 50000 == 0 && !compare_all()) return fail("for_each");
+        }
+        // Every live order, looked up one by one.
+        for (const auto& [id, o] : ref) {
+            BookOrder* got = table.find(id);
+            if (!got || !same_order(*got, o)) return fail("end of day find(" + std::to_string(id) + ")");
+        }
+        if (!compare_all()) return fail("end of day for_each");
+    }
+    const OrderTableStats st = table.stats();
+    std::cout << "ok   table=" << name << " seed=" << seed << "  ops=" << op
+              << "  peak_live=" << st.peak_live << "  capacity=" << st.capacity
+              << "  max_probe=" << st.max_probe << "  dense_hits=" << st.dense_hits << "\n";
+    return true;
+}
+
+// ── 2. OrderBook level cache ────────────────────────────────
+
+// The book as std::maps, with OrderBook's message semantics.
+struct RefBook {
+    std::unordered_map<long, BookOrder> orders;
+    std::map<int, int> bids, asks;
+
+    void reduce_level(bool bid, int price, int size_delta) {
+        auto& side = bid ? bids : asks;
+        auto pl = side.find(price);
+        if (pl == side.end()) return;
+        pl->second -= size_delta;
+        if (pl->second <= 0) side.erase(pl);
+    }
+    void process(const LobsterMessage& m) {
+        if (m.type == 1) {
+            if (m.price <= 0 || m.size <= 0) return;
+            orders[m.order_id] = {m.price, m.size, m.direction};
+            (m.direction == 1 ? bids : asks)[m.price] += m.size;
+        } else if (m.type == 2 || m.type == 4 || m.type == 3) {
+            auto it = orders.find(m.order_id);
+            if (it == orders.end()) return;
+            BookOrder& o = it->second;
+            const int delta = m.type == 3 ? o.size : m.size;
+            reduce_level(o.direction == 1, o.price, delta);
+            o.size -= delta;
+            if (m.type == 3 || o.size <= 0) orders.erase(it);
+        }
+    }
+    int level_volume(bool bid, int level) const {
+        const auto& side = bid ? bids : asks;
+        if (level < 1 || (size_t)level > side.size()) return 0;
+        if (bid) { auto it = side.rbegin(); std::advance(it, level - 1); return it->second; }
+        auto it = side.begin(); std::advance(it, level - 1); return it->second;
+    }
+    int best(bool bid) const {
+        const auto& side = bid ? bids : asks;
+        if (side.empty()) return 0;
+        return bid ? side.rbegin()->first : side.begin()->first;
+    }
+    int depth(bool bid, int levels) const {
+        const auto& side = bid ? bids : asks;
+        int total = 0, count = 0;
+        if (bid) {
+            for (auto it = side.rbegin(); it != side.rend(); ++it) {
+                total += it->second;
+                if (levels > 0 && ++count >= levels) break;
+            }
+        } else {
+            for (auto it = side.begin(); it != side.end(); ++it) {
+                total += it->second;
+                if (levels > 0 && ++count >= levels) break;
+            }
+        }
+        return total;
+    }
+};
+
+// The first getter of `book` that differs from `ref`, or "".  The
+// whole-side depth walks every level, so it is only checked when
+// `whole_side` is set.
+static std::string book_diff(const OrderBook& book, const RefBook& ref, bool whole_side) {
+    for (bool bid : {true, false}) {
+        const std::string side = bid ? "bid" : "ask";
+        const int best = bid ? book.get_best_bid() : book.get_best_ask();
+        if (best != ref.best(bid))
+            return "best " + side + " " + std::to_string(best) + " vs " + std::to_string(ref.best(bid));
+        const int at_best = bid ? book.get_bid_volume_at_best() : book.get_ask_volume_at_best();
+        if (at_best != ref.level_volume(bid, 1)) return side + " volume at best";
+        for (int lv = 1; lv <= BOOK_TOP_LEVELS + 1; ++lv) {
+            const int v = bid ? book.get_bid_level_volume(lv) : book.get_ask_level_volume(lv);
+            const int want = lv <= BOOK_TOP_LEVELS ? ref.level_volume(bid, lv) : 0;
+            if (v != want)
+                return side + " level " + std::to_string(lv) + " volume " + std::to_string(v) +
+                       " vs " + std::to_string(want);
+        }
+        for (int lv = whole_side ? 0 : 1; lv <= BOOK_TOP_LEVELS + 2; ++lv) {
+            const int d = bid ? book.get_bid_depth(lv) : book.get_ask_depth(lv);
+            if (d != ref.depth(bid, lv))
+                return side + " depth(" + std::to_string(lv) + ") " + std::to_string(d) + " vs " +
+                       std::to_string(ref.depth(bid, lv));
+        }
+    }
+    if (book.is_valid() != (!ref.bids.empty() && !ref.asks.empty())) return "is_valid";
+    return "";
+}
+
+static bool book_run(LadderKind ladder, OrderTableKind kind, uint64_t seed, long ops) {
+    std::mt19937_64 rng(seed);
+    OrderTable table(kind);
+    OrderBook book(ladder, &table);
+    RefBook ref;
+    std::vector<long> live;
+    std::vector<uint8_t> blob;
+    const std::string name = std::string("book=") + ladder_kind_name(ladder) + "/" +
+                             order_table_kind_name(kind);
+    const long base = 10000000L + (long)(rng() % 1000000);
+    long next_id = base;
+    int mid = 2000000 + (int)(rng() % 1000) * LADDER_TICK;
+
+    auto pick_live = [&]() -> long {
+        while (!live.empty()) {
+            const size_t k = rng() % live.size();
+            if (ref.orders.count(live[k])) return live[k];
+            live[k] = live.back();
+            live.pop_back();
+        }
+        return 0;
+    };
+
+    for (long op = 0; op < ops; ++op) {
+        if (op % 100000 == 0) {                 // a new day on the same table
+            table.set_kind(kind);
+            book.reset();
+            ref = RefBook();
+            live.clear();
+        }
+        if (rng() % 2000 == 0) {
+            const int ticks = LADDER_WIDTH / 4 + (int)(rng() % LADDER_WIDTH);
+            mid += ((rng() & 1) ? ticks : -ticks) * LADDER_TICK;
+            if (mid < 1000 * LADDER_TICK) mid = 1000 * LADDER_TICK;
+        } else if (rng() % 20 == 0) {
+            mid += ((int)(rng() % 3) - 1) * LADDER_TICK;
+        }
+
+        LobsterMessage m{};
+        m.time = 34200.0 + (double)op * 1e-3;
+        const int r = (int)(rng() % 100);
+        if (r < 45 || live.empty()) {
+            m.type = 1;
+            m.direction = (rng() & 1) ? 1 : -1;
+            const int c = (int)(rng() % 100);
+            if      (c < 80) m.order_id = next_id++;
+            else if (c < 88) m.order_id = base - 1 - (long)(rng() % 50000);
+            else if (c < 94) m.order_id = pick_live();            // re-used id
+            else             m.order_id = base + (long)OrderTable::DENSE_MAX_SPAN + (long)(rng() % 100000);
+            const int off = 1 + (int)(rng() % 25) + (rng() % 10 == 0 ? (int)(rng() % 200) : 0);
+            m.price = mid + (m.direction == 1 ? -off : off) * LADDER_TICK;
+            if (rng() % 20 == 0) m.price += 1 + (int)(rng() % (LADDER_TICK - 1));   // sub-penny
+            m.size = 1 + (int)(rng() % 400);
+            if (rng() % 500 == 0) m.size = 0;                     // ignored by both
+            if (m.order_id == 0) m.order_id = next_id++;
+            if (!ref.orders.count(m.order_id)) live.push_back(m.order_id);
+        } else {
+            m.type = r < 65 ? 2 : r < 85 ? 3 : r < 97 ? 4 : 5;
+            m.order_id = (rng() % 50 == 0) ? base - 900000 : pick_live();   // sometimes unknown
+            auto it = ref.orders.find(m.order_id);
+            const int have = it == ref.orders.end() ? 100 : it->second.size;
+            m.size = (rng() % 4 == 0) ? have + (int)(rng() % 3) : 1 + (int)(rng() % have);
+            if (it != ref.orders.end()) {
+                m.price = it->second.price;
+                m.direction = it->second.direction;
+            }
+        }
+
+        book.process_message(m);
+        ref.process(m);
+
+        std::string diff = book_diff(book, ref, op % 64 == 0);
+        if (diff.empty() && table.size() != ref.orders.size())
+            diff = "live orders " + std::to_string(table.size()) + " vs " + std::to_string(ref.orders.size());
+        if (diff.empty() && op % 5000 == 4999) {
+            // Through a checkpoint into a book of the other ladder kind.
+            blob.clear();
+            book.save_checkpoint(blob);
+            OrderBook copy(ladder == LadderKind::MAP ? LadderKind::FLAT : LadderKind::MAP);
+            if (!copy.restore_checkpoint(blob.data(), blob.size())) diff = "checkpoint did not restore";
+            else if (!(diff = book_diff(copy, ref, true)).empty()) diff = "after checkpoint: " + diff;
+        }
+        if (!diff.empty()) {
+            std::cerr << "MISMATCH " << name << " seed=" << seed << " op=" << op << " type=" << m.type
+                      << " id=" << m.order_id << " price=" << m.price << ": " << diff << "\n";
+            return false;
+        }
+    }
+    std::cout << "ok   " << name << " seed=" << seed << "  msgs=" << ops
+              << "  bid_levels=" << ref.bids.size() << "  ask_levels=" << ref.asks.size() << "\n";
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    int runs = 2;
+    long ops = 600000;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string a = argv[i];
+        if (a == "-n") runs = std::atoi(argv[i + 1]);
+        else if (a == "-o") ops = std::atol(argv[i + 1]);
+    }
+
+    size_t failed = 0, total = 0;
+    for (int k = 0; k < runs; ++k) {
+        const uint64_t seed = 20260108 + (uint64_t)k;
+        for (OrderTableKind kind : {OrderTableKind::HASH, OrderTableKind::DENSE}) {
+            failed += !table_run(kind, seed, ops);
+            ++total;
+            for (LadderKind ladder : {LadderKind::MAP, LadderKind::FLAT}) {
+                failed += !book_run(ladder, kind, seed, ops / 2);
+                ++total;
+            }
+        }
+    }
+    if (failed) {
+        std::cerr << failed << " of " << total << " runs differ\n";
+        return 1;
+    }
+    std::cout << "all " << total << " runs match\n";
+    return 0;
+}
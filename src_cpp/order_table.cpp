@@ -0,0 +1,156 @@
+// Open-addressing order-id table (layout described in order_table.h)
+#include "order_table.h"
+#include <algorithm>
+#include <cstddef>
+
+bool order_table_kind_from_string(const std::string& name, OrderTableKind* kind) {
+    if      (name == "hash")  *kind = OrderTableKind::HASH;
+    else if (name == "dense") *kind = OrderTableKind::DENSE;
+    else return false;
+    return true;
+}
+
+const char* order_table_kind_name(OrderTableKind kind) {
+    return kind == OrderTableKind::DENSE ? "dense" : "hash";
+}
+
+OrderTable::OrderTable(OrderTableKind kind)
+    : slots_(INITIAL_SLOTS, Slot{0, {0, 0, 0}, 0}),
+      mask_(INITIAL_SLOTS - 1),
+      dense_enabled_(kind == OrderTableKind::DENSE) {}
+
+void OrderTable::clear() {
+    if (hash_live_) {
+        for (auto& s : slots_) s.dist = 0;
+        hash_live_ = 0;
+    }
+    std::fill(dense_.begin(), dense_.begin() + dense_used_, BookOrder{0, 0, 0});
+    dense_used_ = 0;
+    dense_based_ = false;
+    live_ = 0;
+    st_ = OrderTableStats();
+}
+
+OrderTableStats OrderTable::stats() const {
+    OrderTableStats s = st_;
+    s.capacity = slots_.size();
+    return s;
+}
+
+// ── Hash path ───────────────────────────────────────────────
+
+OrderTable::Slot* OrderTable::hash_find(long id) {
+    size_t i = home(id);
+    uint32_t d = 1;
+    ++st_.lookups;
+    for (;; i = (i + 1) & mask_, ++d) {
+        Slot& s = slots_[i];
+        if (s.dist < d) break;               // empty, or would have been placed earlier
+        if (s.key == id) { st_.probes += d; st_.max_probe = std::max<size_t>(st_.max_probe, d); return &s; }
+    }
+    st_.probes += d;
+    st_.max_probe = std::max<size_t>(st_.max_probe, d);
+    return nullptr;
+}
+
+// Robin Hood insert of a key known to be absent.
+void OrderTable::hash_place(long id, const BookOrder& order) {
+    if ((hash_live_ + 1) * 4 > slots_.size() * 3) grow();
+    Slot carry{id, order, 1};
+    for (size_t i = home(id);; i = (i + 1) & mask_, ++carry.dist) {
+        Slot& s = slots_[i];
+        if (s.dist == 0) { s = carry; break; }
+        if (s.dist < carry.dist) std::swap(s, carry);
+    }
+    ++hash_live_;
+}
+
+void OrderTable::grow() {
+    std::vector<Slot> old(slots_.size() * 2, Slot{0, {0, 0, 0}, 0});
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    hash_live_ = 0;
+    for (const auto& s : old) {
+        if (s.dist) hash_place(s.key, s.val);
+    }
+}
+
+// ── Dense path ──────────────────────────────────────────────
+
+long OrderTable::dense_index(long id, bool for_insert) {
+    if (!dense_enabled_) return -1;
+    if (!dense_based_) {
+        if (!for_insert) return -1;
+        dense_base_ = id;
+        dense_based_ = true;
+    }
+    if (id < dense_base_) return -1;
+    size_t off = (size_t)(id - dense_base_);
+    if (off < dense_.size()) return (long)off;
+    if (!for_insert || off >= DENSE_MAX_SPAN) return -1;
+
+    // Widen the span; hash entries that now fall inside it move over,
+    // so an id in the span is always in the dense vector.
+    size_t span = std::max({dense_.size() * 2, off + 1, INITIAL_SLOTS});
+    dense_.resize(std::min(span, DENSE_MAX_SPAN), BookOrder{0, 0, 0});
+    if (hash_live_) {
+        std::vector<Slot> moved;
+        for (const auto& s : slots_) {
+            if (s.dist && s.key >= dense_base_ && (size_t)(s.key - dense_base_) < dense_.size())
+                moved.push_back(s);
+        }
+        for (const auto& s : moved) {
+            erase(&hash_find(s.key)->val);
+            size_t k = (size_t)(s.key - dense_base_);
+            dense_[k] = s.val;
+            dense_used_ = std::max(dense_used_, k + 1);
+            ++live_;
+        }
+    }
+    return (long)off;
+}
+
+// ── Public interface ────────────────────────────────────────
+
+BookOrder* OrderTable::find(long id) {
+    long k = dense_index(id, false);
+    if (k >= 0) {
+        ++st_.dense_hits;
+        return dense_[k].size > 0 ? &dense_[k] : nullptr;
+    }
+    Slot* s = hash_find(id);
+    return s ? &s->val : nullptr;
+}
+
+void OrderTable::insert(long id, const BookOrder& order) {
+    long k = dense_index(id, true);
+    if (k >= 0) {
+        ++st_.dense_hits;
+        if (dense_[k].size <= 0) ++live_;
+        dense_[k] = order;
+        dense_used_ = std::max(dense_used_, (size_t)k + 1);
+    } else if (Slot* s = hash_find(id)) {
+        s->val = order;
+    } else {
+        hash_place(id, order);
+        ++live_;
+    }
+    st_.peak_live = std::max(st_.peak_live, live_);
+}
+
+void OrderTable::erase(BookOrder* order) {
+    --live_;
+    if (!dense_.empty() && order >= dense_.data() && order < dense_.data() + dense_.size()) {
+        order->size = 0;
+        return;
+    }
+    // Backward-shift deletion: pull the following cluster back one slot.
+    size_t i = (size_t)(reinterpret_cast<Slot*>(reinterpret_cast<char*>(order) - offsetof(Slot, val))
+                        - slots_.data());
+    for (size_t j = (i + 1) & mask_; slots_[j].dist > 1; i = j, j = (j + 1) & mask_) {
+        slots_[i] = slots_[j];
+        --slots_[i].dist;
+    }
+    slots_[i].dist = 0;
+    --hash_live_;
+}
@@ -0,0 +1,122 @@
+#ifndef ORDER_TABLE_H
+#define ORDER_TABLE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// ─────────────────────────────────────────────────────────────
+// OrderTable: live orders of one book, keyed by LOBSTER order id
+// ─────────────────────────────────────────────────────────────
+//
+// Open-addressing hash table with Robin Hood linear probing and
+// backward-shift deletion: entries sit inline in one flat slot
+// array (no per-order heap node), a lookup touches one or two cache
+// lines, and no tombstones build up over a day of cancels.
+//
+// Optional dense path (-O dense): ids in [base, base + span) — base
+// is the day's first order id — are stored directly at index
+// id − base in a plain vector, no hashing at all.  The span grows
+// by doubling up to DENSE_MAX_SPAN ids; ids outside it go to the
+// hash table.  This pays off when a feed numbers one symbol's
+// orders nearly consecutively; for exchange-wide ITCH reference
+// numbers most ids fall outside the span and the hash path serves
+// them, as stats().dense_hits shows.
+//
+// clear() keeps all capacity, so one table per worker thread is
+// recycled day after day without reallocating (see OrderBook).
+// ─────────────────────────────────────────────────────────────
+
+struct BookOrder {
+    int price;
+    int size;        // > 0 while the order is live
+    int direction;   // 1 = buy (bid),  -1 = sell (ask)
+};
+
+enum class OrderTableKind { HASH, DENSE };
+
+// "hash" / "dense" → *kind.  False, and *kind untouched, for any other name.
+bool order_table_kind_from_string(const std::string& name, OrderTableKind* kind);
+const char* order_table_kind_name(OrderTableKind kind);
+
+struct OrderTableStats {
+    size_t peak_live  = 0;   // most orders live at once
+    size_t lookups    = 0;   // hash-path finds + inserts
+    size_t probes     = 0;   // slots examined by those lookups
+    size_t max_probe  = 0;   // longest probe sequence seen
+    size_t dense_hits = 0;   // finds + inserts served by the dense vector
+    size_t capacity   = 0;   // hash slots currently allocated
+
+    double mean_probe() const { return lookups ? (double)probes / (double)lookups : 0.0; }
+};
+
+class OrderTable {
+public:
+    static constexpr size_t INITIAL_SLOTS  = size_t(1) << 16;
+    static constexpr size_t DENSE_MAX_SPAN = size_t(1) << 21;   // ids (12 B each)
+
+    explicit OrderTable(OrderTableKind kind = OrderTableKind::HASH);
+
+    OrderTable(const OrderTable&) = delete;
+    OrderTable& operator=(const OrderTable&) = delete;
+
+    // nullptr if the id is not live.
+    BookOrder* find(long id);
+
+    // Insert or overwrite.
+    void insert(long id, const BookOrder& order);
+
+    // `order` must come from find() with no insert/erase in between.
+    void erase(BookOrder* order);
+
+    // Drop every order and reset stats; capacity is kept.
+    void clear();
+
+    void set_kind(OrderTableKind kind) { dense_enabled_ = (kind == OrderTableKind::DENSE); }
+
+    size_t size() const { return live_; }
+    OrderTableStats stats() const;
+
+    // Call fn(id, order) for every live order, in no particular order.
+    template <class Fn>
+    void for_each(Fn fn) const {
+        for (size_t k = 0; k < dense_used_; ++k) {
+            if (dense_[k].size > 0) fn(dense_base_ + (long)k, dense_[k]);
+        }
+        for (const auto& s : slots_) {
+            if (s.dist) fn(s.key, s.val);
+        }
+    }
+
+private:
+    struct Slot {
+        long      key;
+        BookOrder val;
+        uint32_t  dist;      // probe distance + 1; 0 = empty
+    };
+
+    std::vector<Slot> slots_;
+    size_t mask_ = 0;
+    size_t hash_live_ = 0;
+
+    bool dense_enabled_;
+    bool dense_based_ = false;
+    long dense_base_ = 0;
+    size_t dense_used_ = 0;              // high-water index + 1 since clear()
+    std::vector<BookOrder> dense_;
+
+    size_t live_ = 0;
+    OrderTableStats st_;
+
+    size_t home(long id) const {
+        return (size_t)(((uint64_t)id * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+    }
+    // Dense index for id, or -1 if it belongs in the hash table.
+    long dense_index(long id, bool for_insert);
+    Slot* hash_find(long id);
+    void  hash_place(long id, const BookOrder& order);
+    void  grow();
+};
+
+#endif
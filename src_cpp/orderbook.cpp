@@ -1,11 +1,34 @@
 #include "orderbook.h"
+#include "varint.h"
+#include <algorithm>
+#include <climits>
 
-OrderBook::OrderBook() {}
+bool ladder_kind_from_string(const std::string& name, LadderKind* kind) {
+    if      (name == "map")  *kind = LadderKind::MAP;
+    else if (name == "flat") *kind = LadderKind::FLAT;
+    else return false;
+    return true;
+}
+
+const char* ladder_kind_name(LadderKind kind) {
+    return kind == LadderKind::FLAT ? "flat" : "map";
+}
+
+OrderBook::OrderBook(LadderKind ladder, OrderTable* orders)
+    : own_orders_(orders ? nullptr : new OrderTable()),
+      orders_(orders ? orders : own_orders_.get()),
+      flat_(ladder == LadderKind::FLAT) {
+    orders_->clear();
+}
 
 void OrderBook::reset() {
-    orders_.clear();
+    orders_->clear();
     bids_.clear();
     asks_.clear();
+    flat_bids_.clear();
+    flat_asks_.clear();
+    top_bid_.n = 0;
+    top_ask_.n = 0;
 }
 
 // ── Internal helpers ────────────────────────────────────────
@@ -14,57 +37,271 @@ void OrderBook::add_order(long order_id, int price, int size, int direction) {
     // Guard: ignore nonsense prices / sizes
     if (price <= 0 || size <= 0) return;
 
-    orders_[order_id] = {price, size, direction};
+    orders_->insert(order_id, {price, size, direction});
 
-    if (direction == 1) {
-        bids_[price] += size;
+    const bool bid = (direction == 1);
+    int old_vol;
+    if (flat_) {
+        old_vol = (bid ? flat_bids_ : flat_asks_).add(price, size);
     } else {
-        asks_[price] += size;
+        int& lv = (bid ? bids_ : asks_)[price];
+        old_vol = lv;
+        lv += size;
+    }
+    note_level(bid, price, old_vol, old_vol + size);
+    update_top(bid, price, old_vol, old_vol + size);
+}
+
+void OrderBook::reduce_level(bool bid, int price, int size_delta) {
+    int old_vol = 0;
+    if (flat_) {
+        old_vol = (bid ? flat_bids_ : flat_asks_).reduce(price, size_delta);
+    } else {
+        auto& side = bid ? bids_ : asks_;
+        auto pl = side.find(price);
+        if (pl != side.end()) {
+            old_vol = pl->second;
+            pl->second -= size_delta;
+            if (pl->second <= 0) side.erase(pl);
+        }
+    }
+    if (old_vol > 0) {
+        note_level(bid, price, old_vol, old_vol - size_delta);
+        update_top(bid, price, old_vol, old_vol - size_delta);
     }
 }
 
 void OrderBook::reduce_order(long order_id, int size_delta) {
-    auto it = orders_.find(order_id);
-    if (it == orders_.end()) return;           // unknown order – skip
+    Order* it = orders_->find(order_id);
+    if (!it) return;                           // unknown order – skip
 
-    Order& order = it->second;
-    auto& side = (order.direction == 1) ? bids_ : asks_;
+    Order& order = *it;
 
     // Shrink the price level
-    auto pl = side.find(order.price);
-    if (pl != side.end()) {
-        pl->second -= size_delta;
-        if (pl->second <= 0) side.erase(pl);
-    }
+    reduce_level(order.direction == 1, order.price, size_delta);
 
     // Shrink (or remove) the order itself
     order.size -= size_delta;
     if (order.size <= 0) {
-        orders_.erase(it);
+        orders_->erase(it);
     }
 }
 
 void OrderBook::delete_order(long order_id) {
-    auto it = orders_.find(order_id);
-    if (it == orders_.end()) return;           // unknown order – skip
+    Order* it = orders_->find(order_id);
+    if (!it) return;                           // unknown order – skip
+
+    const Order& order = *it;
+    reduce_level(order.direction == 1, order.price, order.size);
+    orders_->erase(it);
+}
 
-    const Order& order = it->second;
-    auto& side = (order.direction == 1) ? bids_ : asks_;
+void OrderBook::note_level(bool bid, int price, int old_vol, int new_vol) {
+    if (old_vol == new_vol) return;
+    level_side_  = bid ? 1 : -1;
+    level_price_ = price;
+    level_flags_ = BOOK_LEVEL_SIZE;
+    if (old_vol <= 0)      level_flags_ |= BOOK_LEVEL_NEW;
+    else if (new_vol <= 0) level_flags_ |= BOOK_LEVEL_GONE;
+}
+
+// ── Top-of-book level cache ─────────────────────────────────
 
-    auto pl = side.find(order.price);
-    if (pl != side.end()) {
-        pl->second -= order.size;
-        if (pl->second <= 0) side.erase(pl);
+void OrderBook::update_top(bool bid, int price, int old_vol, int new_vol) {
+    TopLevels& t = bid ? top_bid_ : top_ask_;
+
+    // Most messages land deeper than the cached levels.
+    if (t.n == BOOK_TOP_LEVELS &&
+        (bid ? price < t.price[BOOK_TOP_LEVELS - 1] : price > t.price[BOOK_TOP_LEVELS - 1])) {
+        return;
     }
 
-    orders_.erase(it);
+    // i = first cached level not better than price
+    int i = 0;
+    if (bid) { while (i < t.n && t.price[i] > price) ++i; }
+    else     { while (i < t.n && t.price[i] < price) ++i; }
+    const bool cached = (i < t.n && t.price[i] == price);
+
+    if (old_vol > 0 && new_vol > 0) {          // size change
+        if (cached) t.vol[i] = new_vol;
+        return;
+    }
+    if (new_vol > 0) {                         // new level
+        if (i >= BOOK_TOP_LEVELS) return;      // below the cached top
+        int last = std::min(t.n, BOOK_TOP_LEVELS - 1);
+        for (int k = last; k > i; --k) {
+            t.price[k] = t.price[k - 1];
+            t.vol[k]   = t.vol[k - 1];
+        }
+        t.price[i] = price;
+        t.vol[i]   = new_vol;
+        if (t.n < BOOK_TOP_LEVELS) ++t.n;
+        return;
+    }
+    if (!cached) return;                       // removed below the cached top
+
+    const bool was_full = (t.n == BOOK_TOP_LEVELS);
+    for (int k = i + 1; k < t.n; ++k) {
+        t.price[k - 1] = t.price[k];
+        t.vol[k - 1]   = t.vol[k];
+    }
+    --t.n;
+    if (was_full) {                            // pull the next level up
+        int vol;
+        int next = next_worse(bid, t.n ? t.price[t.n - 1] : price, vol);
+        if (next) {
+            t.price[t.n] = next;
+            t.vol[t.n]   = vol;
+            ++t.n;
+        }
+    }
+}
+
+int OrderBook::next_worse(bool bid, int price, int& vol) const {
+    if (flat_) return (bid ? flat_bids_ : flat_asks_).next_worse(price, vol);
+    if (bid) {
+        auto it = bids_.lower_bound(price);
+        if (it == bids_.begin()) return 0;
+        --it;
+        vol = it->second;
+        return it->first;
+    }
+    auto it = asks_.upper_bound(price);
+    if (it == asks_.end()) return 0;
+    vol = it->second;
+    return it->first;
+}
+
+// Depth beyond the cached levels: walk the ladder.
+int OrderBook::ladder_depth(bool bid, int levels) const {
+    if (flat_) return (bid ? flat_bids_ : flat_asks_).depth(levels);
+    int total = 0, count = 0;
+    if (bid) {
+        // bids_ is sorted ascending → iterate in reverse for top-of-book
+        for (auto it = bids_.rbegin(); it != bids_.rend(); ++it) {
+            total += it->second;
+            if (levels > 0 && ++count >= levels) break;
+        }
+    } else {
+        for (auto it = asks_.begin(); it != asks_.end(); ++it) {
+            total += it->second;
+            if (levels > 0 && ++count >= levels) break;
+        }
+    }
+    return total;
+}
+
+void OrderBook::rebuild_top(bool bid) {
+    TopLevels& t = bid ? top_bid_ : top_ask_;
+    t.n = 0;
+    int vol;
+    for (int px = bid ? INT_MAX : 0; t.n < BOOK_TOP_LEVELS; ++t.n) {
+        px = next_worse(bid, px, vol);
+        if (!px) break;
+        t.price[t.n] = px;
+        t.vol[t.n]   = vol;
+    }
+}
+
+// ── Checkpoints ─────────────────────────────────────────────
+//
+// Blob layout, all varints:
+//   n_orders, then per order in id order:
+//       zigzag(Δid), zigzag(Δprice), size, zigzag(direction)
+//   per side (bid, then ask): n_levels, then per level best first:
+//       zigzag(Δprice), size
+// Δ is against the previous entry of the same list (first against 0).
+
+void OrderBook::save_checkpoint(std::vector<uint8_t>& out) const {
+    std::vector<std::pair<long, BookOrder>> live;
+    live.reserve(orders_->size());
+    orders_->for_each([&](long id, const BookOrder& o) { live.push_back({id, o}); });
+    std::sort(live.begin(), live.end(),
+              [](const std::pair<long, BookOrder>& a, const std::pair<long, BookOrder>& b) {
+                  return a.first < b.first;
+              });
+
+    put_varint(out, live.size());
+    long prev_id = 0;
+    int  prev_px = 0;
+    for (const auto& [id, o] : live) {
+        put_varint(out, zigzag((int64_t)id - prev_id));
+        put_varint(out, zigzag((int64_t)o.price - prev_px));
+        put_varint(out, (uint64_t)o.size);
+        put_varint(out, zigzag(o.direction));
+        prev_id = id;
+        prev_px = o.price;
+    }
+
+    std::vector<std::pair<int, int>> levels;
+    for (bool bid : {true, false}) {
+        levels.clear();
+        int vol;
+        for (int px = bid ? INT_MAX : 0; (px = next_worse(bid, px, vol)) != 0;) {
+            levels.push_back({px, vol});
+        }
+        put_varint(out, levels.size());
+        prev_px = 0;
+        for (const auto& [px, v] : levels) {
+            put_varint(out, zigzag((int64_t)px - prev_px));
+            put_varint(out, (uint64_t)v);
+            prev_px = px;
+        }
+    }
+}
+
+bool OrderBook::restore_checkpoint(const uint8_t* data, size_t len) {
+    reset();
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+    uint64_t n = 0;
+
+    bool ok = get_varint(p, end, n);
+    long id = 0;
+    int  px = 0;
+    for (uint64_t k = 0; ok && k < n; ++k) {
+        uint64_t did, dpx, size, dir;
+        ok = get_varint(p, end, did) && get_varint(p, end, dpx) &&
+             get_varint(p, end, size) && get_varint(p, end, dir) && size > 0;
+        if (!ok) break;
+        id += (long)unzigzag(did);
+        px += (int)unzigzag(dpx);
+        orders_->insert(id, {px, (int)size, (int)unzigzag(dir)});
+    }
+
+    for (bool bid : {true, false}) {
+        ok = ok && get_varint(p, end, n);
+        px = 0;
+        for (uint64_t k = 0; ok && k < n; ++k) {
+            uint64_t dpx, size;
+            ok = get_varint(p, end, dpx) && get_varint(p, end, size) && size > 0;
+            if (!ok) break;
+            px += (int)unzigzag(dpx);
+            if (flat_) (bid ? flat_bids_ : flat_asks_).add(px, (int)size);
+            else       (bid ? bids_ : asks_)[px] = (int)size;
+        }
+    }
+    if (!ok || p != end) {
+        reset();
+        return false;
+    }
+    rebuild_top(true);
+    rebuild_top(false);
+    return true;
 }
 
 // ── Public interface ────────────────────────────────────────
 
-bool OrderBook::process_message(const LobsterMessage& msg) {
-    int old_bid = get_best_bid();
-    int old_ask = get_best_ask();
+void OrderBook::subscribe(uint32_t mask, DeltaHandler fn) {
+    subscribers_.push_back({mask, std::move(fn)});
+}
+
+BookDelta OrderBook::process_message(const LobsterMessage& msg) {
+    const int old_bid = get_best_bid(), old_bid_size = get_bid_volume_at_best();
+    const int old_ask = get_best_ask(), old_ask_size = get_ask_volume_at_best();
+    level_flags_ = 0;
+    level_side_  = 0;
+    level_price_ = 0;
 
     switch (msg.type) {
         case 1: add_order(msg.order_id, msg.price, msg.size, msg.direction);   break;
@@ -75,17 +312,32 @@ bool OrderBook::process_message(const LobsterMessage& msg) {
         default: break;
     }
 
-    return (get_best_bid() != old_bid || get_best_ask() != old_ask);
+    BookDelta d;
+    d.time        = msg.time;
+    d.side        = level_side_;
+    d.level_price = level_price_;
+    d.best_bid    = get_best_bid();
+    d.best_ask    = get_best_ask();
+    d.bid_size    = get_bid_volume_at_best();
+    d.ask_size    = get_ask_volume_at_best();
+    d.flags       = level_flags_;
+    if (d.best_bid != old_bid) d.flags |= BOOK_BID_PRICE | BOOK_BID_SIZE;
+    if (d.best_ask != old_ask) d.flags |= BOOK_ASK_PRICE | BOOK_ASK_SIZE;
+    if (d.bid_size != old_bid_size) d.flags |= BOOK_BID_SIZE;
+    if (d.ask_size != old_ask_size) d.flags |= BOOK_ASK_SIZE;
+
+    for (const auto& s : subscribers_) {
+        if (d.flags & s.mask) s.fn(d);
+    }
+    return d;
 }
 
 int OrderBook::get_best_bid() const {
-    if (bids_.empty()) return 0;
-    return bids_.rbegin()->first;     // highest buy price
+    return top_bid_.n ? top_bid_.price[0] : 0;     // highest buy price
 }
 
 int OrderBook::get_best_ask() const {
-    if (asks_.empty()) return 0;
-    return asks_.begin()->first;      // lowest sell price
+    return top_ask_.n ? top_ask_.price[0] : 0;     // lowest sell price
 }
 
 double OrderBook::get_mid_price() const {
@@ -96,7 +348,7 @@ double OrderBook::get_mid_price() const {
 }
 
 bool OrderBook::is_valid() const {
-    return !bids_.empty() && !asks_.empty();
+    return top_bid_.n > 0 && top_ask_.n > 0;
 }
 
 double OrderBook::get_spread() const {
@@ -106,33 +358,39 @@ double OrderBook::get_spread() const {
     return (double)(ask - bid) / 10000.0;
 }
 
-int OrderBook::get_bid_depth(int levels) const {
-    if (bids_.empty()) return 0;
-    int total = 0, count = 0;
-    // bids_ is sorted ascending → iterate in reverse for top-of-book
-    for (auto it = bids_.rbegin(); it != bids_.rend(); ++it) {
-        total += it->second;
-        if (levels > 0 && ++count >= levels) break;
-    }
+// Served from the level cache when it covers the request: levels within
+// BOOK_TOP_LEVELS, or a side with fewer levels than that in total.
+static int cached_depth(const int* vol, int n, int levels) {
+    int total = 0;
+    int m = (levels > 0 && levels < n) ? levels : n;
+    for (int k = 0; k < m; ++k) total += vol[k];
     return total;
 }
 
+int OrderBook::get_bid_depth(int levels) const {
+    if ((levels > 0 && levels <= BOOK_TOP_LEVELS) || top_bid_.n < BOOK_TOP_LEVELS)
+        return cached_depth(top_bid_.vol, top_bid_.n, levels);
+    return ladder_depth(true, levels);
+}
+
 int OrderBook::get_ask_depth(int levels) const {
-    if (asks_.empty()) return 0;
-    int total = 0, count = 0;
-    for (auto it = asks_.begin(); it != asks_.end(); ++it) {
-        total += it->second;
-        if (levels > 0 && ++count >= levels) break;
-    }
-    return total;
+    if ((levels > 0 && levels <= BOOK_TOP_LEVELS) || top_ask_.n < BOOK_TOP_LEVELS)
+        return cached_depth(top_ask_.vol, top_ask_.n, levels);
+    return ladder_depth(false, levels);
 }
 
 int OrderBook::get_bid_volume_at_best() const {
-    if (bids_.empty()) return 0;
-    return bids_.rbegin()->second;
+    return top_bid_.n ? top_bid_.vol[0] : 0;
 }
 
 int OrderBook::get_ask_volume_at_best() const {
-    if (asks_.empty()) return 0;
-    return asks_.begin()->second;
+    return top_ask_.n ? top_ask_.vol[0] : 0;
+}
+
+int OrderBook::get_bid_level_volume(int level) const {
+    return (level >= 1 && level <= top_bid_.n) ? top_bid_.vol[level - 1] : 0;
+}
+
+int OrderBook::get_ask_level_volume(int level) const {
+    return (level >= 1 && level <= top_ask_.n) ? top_ask_.vol[level - 1] : 0;
 }
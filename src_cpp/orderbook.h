@@ -2,8 +2,15 @@
 #define ORDERBOOK_H
 
 #include "types.h"
-#include <unordered_map>
+#include "price_ladder.h"
+#include "order_table.h"
+#include "node_pool.h"
 #include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
 
 // ─────────────────────────────────────────────────────────────
 // OrderBook: Top-of-Book Reconstruction from LOBSTER Messages
@@ -21,15 +28,102 @@
 //   5  Hidden exec      → no visible-book impact
 //   6  Cross trade      → no book impact
 //   7  Trading halt     → no book impact
+//
+// Price levels are kept in one of two interchangeable ladders:
+//   MAP   — std::map<int,int> per side (red-black tree), its nodes
+//           recycled through a NodePool (node_pool.h)
+//   FLAT  — FlatLadder per side: tick-indexed array around the touch
+//           with an occupancy bitmap (see price_ladder.h)
+// Both give identical results through the public API.  The default
+// is MAP; build with `make LADDER=flat` (-DORDERBOOK_FLAT_LADDER) to
+// flip it, or pick per run with -B map|flat.
+//
+// Live orders are kept in an OrderTable (order_table.h).  A book can
+// borrow a caller-owned table — one per worker thread — so its
+// storage is reused from day to day instead of rebuilt; the book
+// clears it on construction and reset().
+//
+// On top of either ladder the book keeps the best BOOK_TOP_LEVELS
+// levels of each side in a small sorted array, updated on every
+// message that touches them (a level that drops out is refilled
+// from the ladder with one next-worse lookup).  Best price, size at
+// best, per-level sizes and depth over up to BOOK_TOP_LEVELS levels
+// are read from it without touching the ladder.
+//
+// save_checkpoint / restore_checkpoint copy the complete book — every
+// live order and every price level — to and from a compact byte blob
+// (varint deltas, see below), so a replay can resume mid-day from a
+// checkpoint instead of from the first row (book_index.h).  Levels
+// are stored as they are rather than re-summed from the orders, so a
+// restored book is identical even where a feed's level and order
+// sizes have drifted apart.
 // ─────────────────────────────────────────────────────────────
 
+constexpr int BOOK_TOP_LEVELS = 10;
+
+// ── BookDelta: what one message did to the book ─────────────
+//
+// Returned by process_message and passed to subscribers, so callers
+// react to events instead of polling the book after every message.
+
+enum BookDeltaFlag : uint32_t {
+    BOOK_BID_PRICE  = 1u << 0,   // best bid price changed (incl. side (un)emptied)
+    BOOK_ASK_PRICE  = 1u << 1,   // best ask price changed
+    BOOK_BID_SIZE   = 1u << 2,   // size at the best bid changed (or its price did)
+    BOOK_ASK_SIZE   = 1u << 3,   // size at the best ask changed
+    BOOK_LEVEL_NEW  = 1u << 4,   // a price level was created
+    BOOK_LEVEL_GONE = 1u << 5,   // a price level was removed
+    BOOK_LEVEL_SIZE = 1u << 6,   // some level changed size (any visible change)
+};
+
+struct BookDelta {
+    double   time       = 0.0;   // message time
+    uint32_t flags      = 0;     // BookDeltaFlag bits
+    int      side       = 0;     // side of the touched level: 1 bid, -1 ask, 0 none
+    int      level_price = 0;    // price of the touched level
+    int      best_bid   = 0;     // after the message (0 = side empty)
+    int      best_ask   = 0;
+    int      bid_size   = 0;     // size at best bid / ask after the message
+    int      ask_size   = 0;
+
+    bool bbo_changed() const { return flags & (BOOK_BID_PRICE | BOOK_ASK_PRICE); }
+    bool valid() const { return best_bid != 0 && best_ask != 0; }
+    // Same value as OrderBook::get_mid_price() (0 when not valid)
+    double mid() const {
+        if (!valid()) return 0.0;
+        return ((double)best_bid + (double)best_ask) / 2.0 / 10000.0;
+    }
+};
+
+enum class LadderKind { MAP, FLAT };
+
+#ifdef ORDERBOOK_FLAT_LADDER
+constexpr LadderKind DEFAULT_LADDER = LadderKind::FLAT;
+#else
+constexpr LadderKind DEFAULT_LADDER = LadderKind::MAP;
+#endif
+
+// "map" / "flat" → *kind.  False, and *kind untouched, for any other name.
+bool ladder_kind_from_string(const std::string& name, LadderKind* kind);
+const char* ladder_kind_name(LadderKind kind);
+
 class OrderBook {
 public:
-    OrderBook();
+    explicit OrderBook(LadderKind ladder = DEFAULT_LADDER, OrderTable* orders = nullptr);
+
+    OrderBook(const OrderBook&) = delete;
+    OrderBook& operator=(const OrderBook&) = delete;
 
-    // Process a single LOBSTER message.
-    // Returns true if the BBO (best bid or best ask) changed.
-    bool process_message(const LobsterMessage& msg);
+    // Process a single LOBSTER message and report what changed.
+    // delta.bbo_changed() is true if the best bid or best ask moved.
+    BookDelta process_message(const LobsterMessage& msg);
+
+    // Call fn after every message whose delta has any of the `mask`
+    // flags set, in subscription order.  Subscriptions last for the
+    // book's lifetime (reset() keeps them) or until unsubscribe_all().
+    using DeltaHandler = std::function<void(const BookDelta&)>;
+    void subscribe(uint32_t mask, DeltaHandler fn);
+    void unsubscribe_all() { subscribers_.clear(); }
 
     // Current mid-price in dollar terms:  (best_bid + best_ask) / 2 / 10000
     double get_mid_price() const;
@@ -50,31 +144,83 @@ public:
     int get_bid_volume_at_best() const;
     int get_ask_volume_at_best() const;
 
+    // Volume at the level-th best price (1 = best, up to BOOK_TOP_LEVELS);
+    // 0 if the side has fewer levels.
+    int get_bid_level_volume(int level) const;
+    int get_ask_level_volume(int level) const;
+
     // True when both sides of the book have at least one resting order
     bool is_valid() const;
 
     // Reset for a new trading day (clears all state)
     void reset();
 
+    // Append the whole book to `out`.  Independent of the ladder and
+    // order-table kinds, so any book can restore it.
+    void save_checkpoint(std::vector<uint8_t>& out) const;
+
+    // Replace the book's contents with a saved one.  Subscribers are
+    // kept and not called.  False (book left empty) on a malformed blob.
+    bool restore_checkpoint(const uint8_t* data, size_t len);
+
+    // Order-table sizing stats since construction / reset().
+    OrderTableStats order_stats() const { return orders_->stats(); }
+
 private:
     // Per-order tracking for O(1) lookup on cancel / exec
-    struct Order {
-        int price;
-        int size;
-        int direction;   // 1 = buy (bid),  -1 = sell (ask)
-    };
+    using Order = BookOrder;
 
-    std::unordered_map<long, Order> orders_;   // order_id → details
+    std::unique_ptr<OrderTable> own_orders_;   // when no table is lent
+    OrderTable* orders_;                       // order_id → details
 
     // Price-level aggregation (total resting size at each price)
     //   bids_: highest key = best bid
     //   asks_: lowest  key = best ask
-    std::map<int, int> bids_;
-    std::map<int, int> asks_;
+    // Both draw their nodes from level_pool_, declared first so it
+    // outlives them.
+    using LevelMap = std::map<int, int, std::less<int>, PoolAllocator<std::pair<const int, int>>>;
+    NodePool level_pool_;
+    LevelMap bids_{std::less<int>(), PoolAllocator<std::pair<const int, int>>(&level_pool_)};
+    LevelMap asks_{std::less<int>(), PoolAllocator<std::pair<const int, int>>(&level_pool_)};
+
+    // FLAT ladder (used instead of bids_/asks_ when flat_)
+    bool       flat_;
+    FlatLadder flat_bids_{true};
+    FlatLadder flat_asks_{false};
+
+    // Best BOOK_TOP_LEVELS levels of a side, best first.
+    struct TopLevels {
+        int n = 0;
+        int price[BOOK_TOP_LEVELS];
+        int vol[BOOK_TOP_LEVELS];
+    };
+    TopLevels top_bid_, top_ask_;
+
+    // Level event of the message being processed (see process_message).
+    uint32_t level_flags_ = 0;
+    int      level_side_ = 0;
+    int      level_price_ = 0;
+
+    struct Subscriber {
+        uint32_t     mask;
+        DeltaHandler fn;
+    };
+    std::vector<Subscriber> subscribers_;
 
     void add_order(long order_id, int price, int size, int direction);
     void reduce_order(long order_id, int size_delta);   // type 2 / 4
     void delete_order(long order_id);                    // type 3
+
+    // Level `price` went from old_vol to new_vol (<= 0 = removed).
+    void update_top(bool bid, int price, int old_vol, int new_vol);
+    void note_level(bool bid, int price, int old_vol, int new_vol);
+    // Shrink a level by size_delta in the active ladder.
+    void reduce_level(bool bid, int price, int size_delta);
+    // Best level strictly worse than `price` in the active ladder (0 = none).
+    int  next_worse(bool bid, int price, int& vol) const;
+    int  ladder_depth(bool bid, int levels) const;
+    // Refill a side's level cache from its ladder.
+    void rebuild_top(bool bid);
 };
 
 #endif
@@ -0,0 +1,143 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <cstddef>
+#include <fcntl.h>
+#include <unistd.h>
+
+// ─────────────────────────────────────────────────────────────
+// OutputWriter: one thread for all output file writes
+// ─────────────────────────────────────────────────────────────
+//
+// The thread that commits a day hands its rows over as one block of
+// bytes and goes back to replaying; the writer thread write()s the
+// blocks, each file's in the order they were handed over, and closes
+// a file after its last block.  At most `max_blocks` blocks wait at
+// once: a committer that would exceed it waits, so output that the
+// disk cannot keep up with holds the workers rather than memory.
+//
+// Written blocks are kept (capacity only) for buffer(), so day
+// formatting reuses the same few buffers instead of allocating a new
+// one every day.
+// ─────────────────────────────────────────────────────────────
+
+class OutputWriter {
+public:
+    explicit OutputWriter(size_t max_blocks)
+        : max_blocks_(max_blocks ? max_blocks : 1), thread_([this] { run(); }) {}
+
+    ~OutputWriter() { finish(); }
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    // Create / truncate `path` for write(); -1 (errno set) on failure.
+    static int open(const std::string& path) {
+        return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    }
+
+    // An empty buffer, recycled from a written block when there is one.
+    std::string buffer() {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (spare_.empty()) return std::string();
+        std::string b = std::move(spare_.back());
+        spare_.pop_back();
+        return b;
+    }
+
+    // Return a buffer that will not be written.
+    void recycle(std::string&& b) {
+        b.clear();
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (spare_.size() < max_blocks_ * 2) spare_.push_back(std::move(b));
+    }
+
+    // Queue `bytes` for fd, after everything queued for it so far.
+    void write(int fd, std::string&& bytes) { put({fd, std::move(bytes), false}); }
+
+    // Close fd once its queued blocks are written.
+    void close(int fd) { put({fd, std::string(), true}); }
+
+    // Write everything queued and stop the thread.
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            if (done_) return;
+            done_ = true;
+        }
+        queued_.notify_all();
+        thread_.join();
+    }
+
+    // First write / close error ("" if none).
+    std::string error() const {
+        std::lock_guard<std::mutex> lk(mutex_);
+        return error_;
+    }
+
+private:
+    struct Block {
+        int         fd;
+        std::string bytes;
+        bool        close;
+    };
+
+    void put(Block&& b) {
+        std::unique_lock<std::mutex> lk(mutex_);
+        room_.wait(lk, [&] { return queue_.size() < max_blocks_; });
+        queue_.push_back(std::move(b));
+        lk.unlock();
+        queued_.notify_one();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lk(mutex_);
+        for (;;) {
+            queued_.wait(lk, [&] { return !queue_.empty() || done_; });
+            if (queue_.empty()) return;
+            Block b = std::move(queue_.front());
+            queue_.pop_front();
+            lk.unlock();
+            room_.notify_one();
+
+            const char* err = nullptr;
+            if (b.close) {
+                if (::close(b.fd) != 0) err = "close";
+            } else {
+                for (size_t at = 0; at < b.bytes.size();) {
+                    const ssize_t n = ::write(b.fd, b.bytes.data() + at, b.bytes.size() - at);
+                    if (n < 0 && errno == EINTR) continue;
+                    if (n <= 0) { err = "write"; break; }
+                    at += (size_t)n;
+                }
+            }
+            const int e = errno;
+
+            lk.lock();
+            if (err && error_.empty()) error_ = std::string(err) + ": " + std::strerror(e);
+            if (!b.close && spare_.size() < max_blocks_ * 2) {
+                b.bytes.clear();
+                spare_.push_back(std::move(b.bytes));
+            }
+        }
+    }
+
+    const size_t max_blocks_;
+    mutable std::mutex mutex_;
+    std::condition_variable queued_, room_;
+    std::deque<Block> queue_;
+    std::vector<std::string> spare_;
+    std::string error_;
+    bool done_ = false;
+    std::thread thread_;   // last: starts once the rest is built
+};
+
+#endif
@@ -2,20 +2,91 @@
 #include "parser.h"
 #include <iostream>
 #include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-LobsterParser::LobsterParser(std::string filename) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PARSER_X86 1
+#endif
+
+// Bytes covered by one separator index (LobsterParser::index_block).
+// 32 KiB of CSV ≈ 700 rows; the offset array is 4 × that at worst.
+static constexpr size_t PARSE_BLOCK = 32 * 1024;
+
+// Rows whose fields are decoded together (LobsterParser::decode_indexed_rows).
+static constexpr size_t ROW_BATCH = 256;
+
+bool parse_mode_from_string(const std::string& name, ParseMode* mode) {
+    if      (name == "mmap")   *mode = ParseMode::MMAP;
+    else if (name == "stream") *mode = ParseMode::STREAM;
+    else return false;
+    return true;
+}
+
+LobsterParser::LobsterParser(std::string filename, ParseMode mode) : mode_(mode) {
+    if (is_lobbin_path(filename)) {
+        bin_.reset(new LobbinReader(filename));
+        if (!bin_->ok()) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            failed_ = true;
+        }
+        return;
+    }
+    if (mode_ == ParseMode::MMAP) {
+        if (!open_mmap(filename)) {
+            std::cerr << "Error: Could not open file " << filename << std::endl;
+            failed_ = true;
+        }
+        return;
+    }
     file_.open(filename);
     if (!file_.is_open()) {
         std::cerr << "Error: Could not open file " << filename << std::endl;
+        failed_ = true;
     }
 }
 
 LobsterParser::~LobsterParser() {
+    if (map_base_) {
+        munmap((void*)map_base_, map_size_);
+    }
     if (file_.is_open()) {
         file_.close();
     }
 }
 
+// Map the whole file read-only.  An empty file is a valid (empty) day,
+// so it opens successfully with cur_ == end_.
+bool LobsterParser::open_mmap(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+    if (st.st_size == 0)      { ::close(fd); return true; }
+
+    void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // the mapping keeps its own reference to the file
+    if (base == MAP_FAILED) return false;
+
+    // One front-to-back pass: let the kernel read ahead aggressively and
+    // drop pages behind us instead of keeping a multi-GB day resident.
+    madvise(base, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    map_base_ = (const char*)base;
+    map_size_ = (size_t)st.st_size;
+    cur_ = map_base_;
+    end_ = map_base_ + map_size_;
+    return true;
+}
+
 // Helper: fast integer parse advancing pointer past trailing comma.
 // Handles optional leading '-' for signed fields (direction, price).
 static inline long fast_parse_long(const char*& p) {
@@ -27,13 +98,9 @@ static inline long fast_parse_long(const char*& p) {
     return val * sign;
 }
 
-bool LobsterParser::next_message(LobsterMessage& msg) {
-    std::string line;
-    if (!std::getline(file_, line)) {
-        return false; // EOF
-    }
-
-    const char* p = line.c_str();
+// Parse one row starting at p.  The row must be terminated by a
+// character that is neither a digit, '-', nor ',' ('\0' or '\n').
+static inline void parse_row(const char* p, LobsterMessage& msg) {
     char* end;
 
     // Field 1: timestamp (double, high-precision seconds-past-midnight).
@@ -52,6 +119,644 @@ bool LobsterParser::next_message(LobsterMessage& msg) {
 
     // Field 7 (e.g. "null") is intentionally ignored — LOBSTER appends
     // an optional annotation column that the pipeline does not use.
+}
+
+// ── Separator index kernels ─────────────────────────────────
+//
+// Each kernel writes the offset of every ',' and '\n' in p[0..len)
+// to out[] (ascending) and returns the count.  out must hold len
+// entries.  The SIMD versions compare a whole vector of bytes
+// against both separators and walk the resulting bitmask.
+
+static size_t index_scalar(const char* p, size_t len, uint32_t* out) {
+    size_t n = 0;
+    for (size_t i = 0; i < len; ++i) {
+        if (p[i] == ',' || p[i] == '\n') out[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+#ifdef PARSER_X86
+__attribute__((target("sse2")))
+static size_t index_sse2(const char* p, size_t len, uint32_t* out) {
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i nl    = _mm_set1_epi8('\n');
+    size_t n = 0, i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        unsigned mask = (unsigned)_mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(v, comma), _mm_cmpeq_epi8(v, nl)));
+        while (mask) {
+            out[n++] = (uint32_t)(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    for (; i < len; ++i) {
+        if (p[i] == ',' || p[i] == '\n') out[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+__attribute__((target("avx2")))
+static size_t index_avx2(const char* p, size_t len, uint32_t* out) {
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i nl    = _mm256_set1_epi8('\n');
+    size_t n = 0, i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, comma), _mm256_cmpeq_epi8(v, nl)));
+        while (mask) {
+            out[n++] = (uint32_t)(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    for (; i < len; ++i) {
+        if (p[i] == ',' || p[i] == '\n') out[n++] = (uint32_t)i;
+    }
+    return n;
+}
+#endif
+
+// ── Field decoders ──────────────────────────────────────────
+//
+// Decode one field whose bounds [p, q) are already known from the
+// separator index.  They return false for anything that is not a
+// plain LOBSTER number, in which case the row is re-parsed with
+// parse_row() so the result matches STREAM mode exactly.
+//
+// The digits themselves are turned into a value by a Fields policy:
+//   digits(p, q, v)          unsigned integer
+//   decimal(p, q, m, frac)   digits with at most one '.': mantissa m
+//                            and the number of digits after the '.'
+// Both take 1..16 bytes and may read the 16 bytes before q.
+
+static const double kExactPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Byte at a time; also serves fields too long or too close to the start
+// of the mapping for the SIMD policy.
+struct ScalarFields {
+    static inline bool digits(const char* p, const char* q, uint64_t& v) {
+        v = 0;
+        for (; p < q; ++p) {
+            unsigned d = (unsigned)(unsigned char)*p - '0';
+            if (d > 9) return false;
+            v = v * 10 + d;
+        }
+        return true;
+    }
+
+    static inline bool decimal(const char* p, const char* q, uint64_t& m, int& frac) {
+        m = 0;
+        int digits = 0;
+        frac = -1;       // -1 until the '.' is seen, then #fraction digits
+        for (; p < q; ++p) {
+            unsigned d = (unsigned)(unsigned char)*p - '0';
+            if (d <= 9) {
+                if (++digits > 19) return false;
+                m = m * 10 + d;
+                if (frac >= 0) ++frac;
+            } else if (*p == '.' && frac < 0) {
+                frac = 0;
+            } else {
+                return false;
+            }
+        }
+        frac = std::max(frac, 0);
+        return digits > 0;
+    }
+};
+
+#ifdef __SSE2__
+// Loading 16 bytes from kTailMask + n keeps the last n lanes.
+alignas(16) static const uint8_t kTailMask[32] = {
+    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,    0,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+};
+
+// A whole field in one 16-byte load ending at q, right-aligned, with the
+// lanes before p masked to digit 0.  The lanes are folded pairwise by
+// multiply-add — 16 digits → 8 × 2 → 4 × 4 → 2 × 8 — and the two 8-digit
+// halves are joined in scalar.
+struct Sse2Fields {
+    static inline uint64_t lanes_value(__m128i d) {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i hi = _mm_madd_epi16(_mm_unpacklo_epi8(d, zero), _mm_set1_epi32(0x0001000A));
+        const __m128i lo = _mm_madd_epi16(_mm_unpackhi_epi8(d, zero), _mm_set1_epi32(0x0001000A));
+        const __m128i d4 = _mm_madd_epi16(_mm_packs_epi32(hi, lo), _mm_set1_epi32(0x00010064));
+        const __m128i d8 = _mm_madd_epi16(_mm_packs_epi32(d4, d4), _mm_set1_epi32(0x00012710));
+        return (uint64_t)(uint32_t)_mm_cvtsi128_si32(d8) * 100000000u +
+               (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(d8, 4));
+    }
+
+    // True if every lane of d is a digit value 0..9.
+    static inline bool all_digits(__m128i d) {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d)) == 0xFFFF;
+    }
+
+    static inline bool digits(const char* p, const char* q, uint64_t& v) {
+        const __m128i keep = _mm_loadu_si128((const __m128i*)(kTailMask + (q - p)));
+        const __m128i d = _mm_and_si128(
+            _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(q - 16)), _mm_set1_epi8('0')), keep);
+        if (!all_digits(d)) return false;
+        v = lanes_value(d);
+        return true;
+    }
+
+    // The '.' lane is cleared and the digits before it moved one lane
+    // towards the end, which leaves the mantissa's digits in place.
+    static inline bool decimal(const char* p, const char* q, uint64_t& m, int& frac) {
+        const int len = (int)(q - p);
+        const __m128i keep = _mm_loadu_si128((const __m128i*)(kTailMask + len));
+        const __m128i raw  = _mm_loadu_si128((const __m128i*)(q - 16));
+        const __m128i dot  = _mm_and_si128(_mm_cmpeq_epi8(raw, _mm_set1_epi8('.')), keep);
+        __m128i d = _mm_andnot_si128(dot, _mm_and_si128(_mm_sub_epi8(raw, _mm_set1_epi8('0')), keep));
+        if (!all_digits(d)) return false;
+
+        const unsigned dots = (unsigned)_mm_movemask_epi8(dot);
+        frac = 0;
+        if (dots) {
+            if (dots & (dots - 1)) return false;
+            const int at = __builtin_ctz(dots);
+            const __m128i tail = _mm_loadu_si128((const __m128i*)(kTailMask + (16 - at)));
+            d = _mm_or_si128(_mm_slli_si128(_mm_andnot_si128(tail, d), 1), _mm_and_si128(tail, d));
+            frac = 15 - at;
+            if (len == 1) return false;
+        }
+        m = lanes_value(d);
+        return true;
+    }
+};
+#endif
+
+// Timestamp "ddddd.ddddddddd".  The digits are gathered into an integer
+// mantissa m with k fractional digits.  When m < 2^53 and k <= 22, both
+// m and 10^k are exact doubles, so the single IEEE division m / 10^k is
+// correctly rounded — the same value strtod returns.
+template <class Fields>
+static inline bool decode_time(const char* lo, const char* p, const char* q, double& out) {
+    uint64_t m;
+    int frac;
+    const bool ok = (q - p <= 16 && q - lo >= 16 && p < q) ? Fields::decimal(p, q, m, frac)
+                                                           : ScalarFields::decimal(p, q, m, frac);
+    if (!ok || m >= (1ULL << 53) || frac > 22) return false;
+    out = (frac > 0) ? (double)m / kExactPow10[frac] : (double)m;
+    return true;
+}
+
+template <class Fields>
+static inline bool decode_long(const char* lo, const char* p, const char* q, long& out) {
+    bool neg = false;
+    if (p < q && *p == '-') { neg = true; ++p; }
+    if (p == q || q - p > 18) return false;
+    uint64_t v;
+    const bool ok = (q - p <= 16 && q - lo >= 16) ? Fields::digits(p, q, v)
+                                                  : ScalarFields::digits(p, q, v);
+    if (!ok) return false;
+    out = neg ? -(long)v : (long)v;
+    return true;
+}
+
+// Decode n rows of the block at blk from their spans; lo is the start of
+// the mapping (the lowest readable byte).  decoded[i] is 0 where row i
+// is left to parse_row().
+template <class Fields>
+static inline void decode_spans(const char* lo, const char* blk, const LobsterRowSpan* spans,
+                                size_t n, LobsterMessage* out, uint8_t* decoded) {
+    for (size_t i = 0; i < n; ++i) {
+        const LobsterRowSpan& s = spans[i];
+        LobsterMessage& msg = out[i];
+        long type, order_id, size, price, direction;
+        decoded[i] = s.fields == 6 &&
+            decode_time<Fields>(lo, blk + s.start,       blk + s.ends[0], msg.time) &&
+            decode_long<Fields>(lo, blk + s.ends[0] + 1, blk + s.ends[1], type) &&
+            decode_long<Fields>(lo, blk + s.ends[1] + 1, blk + s.ends[2], order_id) &&
+            decode_long<Fields>(lo, blk + s.ends[2] + 1, blk + s.ends[3], size) &&
+            decode_long<Fields>(lo, blk + s.ends[3] + 1, blk + s.ends[4], price) &&
+            decode_long<Fields>(lo, blk + s.ends[4] + 1, blk + s.ends[5], direction);
+        if (!decoded[i]) continue;
+        msg.type      = (int)type;
+        msg.order_id  = order_id;
+        msg.size      = (int)size;
+        msg.price     = (int)price;
+        msg.direction = (int)direction;
+    }
+}
+
+static void decode_spans_scalar(const char* lo, const char* blk, const LobsterRowSpan* spans,
+                                size_t n, LobsterMessage* out, uint8_t* decoded) {
+    decode_spans<ScalarFields>(lo, blk, spans, n, out, decoded);
+}
+
+#ifdef __SSE2__
+static void decode_spans_sse2(const char* lo, const char* blk, const LobsterRowSpan* spans,
+                              size_t n, LobsterMessage* out, uint8_t* decoded) {
+    decode_spans<Sse2Fields>(lo, blk, spans, n, out, decoded);
+}
+#else
+#define decode_spans_sse2 decode_spans_scalar
+#endif
+
+typedef size_t (*IndexKernel)(const char*, size_t, uint32_t*);
+typedef void (*SpanKernel)(const char*, const char*, const LobsterRowSpan*, size_t,
+                           LobsterMessage*, uint8_t*);
+
+// Runtime CPU dispatch, resolved once per process.  The sse2 and avx2
+// tiers share the SSE2 field decoder: a field is at most 16 bytes.
+struct IndexDispatch {
+    IndexKernel fn;
+    SpanKernel  rows;
+    const char* name;
+};
+
+static IndexDispatch resolve_index_kernel() {
+#ifdef PARSER_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {index_avx2, decode_spans_sse2, "avx2"};
+    if (__builtin_cpu_supports("sse2")) return {index_sse2, decode_spans_sse2, "sse2"};
+#endif
+    return {index_scalar, decode_spans_scalar, "scalar"};
+}
+
+static IndexDispatch& index_dispatch() {
+    static IndexDispatch d = resolve_index_kernel();
+    return d;
+}
+
+const char* parser_simd_level() {
+    return index_dispatch().name;
+}
 
+bool parser_force_simd_level(const std::string& name) {
+    IndexDispatch d{nullptr, nullptr, nullptr};
+    if (name == "scalar") d = {index_scalar, decode_spans_scalar, "scalar"};
+#ifdef PARSER_X86
+    __builtin_cpu_init();
+    if (name == "sse2" && __builtin_cpu_supports("sse2")) d = {index_sse2, decode_spans_sse2, "sse2"};
+    if (name == "avx2" && __builtin_cpu_supports("avx2")) d = {index_avx2, decode_spans_sse2, "avx2"};
+#endif
+    if (!d.fn) return false;
+    index_dispatch() = d;
     return true;
-}
\ No newline at end of file
+}
+
+// ── MMAP row decoding ───────────────────────────────────────
+
+void LobsterParser::index_block() {
+    blk_     = cur_;
+    blk_len_ = std::min(PARSE_BLOCK, (size_t)(end_ - cur_));
+    if (seps_.size() < PARSE_BLOCK) seps_.resize(PARSE_BLOCK);
+    sep_n_   = index_dispatch().fn(blk_, blk_len_, seps_.data());
+    sep_pos_ = 0;
+}
+
+// Line-at-a-time path for rows the index cannot serve: a row longer than
+// PARSE_BLOCK, or the final row with no trailing newline.
+void LobsterParser::parse_line_fallback(LobsterMessage& msg) {
+    const char* line = cur_;
+    const char* nl = (const char*)std::memchr(line, '\n', (size_t)(end_ - line));
+    const char* line_end = nl ? nl : end_;
+    cur_ = nl ? nl + 1 : end_;
+
+    // Parse in place when the row is '\n'-terminated.  Two cases need
+    // a NUL-terminated copy to stay bit-identical with STREAM mode:
+    //   - the final row has no trailing newline (parsing would run off
+    //     the end of the mapping);
+    //   - the row starts with whitespace, which strtod would skip —
+    //     across the '\n' into the next row.
+    if (nl && !std::isspace((unsigned char)*line)) {
+        parse_row(line, msg);
+    } else {
+        scratch_.assign(line, (size_t)(line_end - line));
+        parse_row(scratch_.c_str(), msg);
+    }
+
+    // The index no longer lines up with cur_.
+    blk_ = nullptr;
+    sep_pos_ = sep_n_ = 0;
+}
+
+// Decode rows at cur_ from the separator index, at most cap of them:
+// the spans of every row whose '\n' is inside the indexed block are
+// split off first, then the fields of all of them are decoded in one
+// kernel call.  Returns the count, 0 if the row at cur_ is not complete
+// in the block (nothing consumed).
+size_t LobsterParser::decode_indexed_rows(LobsterMessage* out, size_t cap) {
+    if (sep_pos_ >= sep_n_) return 0;
+    cap = std::min(cap, ROW_BATCH);
+    if (spans_.size() < cap) {
+        spans_.resize(cap);
+        decoded_.resize(cap);
+    }
+
+    size_t n = 0;
+    uint32_t start = (uint32_t)(cur_ - blk_);
+    while (n < cap) {
+        LobsterRowSpan& s = spans_[n];
+        s.start  = start;
+        s.fields = 0;
+        size_t k = sep_pos_;
+        bool found_nl = false;
+        while (k < sep_n_) {
+            uint32_t off = seps_[k++];
+            if (s.fields < 6) s.ends[s.fields++] = off;
+            if (blk_[off] == '\n') { s.nl = off; found_nl = true; break; }
+        }
+        if (!found_nl) break;
+        sep_pos_ = k;
+        start = s.nl + 1;
+        ++n;
+    }
+    if (n == 0) return 0;
+    cur_ = blk_ + start;
+
+    index_dispatch().rows(map_base_, blk_, spans_.data(), n, out, decoded_.data());
+
+    // Short or non-numeric rows: reproduce the STREAM-mode result.  Each
+    // is '\n'-terminated, so only leading whitespace needs a copy.
+    for (size_t i = 0; i < n; ++i) {
+        if (decoded_[i]) continue;
+        const char* row = blk_ + spans_[i].start;
+        if (std::isspace((unsigned char)*row)) {
+            scratch_.assign(row, (size_t)(spans_[i].nl - spans_[i].start));
+            parse_row(scratch_.c_str(), out[i]);
+        } else {
+            parse_row(row, out[i]);
+        }
+    }
+    return n;
+}
+
+size_t LobsterParser::next_batch(LobsterMessage* out, size_t cap) {
+    if (bin_) return bin_->next_batch(out, cap);
+
+    size_t n = 0;
+
+    if (mode_ == ParseMode::STREAM) {
+        while (n < cap && next_message(out[n])) ++n;
+        return n;
+    }
+
+    while (n < cap && cur_ < end_) {
+        const size_t got = decode_indexed_rows(out + n, cap - n);
+        if (got) { n += got; continue; }
+
+        // Row straddles the end of the indexed block: re-index from the
+        // row start.  If the block already starts here the row cannot be
+        // indexed at all, so take the line-at-a-time path.
+        if (blk_ != cur_) { index_block(); continue; }
+        parse_line_fallback(out[n]);
+        ++n;
+    }
+    return n;
+}
+
+uint64_t LobsterParser::tell() {
+    if (bin_) return bin_->tell();
+    if (mode_ == ParseMode::STREAM) {
+        std::streamoff off = file_.tellg();
+        return off < 0 ? 0 : (uint64_t)off;
+    }
+    return (uint64_t)(cur_ - map_base_);
+}
+
+bool LobsterParser::seek(uint64_t pos) {
+    if (bin_) return bin_->seek(pos);
+    if (mode_ == ParseMode::STREAM) {
+        file_.clear();
+        file_.seekg((std::streamoff)pos);
+        return (bool)file_;
+    }
+    if (pos > map_size_) return false;
+    cur_ = map_base_ + pos;
+    blk_ = nullptr;                  // re-index from the new row
+    sep_pos_ = sep_n_ = 0;
+    return true;
+}
+
+bool LobsterParser::next_message(LobsterMessage& msg) {
+    if (bin_ || mode_ == ParseMode::MMAP) {
+        return next_batch(&msg, 1) == 1;
+    }
+
+    std::string line;
+    if (!std::getline(file_, line)) {
+        return false; // EOF
+    }
+    parse_row(line.c_str(), msg);
+    return true;
+}
+
+// ── LobsterDayStream ────────────────────────────────────────
+
+static constexpr size_t STREAM_CHUNK = 1 << 20;
+
+LobsterDayStream::LobsterDayStream(const std::string& path) {
+    if (path == "-") {
+        fd_ = STDIN_FILENO;
+    } else {
+        fd_ = ::open(path.c_str(), O_RDONLY);
+        own_fd_ = fd_ >= 0;
+        if (fd_ < 0) {
+            std::cerr << "Error: Could not open stream " << path << ": "
+                      << std::strerror(errno) << std::endl;
+        }
+    }
+    buf_.resize(2 * STREAM_CHUNK);
+}
+
+LobsterDayStream::~LobsterDayStream() {
+    if (own_fd_) ::close(fd_);
+}
+
+// Append up to STREAM_CHUNK more bytes after tail_, first sliding the
+// unread part to the front.  False at EOF / read error.
+bool LobsterDayStream::fill() {
+    if (eof_) return false;
+    if (head_ > 0) {
+        std::memmove(buf_.data(), buf_.data() + head_, tail_ - head_);
+        tail_ -= head_;
+        head_ = 0;
+    }
+    if (buf_.size() - tail_ < STREAM_CHUNK) buf_.resize(tail_ + STREAM_CHUNK);
+    while (true) {
+        ssize_t r = ::read(fd_, buf_.data() + tail_, STREAM_CHUNK);
+        if (r > 0) { tail_ += (size_t)r; return true; }
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) std::cerr << "Error: stream read failed: " << std::strerror(errno) << std::endl;
+        eof_ = true;
+        return false;
+    }
+}
+
+// Next non-blank line: a parsed row, or the text after a '#'.
+LobsterDayStream::LineKind LobsterDayStream::read_line(LobsterMessage& msg, std::string& header) {
+    while (true) {
+        const char* p = buf_.data() + head_;
+        const char* nl = (const char*)std::memchr(p, '\n', tail_ - head_);
+        if (!nl) {
+            if (fill()) continue;
+            if (head_ == tail_) return LINE_END;
+            // Unterminated final line: terminate it so parse_row stops.
+            if (tail_ == buf_.size()) buf_.resize(tail_ + 1);
+            buf_[tail_++] = '\n';
+            continue;
+        }
+        head_ = (size_t)(nl - buf_.data()) + 1;
+
+        const char* q = p;
+        while (q < nl && std::isspace((unsigned char)*q)) ++q;
+        if (q == nl) continue;                       // blank line
+        if (*q == '#') {
+            const char* e = nl;
+            while (e > q + 1 && std::isspace((unsigned char)e[-1])) --e;
+            ++q;
+            while (q < e && std::isspace((unsigned char)*q)) ++q;
+            header.assign(q, (size_t)(e - q));
+            return LINE_HEADER;
+        }
+
+        // Same decoding as the indexed MMAP path: field ends are the
+        // first six separators of the row.
+        const char* ends[6];
+        int nf = 0;
+        for (const char* s = p; nf < 6; ) {
+            const char* c = (const char*)std::memchr(s, ',', (size_t)(nl - s));
+            ends[nf++] = c ? c : nl;
+            if (!c) break;
+            s = c + 1;
+        }
+        long type, order_id, size, price, direction;
+        if (nf == 6 &&
+            decode_time<ScalarFields>(p, p,           ends[0], msg.time) &&
+            decode_long<ScalarFields>(p, ends[0] + 1, ends[1], type) &&
+            decode_long<ScalarFields>(p, ends[1] + 1, ends[2], order_id) &&
+            decode_long<ScalarFields>(p, ends[2] + 1, ends[3], size) &&
+            decode_long<ScalarFields>(p, ends[3] + 1, ends[4], price) &&
+            decode_long<ScalarFields>(p, ends[4] + 1, ends[5], direction)) {
+            msg.type      = (int)type;
+            msg.order_id  = order_id;
+            msg.size      = (int)size;
+            msg.price     = (int)price;
+            msg.direction = (int)direction;
+        } else {
+            // Leading whitespace would let strtod skip past the '\n'.
+            std::string line(q, (size_t)(nl - q));
+            parse_row(line.c_str(), msg);
+        }
+        return LINE_ROW;
+    }
+}
+
+// Pull date and ticker out of a framing line.  Only its last path
+// component counts, read the way data_processor's extract_date /
+// extract_ticker read a day file name: TICKER_YYYY-MM-DD_..., the
+// date between the first and second '_', the ticker before the first.
+// A bare YYYY-MM-DD is a date with no ticker.
+void LobsterDayStream::set_framing(const std::string& header) {
+    date_.clear();
+    ticker_.clear();
+    auto slash = header.rfind('/');
+    const std::string name = (slash != std::string::npos) ? header.substr(slash + 1) : header;
+    auto is_date = [](const std::string& s) {
+        static const char pat[] = "dddd-dd-dd";
+        if (s.size() != 10) return false;
+        for (size_t k = 0; k < 10; ++k) {
+            char c = s[k];
+            if (pat[k] == 'd' ? !std::isdigit((unsigned char)c) : c != '-') return false;
+        }
+        return true;
+    };
+    if (is_date(name)) {
+        date_ = name;
+        return;
+    }
+    auto first = name.find('_');
+    if (first == std::string::npos || first == 0) return;
+    auto second = name.find('_', first + 1);
+    if (second == std::string::npos) return;
+    std::string date = name.substr(first + 1, second - first - 1);
+    if (!is_date(date)) return;
+    date_ = date;
+    ticker_ = name.substr(0, first);
+}
+
+bool LobsterDayStream::next_day() {
+    if (fd_ < 0) return false;
+
+    // Drain the rest of the current day.
+    LobsterMessage skip;
+    while (in_day_ && !day_done_ && next_batch(&skip, 1) == 1) {}
+
+    in_day_   = false;
+    day_done_ = false;
+    day_rows_ = 0;
+    date_.clear();
+    ticker_.clear();
+
+    bool framed = false;
+    if (have_header_) {
+        set_framing(header_);
+        have_header_ = false;
+        framed = true;
+    }
+    if (!have_row_) {
+        // Look ahead for the day's first row: an unframed day exists only
+        // if it has one, a framed day may be empty.
+        std::string header;
+        switch (read_line(row_, header)) {
+            case LINE_ROW:    have_row_ = true; break;
+            case LINE_HEADER:
+                if (framed) {                // framed day with no rows
+                    header_ = header;
+                    have_header_ = true;
+                    day_done_ = true;
+                    in_day_ = true;
+                    return true;
+                }
+                have_header_ = true;
+                header_ = header;
+                return next_day();
+            case LINE_END:
+                if (!framed) return false;
+                day_done_ = true;            // framed day with no rows at EOF
+                break;
+        }
+    }
+    in_day_ = true;
+    return true;
+}
+
+size_t LobsterDayStream::next_batch(LobsterMessage* out, size_t cap) {
+    size_t n = 0;
+    while (n < cap && !day_done_) {
+        if (have_row_) {
+            have_row_ = false;
+            out[n] = row_;
+        } else {
+            std::string header;
+            LineKind k = read_line(out[n], header);
+            if (k == LINE_END) { day_done_ = true; break; }
+            if (k == LINE_HEADER) {
+                header_ = header;
+                have_header_ = true;
+                day_done_ = true;
+                break;
+            }
+            if (day_rows_ > 0 && out[n].time < last_time_) {
+                // Timestamp reset: out[n] opens the next day.
+                row_ = out[n];
+                have_row_ = true;
+                day_done_ = true;
+                break;
+            }
+        }
+        last_time_ = out[n].time;
+        ++day_rows_;
+        ++n;
+    }
+    return n;
+}
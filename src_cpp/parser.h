@@ -4,15 +4,182 @@
 #include <string>
 #include <vector>
 #include <fstream>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include "types.h"
+#include "lobbin.h"
+
+// ─────────────────────────────────────────────────────────────
+// LobsterParser: reads one *_message_*.csv day file.
+//
+// Two input modes:
+//   MMAP   (default) — the whole file is mapped read-only with a
+//          sequential-access hint and rows are parsed straight out
+//          of the mapping.  No per-line allocation or copy.
+//          Separator positions (',' / '\n') are found a block at a
+//          time with AVX2 or SSE2, picked at runtime from the CPU
+//          (scalar fallback otherwise); see parser_simd_level().
+//          The fields of a run of rows are then decoded together,
+//          each number folded from one 16-byte load with SSE2.
+//   STREAM — legacy std::ifstream + std::getline path, kept so the
+//          two can be A/B compared (-P stream on the command line).
+//
+// Both modes produce bit-identical LobsterMessage values.
+//
+// A path ending in ".lobbin" (see lobbin.h / lobster_pack) is read
+// through LobbinReader instead, whatever the mode; the rows are the
+// same ones the CSV it was packed from would yield.
+// ─────────────────────────────────────────────────────────────
+
+enum class ParseMode { MMAP, STREAM };
+
+// "mmap" / "stream" → *mode.  False, and *mode untouched, for any
+// other name.
+bool parse_mode_from_string(const std::string& name, ParseMode* mode);
+
+// Separator-scan kernel selected for this CPU: "avx2", "sse2" or "scalar".
+const char* parser_simd_level();
+
+// Use the named kernel from now on instead of the CPU's best (make
+// check runs every tier against STREAM mode).  False, and no change,
+// if the name is unknown or this CPU lacks the instructions.  Call it
+// before any parser is reading.
+bool parser_force_simd_level(const std::string& name);
+
+// Field bounds of one CSV row, as offsets into its indexed block: the
+// row start, its first six separators and its '\n' (parser.cpp).
+struct LobsterRowSpan {
+    uint32_t start;
+    uint32_t ends[6];
+    uint32_t nl;
+    uint32_t fields;    // entries of ends[] filled (the '\n' counts)
+};
 
 class LobsterParser {
 public:
-    LobsterParser(std::string filename);
+    LobsterParser(std::string filename, ParseMode mode = ParseMode::MMAP);
     ~LobsterParser();
 
+    LobsterParser(const LobsterParser&) = delete;
+    LobsterParser& operator=(const LobsterParser&) = delete;
+
     bool next_message(LobsterMessage& msg);
+
+    // Parse up to `cap` rows into out[0..n).  Returns n (0 at EOF).
+    size_t next_batch(LobsterMessage* out, size_t cap);
+
+    // True once the file could not be opened or read, or a .lobbin
+    // turned out corrupt or shorter than its header says (reported on
+    // stderr).  Sticky: the rows read, before or after, are not the
+    // whole day.
+    bool failed() const { return failed_ || file_.bad() || (bin_ && !bin_->ok()); }
+
+    // Position of the next unread row: a byte offset into a CSV, a row
+    // number in a .lobbin.  seek() returns there (pos from tell() on the
+    // same file, in any mode); false if pos is out of range.
+    uint64_t tell();
+    bool     seek(uint64_t pos);
+
 private:
+    ParseMode mode_;
+    bool failed_ = false;   // could not open
+
+    // .lobbin input
+    std::unique_ptr<LobbinReader> bin_;
+
+    // STREAM mode
     std::ifstream file_;
+
+    // MMAP mode: [cur_, end_) is the unread part of the mapping
+    const char* map_base_ = nullptr;
+    size_t      map_size_ = 0;
+    const char* cur_ = nullptr;
+    const char* end_ = nullptr;
+    std::string scratch_;   // rare rows that need NUL-termination (see parser.cpp)
+
+    // Separator index over the block starting at blk_: offsets of every
+    // ',' and '\n' in [blk_, blk_ + blk_len_), consumed from sep_pos_.
+    const char*           blk_ = nullptr;
+    size_t                blk_len_ = 0;
+    std::vector<uint32_t> seps_;
+    size_t                sep_pos_ = 0;
+    size_t                sep_n_ = 0;
+
+    // Rows split off the index by one decode_indexed_rows() call.
+    std::vector<LobsterRowSpan> spans_;
+    std::vector<uint8_t> decoded_;   // per span: 1 if the fast decoder took it
+
+    bool open_mmap(const std::string& filename);
+    void index_block();
+    size_t decode_indexed_rows(LobsterMessage* out, size_t cap);
+    void parse_line_fallback(LobsterMessage& msg);
+};
+
+// ─────────────────────────────────────────────────────────────
+// LobsterDayStream: several message day files concatenated on one
+// byte stream — stdin ("-"), a FIFO, or a plain file — e.g.
+//
+//     7z x -so TICKER.7z '*message*' | data_processor - out.csv
+//
+// A new day starts at
+//   - a framing line beginning with '#'.  It names the day by a bare
+//     YYYY-MM-DD, or by a LOBSTER file name, whose ticker is kept too;
+//     directories in front of the name are ignored:
+//         # AAPL_2026-01-01_2026-01-31_10/AAPL_2026-01-02_34200000_57600000_message_10.csv
+//   - otherwise, a timestamp that goes backwards (LOBSTER times are
+//     non-decreasing within a day).  Such a day has no date().
+//
+// Blank lines are skipped.  Rows decode bit-identically to
+// LobsterParser.  An empty day file is only visible when framed.
+// ─────────────────────────────────────────────────────────────
+
+class LobsterDayStream {
+public:
+    explicit LobsterDayStream(const std::string& path);   // "-" = stdin
+    ~LobsterDayStream();
+
+    LobsterDayStream(const LobsterDayStream&) = delete;
+    LobsterDayStream& operator=(const LobsterDayStream&) = delete;
+
+    bool ok() const { return fd_ >= 0; }
+
+    // Move to the next day, skipping whatever is left of the current
+    // one.  False once the stream is exhausted.
+    bool next_day();
+
+    // Framing info of the current day; empty when it had no '#' line.
+    const std::string& date()   const { return date_; }
+    const std::string& ticker() const { return ticker_; }
+
+    // Rows of the current day only; 0 at the end of the day.
+    size_t next_batch(LobsterMessage* out, size_t cap);
+
+private:
+    int  fd_ = -1;
+    bool own_fd_ = false;
+
+    // Read buffer: [head_, tail_) is unread input.
+    std::vector<char> buf_;
+    size_t head_ = 0;
+    size_t tail_ = 0;
+    bool   eof_ = false;
+
+    std::string date_, ticker_;
+    bool   in_day_ = false;
+    bool   day_done_ = true;
+    size_t day_rows_ = 0;
+    double last_time_ = 0.0;
+
+    // Lookahead consumed while finding the end of the previous day.
+    bool           have_row_ = false;
+    LobsterMessage row_{};
+    bool           have_header_ = false;
+    std::string    header_;
+
+    enum LineKind { LINE_ROW, LINE_HEADER, LINE_END };
+    LineKind read_line(LobsterMessage& msg, std::string& header);
+    bool     fill();
+    void     set_framing(const std::string& header);
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,234 @@
+// ─────────────────────────────────────────────────────────────
+// parser_check.cpp  –  MMAP parser vs STREAM parser (make check)
+// ─────────────────────────────────────────────────────────────
+//
+// Every file is read once with -P stream, the reference, then with
+// the mmap parser under each separator kernel this CPU has (scalar,
+// sse2, avx2), both through next_batch() and next_message().  Rows
+// must match bit for bit, row count included.
+//
+// With no arguments the files are generated under a temporary
+// directory: LOBSTER-format days (several PARSE_BLOCKs long), and
+// fuzzed copies with the rows the fast decoders hand back to strtod —
+// leading blanks, exponents, signs, stray characters, short and long
+// rows, CRLF, blank lines, overlong rows, no final newline.  Real
+// message files can be given instead:
+//
+//     parser_check [-n fuzzed_files] [file.csv ...]
+//
+// Exit status 0 if every file matched.
+// ─────────────────────────────────────────────────────────────
+
+#include <iostream>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include "parser.h"
+
+static const char* const KERNELS[] = {"scalar", "sse2", "avx2"};
+
+// Rows are compared field by field; the time by its bits.
+static bool same_row(const LobsterMessage& a, const LobsterMessage& b) {
+    return std::memcmp(&a.time, &b.time, sizeof a.time) == 0 && a.type == b.type &&
+           a.order_id == b.order_id && a.size == b.size && a.price == b.price &&
+           a.direction == b.direction;
+}
+
+// A row parse_row() leaves partly unset keeps these values in both modes.
+static LobsterMessage blank_row() {
+    LobsterMessage m;
+    std::memset(&m, 0, sizeof m);
+    m.time = -1.0;
+    m.type = m.size = m.price = m.direction = -7;
+    m.order_id = -7;
+    return m;
+}
+
+static std::vector<LobsterMessage> read_stream(const std::string& path) {
+    std::vector<LobsterMessage> rows;
+    LobsterParser parser(path, ParseMode::STREAM);
+    LobsterMessage m = blank_row();
+    while (parser.next_message(m)) {
+        rows.push_back(m);
+        m = blank_row();
+    }
+    return rows;
+}
+
+static std::vector<LobsterMessage> read_mmap(const std::string& path, size_t batch) {
+    std::vector<LobsterMessage> rows;
+    LobsterParser parser(path, ParseMode::MMAP);
+    if (batch == 1) {
+        LobsterMessage m = blank_row();
+        while (parser.next_message(m)) {
+            rows.push_back(m);
+            m = blank_row();
+        }
+    } else {
+        std::vector<LobsterMessage> buf(batch, blank_row());
+        size_t n;
+        while ((n = parser.next_batch(buf.data(), buf.size())) > 0) {
+            rows.insert(rows.end(), buf.begin(), buf.begin() + n);
+            std::fill(buf.begin(), buf.end(), blank_row());
+        }
+    }
+    return rows;
+}
+
+// One file under every kernel; false (and a report) on the first mismatch.
+static bool check_file(const std::string& path) {
+    const std::vector<LobsterMessage> want = read_stream(path);
+    bool ok = true;
+    for (const char* kernel : KERNELS) {
+        if (!parser_force_simd_level(kernel)) continue;
+        for (size_t batch : {(size_t)1, (size_t)7, (size_t)4096}) {
+            const std::vector<LobsterMessage> got = read_mmap(path, batch);
+            size_t i = 0;
+            while (i < want.size() && i < got.size() && same_row(want[i], got[i])) ++i;
+            if (i == want.size() && i == got.size()) continue;
+            std::cerr << "MISMATCH " << path << " kernel=" << kernel << " batch=" << batch;
+            if (i < want.size() && i < got.size())
+                std::cerr << " row " << i << ": stream t=" << want[i].time << " id=" << want[i].order_id
+                          << ", mmap t=" << got[i].time << " id=" << got[i].order_id;
+            std::cerr << " (rows " << want.size() << " vs " << got.size() << ")\n";
+            ok = false;
+        }
+    }
+    std::cout << (ok ? "ok   " : "FAIL ") << path << "  rows=" << want.size() << "\n";
+    return ok;
+}
+
+// ── Generated input ─────────────────────────────────────────
+
+// A LOBSTER day: seconds after midnight with 9 decimals, types 1-7,
+// prices in $×10000.
+static std::string lobster_row(std::mt19937_64& rng, double& t, long& id) {
+    t += std::uniform_real_distribution<double>(0.0, 0.05)(rng);
+    const int type = 1 + (int)(rng() % 7);
+    if (type == 1) ++id;
+    char row[128];
+    std::snprintf(row, sizeof row, "%.9f,%d,%ld,%d,%d,%d\n", t, type, id - (long)(rng() % 50),
+                  1 + (int)(rng() % 900), 1480000 + (int)(rng() % 20000), (rng() & 1) ? 1 : -1);
+    return row;
+}
+
+static std::string lobster_day(std::mt19937_64& rng, size_t rows) {
+    std::string s;
+    double t = 34200.0;
+    long id = 10000000;
+    for (size_t i = 0; i < rows; ++i) s += lobster_row(rng, t, id);
+    return s;
+}
+
+// A row as it might come out of a damaged or hand-edited file.
+static std::string odd_row(std::mt19937_64& rng, std::string row) {
+    const size_t at = rng() % (row.size() - 1);
+    const std::string rest = row.substr(row.find(','));
+    switch (rng() % 19) {
+    case 0:  return " " + row;                                          // leading blank
+    case 1:  return "\t" + row;
+    case 2:  return "3.42e4" + rest;                                     // exponent
+    case 3:  return "+" + row;                                          // sign
+    case 4:  return row.substr(0, at) + "x" + row.substr(at);           // stray character
+    case 5:  return row.substr(0, row.find(',', row.find(',') + 1)) + "\n";   // short row
+    case 6:  return row.substr(0, row.size() - 1) + ",9\n";            // extra field
+    case 7:  return row.substr(0, row.size() - 1) + "\r\n";            // CRLF
+    case 8:  return "\n" + row;                                         // blank line
+    case 9:  return "0000" + row;                                       // leading zeros
+    case 10: return "34200.12345678901234567890" + rest;                 // > 19 digits
+    case 11: return row.substr(0, at) + ",," + row.substr(at);          // empty field
+    case 12: return std::string(40000, ' ') + row;                      // longer than a block
+    case 13: return "34200." + rest;                                     // '.' last, first, twice
+    case 14: return ".5" + rest;
+    case 15: return "34200.1.5" + rest;
+    case 16: return "1234567890.12345" + rest;                           // 16 bytes, 15 digits
+    case 17: return row.substr(0, row.find(',')) +                       // 16-18 digit integers
+                    (rng() & 1 ? ",1,1234567890123456,-123456789012345,9,1\n"
+                               : ",1,123456789012345678,12345678901234567,9,1\n");
+    default: return row.substr(0, row.find(',')) + ",1,-5,10,-2147483648,1\n";
+    }
+}
+
+static std::string fuzzed_day(std::mt19937_64& rng, size_t rows) {
+    std::string s;
+    double t = 34200.0;
+    long id = 10000000;
+    for (size_t i = 0; i < rows; ++i) {
+        std::string row = lobster_row(rng, t, id);
+        s += (rng() % 20 == 0) ? odd_row(rng, row) : row;
+    }
+    if (rng() & 1) s.pop_back();   // no final newline
+    return s;
+}
+
+static bool write_file(const std::string& path, const std::string& bytes) {
+    std::ofstream f(path, std::ios::binary);
+    f.write(bytes.data(), (std::streamsize)bytes.size());
+    return (bool)f;
+}
+
+int main(int argc, char* argv[]) {
+    int fuzzed = 20;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string a = argv[i];
+        if (a == "-n" && i + 1 < argc) fuzzed = std::atoi(argv[++i]);
+        else files.push_back(a);
+    }
+
+    std::string dir;
+    if (files.empty()) {
+        char tmpl[] = "/tmp/parser_check.XXXXXX";
+        if (!mkdtemp(tmpl)) {
+            std::cerr << "Error: cannot create a temporary directory\n";
+            return 1;
+        }
+        dir = tmpl;
+        std::mt19937_64 rng(20260102);
+        const std::vector<std::pair<std::string, std::string>> made = {
+            {"TEST_2026-01-02_34200000_57600000_message_10.csv", lobster_day(rng, 60000)},
+            {"TEST_2026-01-05_34200000_57600000_message_10.csv", lobster_day(rng, 1)},
+            {"empty_message_10.csv", ""},
+        };
+        for (const auto& [name, bytes] : made) {
+            files.push_back(dir + "/" + name);
+            if (!write_file(files.back(), bytes)) {
+                std::cerr << "Error: cannot write " << files.back() << "\n";
+                return 1;
+            }
+        }
+        for (int k = 0; k < fuzzed; ++k) {
+            files.push_back(dir + "/fuzz_" + std::to_string(k) + "_message_10.csv");
+            if (!write_file(files.back(), fuzzed_day(rng, 3000 + 2000 * (size_t)k))) {
+                std::cerr << "Error: cannot write " << files.back() << "\n";
+                return 1;
+            }
+        }
+    }
+
+    std::cout << "kernels:";
+    for (const char* kernel : KERNELS) {
+        if (parser_force_simd_level(kernel)) std::cout << " " << kernel;
+    }
+    std::cout << "\n";
+
+    size_t failed = 0;
+    for (const std::string& f : files) failed += !check_file(f);
+
+    if (!dir.empty()) {
+        for (const std::string& f : files) std::remove(f.c_str());
+        rmdir(dir.c_str());
+    }
+    if (failed) {
+        std::cerr << failed << " of " << files.size() << " files differ\n";
+        return 1;
+    }
+    std::cout << "all " << files.size() << " files match\n";
+    return 0;
+}
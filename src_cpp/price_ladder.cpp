@@ -0,0 +1,220 @@
+// Tick-indexed price ladder (layout described in price_ladder.h)
+#include "price_ladder.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+FlatLadder::FlatLadder(bool bid_side) : bid_(bid_side), vol_(LADDER_WIDTH, 0) {
+    std::memset(bits_, 0, sizeof(bits_));
+}
+
+void FlatLadder::clear() {
+    std::fill(vol_.begin(), vol_.end(), 0);
+    std::memset(bits_, 0, sizeof(bits_));
+    summary_ = 0;
+    best_ = -1;
+    anchored_ = false;
+    far_.clear();
+}
+
+// ── Bitmap ──────────────────────────────────────────────────
+
+void FlatLadder::set_bit(int s) {
+    bits_[s >> 6] |= 1ULL << (s & 63);
+    summary_      |= 1ULL << (s >> 6);
+}
+
+void FlatLadder::clear_bit(int s) {
+    bits_[s >> 6] &= ~(1ULL << (s & 63));
+    if (!bits_[s >> 6]) summary_ &= ~(1ULL << (s >> 6));
+}
+
+int FlatLadder::next_below(int s) const {
+    if (s < 0) return -1;
+    int w = s >> 6, b = s & 63;
+    uint64_t m = bits_[w] & (b == 63 ? ~0ULL : (1ULL << (b + 1)) - 1);
+    if (m) return (w << 6) + 63 - __builtin_clzll(m);
+    uint64_t sm = summary_ & ((1ULL << w) - 1);
+    if (!sm) return -1;
+    w = 63 - __builtin_clzll(sm);
+    return (w << 6) + 63 - __builtin_clzll(bits_[w]);
+}
+
+int FlatLadder::next_above(int s) const {
+    if (s >= LADDER_WIDTH) return -1;
+    int w = s >> 6, b = s & 63;
+    uint64_t m = bits_[w] & (~0ULL << b);
+    if (m) return (w << 6) + __builtin_ctzll(m);
+    uint64_t sm = (w == WORDS - 1) ? 0 : summary_ & (~0ULL << (w + 1));
+    if (!sm) return -1;
+    w = __builtin_ctzll(sm);
+    return (w << 6) + __builtin_ctzll(bits_[w]);
+}
+
+// ── Window placement ────────────────────────────────────────
+
+// Worth re-centring for an on-tick price outside the window?  Yes if
+// the side is empty, the price would be the new best, or it is within
+// a quarter window of the current best.
+bool FlatLadder::near_touch(int price) const {
+    if (empty()) return true;
+    long long best = best_price();
+    if (bid_ ? price > best : price < best) return true;
+    long long dist = bid_ ? best - price : price - best;
+    return dist < (long long)(LADDER_WIDTH / 4) * LADDER_TICK;
+}
+
+void FlatLadder::recenter(int price) {
+    std::vector<std::pair<int, int>> moved;
+    for (int s = next_above(0); s >= 0; s = next_above(s + 1)) {
+        moved.emplace_back(price_of(s), vol_[s]);
+        vol_[s] = 0;
+    }
+    std::memset(bits_, 0, sizeof(bits_));
+    summary_ = 0;
+
+    anchor_ = price - (LADDER_WIDTH / 2) * LADDER_TICK;
+    anchored_ = true;
+
+    for (const auto& lv : moved) {
+        int s = slot_of(lv.first);
+        if (s < 0) { far_[lv.first] = lv.second; continue; }
+        vol_[s] = lv.second;
+        set_bit(s);
+    }
+    // Outliers that now fall inside the window move into the array.
+    auto it  = far_.lower_bound(anchor_);
+    long long hi = (long long)anchor_ + (long long)LADDER_WIDTH * LADDER_TICK;
+    while (it != far_.end() && it->first < hi) {
+        int s = slot_of(it->first);
+        if (s < 0) { ++it; continue; }         // off-tick: stays in far_
+        vol_[s] = it->second;
+        set_bit(s);
+        it = far_.erase(it);
+    }
+    best_ = bid_ ? next_below(LADDER_WIDTH - 1) : next_above(0);
+}
+
+// ── Updates ─────────────────────────────────────────────────
+
+int FlatLadder::add(int price, int size) {
+    int s = slot_of(price);
+    if (s < 0 && price % LADDER_TICK == 0 && near_touch(price)) {
+        recenter(price);
+        s = slot_of(price);
+    }
+    if (s < 0) {
+        int& lv = far_[price];
+        int old = lv;
+        lv += size;
+        return old;
+    }
+
+    int old = vol_[s];
+    if (old == 0) set_bit(s);
+    vol_[s] += size;
+    if (best_ < 0 || (bid_ ? s > best_ : s < best_)) best_ = s;
+    return old;
+}
+
+int FlatLadder::reduce(int price, int size_delta) {
+    int s = slot_of(price);
+    if (s < 0) {
+        auto pl = far_.find(price);
+        if (pl == far_.end()) return 0;
+        int old = pl->second;
+        pl->second -= size_delta;
+        if (pl->second <= 0) far_.erase(pl);
+        return old;
+    }
+    int old = vol_[s];
+    if (old == 0) return 0;                    // no such level
+    vol_[s] -= size_delta;
+    if (vol_[s] <= 0) {
+        vol_[s] = 0;
+        clear_bit(s);
+        if (s == best_) best_ = worse(s);
+    }
+    return old;
+}
+
+// ── Queries ─────────────────────────────────────────────────
+
+int FlatLadder::best_price() const {
+    int px = 0;
+    if (best_ >= 0) px = price_of(best_);
+    if (!far_.empty()) {
+        int fp = bid_ ? far_.rbegin()->first : far_.begin()->first;
+        if (best_ < 0 || (bid_ ? fp > px : fp < px)) px = fp;
+    }
+    return px;
+}
+
+int FlatLadder::best_volume() const {
+    if (far_.empty()) return best_ >= 0 ? vol_[best_] : 0;
+    const auto& fl = bid_ ? *far_.rbegin() : *far_.begin();
+    if (best_ < 0) return fl.second;
+    int px = price_of(best_);
+    return (bid_ ? fl.first > px : fl.first < px) ? fl.second : vol_[best_];
+}
+
+int FlatLadder::next_worse(int price, int& vol) const {
+    // Array candidate: nearest occupied slot on the worse side of price.
+    int s = -1;
+    long long off = (long long)price - anchor_;
+    if (anchored_) {
+        if (bid_) {
+            if (off > 0) s = next_below((int)std::min<long long>(LADDER_WIDTH - 1, (off - 1) / LADDER_TICK));
+        } else {
+            s = next_above(off < 0 ? 0 : (int)std::min<long long>(LADDER_WIDTH, off / LADDER_TICK + 1));
+        }
+    }
+    // Outlier candidate.
+    const std::pair<const int, int>* fl = nullptr;
+    if (bid_) {
+        auto it = far_.lower_bound(price);
+        if (it != far_.begin()) fl = &*std::prev(it);
+    } else {
+        auto it = far_.upper_bound(price);
+        if (it != far_.end()) fl = &*it;
+    }
+    if (s >= 0 && (!fl || (bid_ ? price_of(s) > fl->first : price_of(s) < fl->first))) {
+        vol = vol_[s];
+        return price_of(s);
+    }
+    if (fl) { vol = fl->second; return fl->first; }
+    vol = 0;
+    return 0;
+}
+
+// Walk array and outliers together, best level first.
+int FlatLadder::depth(int levels) const {
+    int total = 0, count = 0;
+    int s = best_;
+    if (bid_) {
+        auto it = far_.rbegin();
+        while (s >= 0 || it != far_.rend()) {
+            if (s >= 0 && (it == far_.rend() || price_of(s) > it->first)) {
+                total += vol_[s];
+                s = next_below(s - 1);
+            } else {
+                total += it->second;
+                ++it;
+            }
+            if (levels > 0 && ++count >= levels) break;
+        }
+    } else {
+        auto it = far_.begin();
+        while (s >= 0 || it != far_.end()) {
+            if (s >= 0 && (it == far_.end() || price_of(s) < it->first)) {
+                total += vol_[s];
+                s = next_above(s + 1);
+            } else {
+                total += it->second;
+                ++it;
+            }
+            if (levels > 0 && ++count >= levels) break;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,94 @@
+#ifndef PRICE_LADDER_H
+#define PRICE_LADDER_H
+
+#include <map>
+#include <vector>
+#include <cstdint>
+
+// ─────────────────────────────────────────────────────────────
+// FlatLadder: one side of the book as a tick-indexed array
+// ─────────────────────────────────────────────────────────────
+//
+// Resting size per price level, for the bid or the ask side.
+// Levels near the touch live in a flat array of LADDER_WIDTH slots,
+// one per tick (LADDER_TICK price units = $0.01), starting at a
+// movable anchor price:
+//
+//     slot i  ↔  price = anchor_ + i * LADDER_TICK
+//
+// A two-level occupancy bitmap (64 words + one summary word) finds
+// the next non-empty slot from any position with one ctz/clz per
+// level, so losing the best level never scans.  The best slot is
+// cached.
+//
+// Prices outside the window, or not on a whole tick (sub-penny
+// quotes), go to a std::map — the same structure OrderBook used
+// before, so the fallback is never slower than the old book.  Each
+// price lives in exactly one of the two places.  When the touch
+// drifts to within a quarter window of the edge (or the side was
+// empty), the window is re-centred on it and levels migrate
+// between array and map.
+//
+// Level semantics match std::map<int,int> exactly: a level exists
+// while its size is > 0; reducing a missing level is a no-op.
+// ─────────────────────────────────────────────────────────────
+
+constexpr int LADDER_TICK  = 100;    // LOBSTER price units per $0.01
+constexpr int LADDER_WIDTH = 4096;   // slots; 64 bitmap words
+
+class FlatLadder {
+public:
+    // bid_side: best = highest price; otherwise best = lowest price.
+    explicit FlatLadder(bool bid_side);
+
+    // Both return the level's size before the change (0 = no level;
+    // reduce is then a no-op).  add needs size > 0.
+    int  add(int price, int size);
+    int  reduce(int price, int size_delta);    // level removed at <= 0
+    void clear();
+
+    bool empty() const { return best_ < 0 && far_.empty(); }
+
+    // Best price / size at it; 0 when the side is empty.
+    int best_price() const;
+    int best_volume() const;
+
+    // Total size over the best `levels` levels (0 = whole side).
+    int depth(int levels) const;
+
+    // Best level strictly worse than `price`: its price, size in `vol`.
+    // 0 if there is none.
+    int next_worse(int price, int& vol) const;
+
+private:
+    static constexpr int WORDS = LADDER_WIDTH / 64;
+
+    bool bid_;
+    int  anchor_ = 0;                  // price of slot 0
+    bool anchored_ = false;
+    int  best_ = -1;                   // best occupied slot, -1 if none
+    std::vector<int> vol_;             // LADDER_WIDTH slots
+    uint64_t bits_[WORDS];             // slot occupancy
+    uint64_t summary_ = 0;             // bit w set ⇔ bits_[w] != 0
+    std::map<int, int> far_;           // outliers: off-window / off-tick
+
+    // Slot for `price`, or -1 if it belongs in far_.
+    int slot_of(int price) const {
+        long long off = (long long)price - anchor_;
+        if (!anchored_ || off < 0 || off % LADDER_TICK != 0) return -1;
+        off /= LADDER_TICK;
+        return off < LADDER_WIDTH ? (int)off : -1;
+    }
+    int price_of(int slot) const { return anchor_ + slot * LADDER_TICK; }
+
+    void set_bit(int s);
+    void clear_bit(int s);
+    int  next_below(int s) const;      // highest occupied slot <= s, -1 if none
+    int  next_above(int s) const;      // lowest  occupied slot >= s, -1 if none
+    int  worse(int s) const { return bid_ ? next_below(s - 1) : next_above(s + 1); }
+
+    bool near_touch(int price) const;
+    void recenter(int price);
+};
+
+#endif
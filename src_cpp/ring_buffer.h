@@ -0,0 +1,62 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <vector>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// RingBuffer: growable FIFO over one power-of-two array
+// ─────────────────────────────────────────────────────────────
+//
+// The rolling-feature windows push at the back and prune at the
+// front all day.  A std::deque allocates and frees a block every few
+// hundred elements doing that; a RingBuffer only allocates when it
+// outgrows its array (doubling), and clear() keeps the array, so a
+// buffer reused from day to day stops allocating once it has held
+// its longest window.  Elements are indexed oldest first.
+// ─────────────────────────────────────────────────────────────
+
+template <class T>
+class RingBuffer {
+public:
+    bool   empty() const { return size_ == 0; }
+    size_t size()  const { return size_; }
+
+    // Drop every element; capacity is kept.
+    void clear() { head_ = 0; size_ = 0; }
+
+    void push_back(const T& v) {
+        if (size_ == buf_.size()) grow();
+        buf_[(head_ + size_) & mask_] = v;
+        ++size_;
+    }
+
+    void pop_front() {
+        head_ = (head_ + 1) & mask_;
+        --size_;
+    }
+
+    T&       front()       { return buf_[head_]; }
+    const T& front() const { return buf_[head_]; }
+    T&       back()        { return buf_[(head_ + size_ - 1) & mask_]; }
+    const T& back()  const { return buf_[(head_ + size_ - 1) & mask_]; }
+
+    T&       operator[](size_t k)       { return buf_[(head_ + k) & mask_]; }
+    const T& operator[](size_t k) const { return buf_[(head_ + k) & mask_]; }
+
+private:
+    std::vector<T> buf_;
+    size_t mask_ = 0;
+    size_t head_ = 0;
+    size_t size_ = 0;
+
+    void grow() {
+        std::vector<T> next(buf_.empty() ? 64 : buf_.size() * 2);
+        for (size_t k = 0; k < size_; ++k) next[k] = (*this)[k];
+        buf_.swap(next);
+        mask_ = buf_.size() - 1;
+        head_ = 0;
+    }
+};
+
+#endif
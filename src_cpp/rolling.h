@@ -0,0 +1,419 @@
+#ifndef ROLLING_H
+#define ROLLING_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstddef>
+#include <cstdlib>
+#include "ring_buffer.h"
+
+// ─────────────────────────────────────────────────────────────
+// Windowed aggregators over a time-ordered stream
+// ─────────────────────────────────────────────────────────────
+//
+// The rolling MarketState features look back from a burst's start
+// over several trailing windows of one stream (mid changes, trades).
+// Both classes here take points with non-decreasing times and answer
+// queries whose `now` does not decrease either — burst starts within
+// a day — so each window keeps a cursor that only moves forward:
+//
+//   WindowSums<Acc>  Acc totals of the points with time >= now − W.
+//                    Every point stores the running total before it,
+//                    so push() is O(1) whatever the number of windows
+//                    and a window's sum is one subtraction.
+//   LaggedValues     the value last pushed at or before now − lag.
+//
+// A query is O(1) amortized per window.  Points no window can reach
+// again are dropped at query time; as with the ring buffers these
+// replace, nothing is dropped on push, since a burst still in
+// progress may start a query further back than the newest row.  A
+// stream queried only at its newest row can expire() as it goes.
+// Windows and lags are a short list fixed per day; adding one costs
+// a cursor, not work per row.
+//
+// A -G detector bank closes its configurations' bursts out of start
+// order, so its queries step back and forth.  hold(t) promises that
+// no later query has now < t; points such a query can reach are then
+// kept, and a cursor moves back to them.
+//
+// Acc needs a value-initialised zero, `+` and `-`.
+// ─────────────────────────────────────────────────────────────
+
+template <class Acc>
+class WindowSums {
+public:
+    explicit WindowSums(std::vector<double> windows = {}) { set_windows(std::move(windows)); }
+
+    // Replace the window list (seconds); also clears.
+    void set_windows(std::vector<double> windows) {
+        windows_ = std::move(windows);
+        longest_ = windows_.empty() ? 0.0 : *std::max_element(windows_.begin(), windows_.end());
+        clear();
+    }
+
+    size_t windows() const { return windows_.size(); }
+
+    // Drop every point; capacity is kept.
+    void clear() {
+        points_.clear();
+        base_  = 0;
+        total_ = Acc{};
+        hold_  = std::numeric_limits<double>::infinity();
+        first_.assign(windows_.size(), 0);
+    }
+
+    void push(double time, const Acc& v) {
+        points_.push_back({time, total_});
+        total_ = total_ + v;
+    }
+
+    // Total of the points with time >= now − window w (later points
+    // included).
+    Acc sum(size_t w, double now) {
+        advance(w, now);
+        const size_t f = first_[w];
+        const Acc s = (f < base_ + points_.size()) ? total_ - points_[f - base_].before : Acc{};
+        evict();
+        return s;
+    }
+
+    // Move every window up to `now` without asking for its sum, for a
+    // stream whose queries are never for an earlier time than its
+    // newest point: drops what none of them can reach any more.
+    void expire(double now) {
+        for (size_t w = 0; w < windows_.size(); ++w) advance(w, now);
+        evict();
+    }
+
+    // Queries from here on have now >= floor (see above).
+    void hold(double floor) { hold_ = floor; }
+
+private:
+    struct Point {
+        double time;
+        Acc    before;   // total of the points pushed before this one
+    };
+    RingBuffer<Point>   points_;
+    size_t              base_ = 0;    // stream index of points_[0]
+    Acc                 total_{};
+    std::vector<double> windows_;
+    std::vector<size_t> first_;       // per window: stream index of its oldest point
+    double              longest_ = 0.0;
+    double              hold_ = std::numeric_limits<double>::infinity();
+
+    void advance(size_t w, double now) {
+        const double cutoff = now - windows_[w];
+        const size_t end = base_ + points_.size();
+        size_t& f = first_[w];
+        while (f > base_ && points_[f - 1 - base_].time >= cutoff) --f;
+        while (f < end && points_[f - base_].time < cutoff) ++f;
+    }
+
+    void evict() {
+        if (first_.empty()) return;
+        const size_t keep = *std::min_element(first_.begin(), first_.end());
+        while (base_ < keep && points_.front().time < hold_ - longest_) {
+            points_.pop_front();
+            ++base_;
+        }
+    }
+};
+
+class LaggedValues {
+public:
+    explicit LaggedValues(std::vector<double> lags = {}) { set_lags(std::move(lags)); }
+
+    // Replace the lag list (seconds); also clears.
+    void set_lags(std::vector<double> lags) {
+        lags_ = std::move(lags);
+        longest_ = lags_.empty() ? 0.0 : *std::max_element(lags_.begin(), lags_.end());
+        clear();
+    }
+
+    size_t lags() const { return lags_.size(); }
+
+    // Drop every point; capacity is kept.
+    void clear() {
+        points_.clear();
+        base_ = 0;
+        hold_ = std::numeric_limits<double>::infinity();
+        seen_.assign(lags_.size(), 0);
+    }
+
+    bool   empty() const { return points_.empty(); }
+    double back()  const { return points_.back().value; }   // last value pushed
+
+    void push(double time, double value) { points_.push_back({time, value}); }
+
+    // Value last pushed at or before now − lag l, else `none`.
+    double at(size_t l, double now, double none) {
+        const double target = now - lags_[l];
+        const size_t end = base_ + points_.size();
+        size_t& n = seen_[l];
+        while (n > base_ && points_[n - 1 - base_].time > target) --n;
+        while (n < end && points_[n - base_].time <= target) ++n;
+        const double v = (n > base_) ? points_[n - 1 - base_].value : none;
+        evict();
+        return v;
+    }
+
+    // Queries from here on have now >= floor (see above).
+    void hold(double floor) { hold_ = floor; }
+
+private:
+    struct Point {
+        double time;
+        double value;
+    };
+    RingBuffer<Point>   points_;
+    size_t              base_ = 0;    // stream index of points_[0]
+    std::vector<double> lags_;
+    std::vector<size_t> seen_;        // per lag: points at or before its last target
+    double              longest_ = 0.0;
+    double              hold_ = std::numeric_limits<double>::infinity();
+
+    // Keep each lag's current answer and everything after it, and
+    // always the newest point (back()); under hold(), also the answer
+    // for the held floor.
+    void evict() {
+        if (points_.empty()) return;
+        size_t keep = base_ + points_.size() - 1;
+        for (size_t n : seen_) keep = std::min(keep, n > 0 ? n - 1 : 0);
+        while (base_ < keep && points_[1].time <= hold_ - longest_) {
+            points_.pop_front();
+            ++base_;
+        }
+    }
+};
+
+// ─────────────────────────────────────────────────────────────
+// Rolling MarketState features (both drivers)
+// ─────────────────────────────────────────────────────────────
+//
+// Realised volatility of mid returns per volatility window, momentum
+// against the mid in force one lag back, and trade count / volume over
+// the trade window.  The mid stream is the RTH mids on change; a
+// return belongs to a window while the mid it starts from does, and
+// the momentum reference is the mid in force at now − lag, however
+// long ago it was set.
+// ─────────────────────────────────────────────────────────────
+
+constexpr int MAX_FEATURE_WINDOWS = 8;   // per list; MarketState holds this many
+
+inline double longest(const std::vector<double>& windows) {
+    return windows.empty() ? 0.0 : *std::max_element(windows.begin(), windows.end());
+}
+
+struct FeatureWindows {
+    std::vector<double> volatility = {60.0};
+    std::vector<double> momentum   = {5.0, 30.0, 60.0};
+    double              trades     = 300.0;   // TradeCount5m / TradeVolume5m
+    std::vector<double> cancels    = {0.050};   // pre-burst cancel windows (-w)
+
+    // Longest look-back of any feature.
+    double lookback() const {
+        return std::max({trades, longest(volatility), longest(momentum), longest(cancels)});
+    }
+};
+
+// "5,30,60" → seconds; empty if malformed, non-positive or longer
+// than MAX_FEATURE_WINDOWS.
+inline std::vector<double> parse_window_list(const std::string& text) {
+    std::vector<double> out;
+    const char* p = text.c_str();
+    while (*p) {
+        char* end = nullptr;
+        const double v = std::strtod(p, &end);
+        if (end == p || !(v > 0.0) || (*end != ',' && *end != '\0')) return {};
+        out.push_back(v);
+        p = (*end == ',') ? end + 1 : end;
+    }
+    if ((int)out.size() > MAX_FEATURE_WINDOWS) return {};
+    return out;
+}
+
+// 60 → "60", 2.5 → "2.5"
+inline std::string format_secs(double secs) {
+    std::string s = std::to_string(secs);
+    s.erase(s.find_last_not_of('0') + 1);
+    if (s.back() == '.') s.pop_back();
+    return s;
+}
+
+// Column suffix: 60 → "60s", 2.5 → "2.5s", 0.05 → "50ms".
+inline std::string window_label(double secs) {
+    return (secs < 1.0) ? format_secs(secs * 1000.0) + "ms" : format_secs(secs) + "s";
+}
+
+// "5,30,60" again, for the Settings line.
+inline std::string join_windows(const std::vector<double>& list) {
+    std::string s;
+    for (double w : list) s += (s.empty() ? "" : ",") + format_secs(w);
+    return s;
+}
+
+// Squared mid returns and their count.
+struct ReturnSq {
+    double sum_sq = 0.0;
+    long   n      = 0;
+    ReturnSq operator+(const ReturnSq& o) const { return {sum_sq + o.sum_sq, n + o.n}; }
+    ReturnSq operator-(const ReturnSq& o) const { return {sum_sq - o.sum_sq, n - o.n}; }
+};
+
+// Trades and shares traded.
+struct TradeTotals {
+    long long count  = 0;
+    long long volume = 0;
+    TradeTotals operator+(const TradeTotals& o) const { return {count + o.count, volume + o.volume}; }
+    TradeTotals operator-(const TradeTotals& o) const { return {count - o.count, volume - o.volume}; }
+};
+
+class RollingFeatures {
+public:
+    // Set the windows; also clears.
+    void configure(const FeatureWindows& w) {
+        returns_.set_windows(w.volatility);
+        mids_.set_lags(w.momentum);
+        trades_.set_windows({w.trades});
+    }
+
+    // Start a new day; windows and capacity are kept.
+    void clear() {
+        returns_.clear();
+        mids_.clear();
+        trades_.clear();
+    }
+
+    // An RTH row's mid (> 0); recorded when it changes.
+    void on_mid(double time, double mid) {
+        if (!mids_.empty()) {
+            if (mids_.back() == mid) return;
+            const double ret = (mid - mid_) / mid_;
+            returns_.push(mid_time_, {ret * ret, 1});
+        }
+        mids_.push(time, mid);
+        mid_      = mid;
+        mid_time_ = time;
+    }
+
+    void on_trade(double time, int size) { trades_.push(time, {1, size}); }
+
+    // Queries from here on have now >= floor (a -G bank's earliest
+    // open burst start).
+    void hold(double floor) {
+        returns_.hold(floor);
+        mids_.hold(floor);
+        trades_.hold(floor);
+    }
+
+    double volatility(size_t w, double now) {
+        const ReturnSq r = returns_.sum(w, now);
+        return (r.n > 0) ? std::sqrt(r.sum_sq / r.n) : 0.0;
+    }
+
+    // (mid − mid at now − lag l) / mid at now − lag l; 0 without either.
+    double momentum(size_t l, double now, double mid) {
+        const double ref = mids_.at(l, now, 0.0);
+        if (ref == 0.0 || mid == 0.0) return 0.0;
+        return (mid - ref) / ref;
+    }
+
+    // Trades and shares traded in the trade window.
+    std::pair<int, int> trades(double now) {
+        const TradeTotals t = trades_.sum(0, now);
+        return {(int)t.count, (int)t.volume};
+    }
+
+private:
+    WindowSums<ReturnSq>    returns_;   // stamped with the time of the mid they start from
+    LaggedValues            mids_;
+    WindowSums<TradeTotals> trades_;
+    double mid_      = 0.0;            // last mid recorded, and when
+    double mid_time_ = 0.0;
+};
+
+// ─────────────────────────────────────────────────────────────
+// Pre-burst cancel depletion (both drivers)
+// ─────────────────────────────────────────────────────────────
+//
+// Cancels and deletions (LOBSTER types 2/3) by side, over each -w
+// window before a burst's first event.  Asked for only when a burst
+// starts, always at the newest row's time, so the windows are moved
+// up as the stream grows and never hold more than about twice the
+// longest window of cancels.  Both sides are kept; which one the
+// burst trades against is known only when it closes.
+// ─────────────────────────────────────────────────────────────
+
+struct CancelTotals {
+    long long bid_count  = 0;
+    long long ask_count  = 0;
+    long long bid_volume = 0;
+    long long ask_volume = 0;
+    CancelTotals operator+(const CancelTotals& o) const {
+        return {bid_count + o.bid_count, ask_count + o.ask_count,
+                bid_volume + o.bid_volume, ask_volume + o.ask_volume};
+    }
+    CancelTotals operator-(const CancelTotals& o) const {
+        return {bid_count - o.bid_count, ask_count - o.ask_count,
+                bid_volume - o.bid_volume, ask_volume - o.ask_volume};
+    }
+};
+
+class CancelWindows {
+public:
+    // Set the windows; also clears.
+    void configure(const std::vector<double>& windows) {
+        sums_.set_windows(windows);
+        longest_ = longest(windows);
+        trim_at_ = 0.0;
+    }
+
+    // Start a new day; windows and capacity are kept.
+    void clear() {
+        sums_.clear();
+        trim_at_ = 0.0;
+    }
+
+    size_t windows() const { return sums_.windows(); }
+
+    // direction: LOBSTER side of the cancelled order (−1 = ask).
+    void on_cancel(double time, int direction, int size) {
+        if (direction == -1) sums_.push(time, {0, 1, 0, size});
+        else                 sums_.push(time, {1, 0, size, 0});
+        if (time >= trim_at_) {
+            sums_.expire(time);
+            trim_at_ = time + longest_;
+        }
+    }
+
+    // Cancels in [now − window w, now]; now is the newest row's time.
+    CancelTotals at(size_t w, double now) { return sums_.sum(w, now); }
+
+private:
+    WindowSums<CancelTotals> sums_;
+    double longest_ = 0.0;
+    double trim_at_ = 0.0;
+};
+
+// Share of a window's cancels on its busier side.
+inline double busier_side_rate(const CancelTotals& c) {
+    const long long total = c.bid_count + c.ask_count;
+    return total ? (double)std::max(c.bid_count, c.ask_count) / (double)total : 0.0;
+}
+
+// Share of a window's cancels on the side a burst of `direction`
+// trades into — asks for a buy burst, bids for a sell burst — or on
+// the busier side for a mixed one.
+inline double opposing_side_rate(const CancelTotals& c, int direction) {
+    const long long total = c.bid_count + c.ask_count;
+    if (!total) return 0.0;
+    if (direction == 1)  return (double)c.ask_count / (double)total;
+    if (direction == -1) return (double)c.bid_count / (double)total;
+    return busier_side_rate(c);
+}
+
+#endif
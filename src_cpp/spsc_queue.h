@@ -0,0 +1,136 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// SpscQueue: bounded lock-free single-producer / single-consumer ring
+// ─────────────────────────────────────────────────────────────
+//
+// One thread pushes, one thread pops; no locks, no allocation after
+// construction.  The producer owns tail_, the consumer head_, each on
+// its own cache line, and each side keeps a private copy of the other
+// side's index so it only reads the shared one when the ring looks
+// full (producer) or empty (consumer).
+//
+// push() / pop() wait by yielding.  Each wait is counted once in
+// stats() — full_waits on the producer side (the consumer is the
+// slower stage), empty_waits on the consumer side (the producer is) —
+// along with the depth each push found, so a pipeline can show which
+// of its stages is the bottleneck.  Read stats() once both sides have
+// finished.
+// ─────────────────────────────────────────────────────────────
+
+struct QueueStats {
+    size_t pushes      = 0;
+    size_t depth_sum   = 0;    // items already queued, summed over pushes
+    size_t max_depth   = 0;
+    size_t full_waits  = 0;    // pushes that found the ring full
+    size_t empty_waits = 0;    // pops that found it empty
+
+    double mean_depth() const { return pushes ? (double)depth_sum / (double)pushes : 0.0; }
+};
+
+template <class T>
+class SpscQueue {
+public:
+    // Capacity is rounded up to a power of two.
+    explicit SpscQueue(size_t capacity) {
+        size_t cap = 2;
+        while (cap < capacity) cap <<= 1;
+        slots_.resize(cap);
+        mask_ = cap - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // ── Producer ────────────────────────────────────────────
+
+    bool try_push(const T& v) {
+        const size_t t = tail_.load(std::memory_order_relaxed);
+        if (t - head_cache_ > mask_) {
+            head_cache_ = head_.load(std::memory_order_acquire);
+            if (t - head_cache_ > mask_) return false;
+        }
+        slots_[t & mask_] = v;
+        tail_.store(t + 1, std::memory_order_release);
+
+        const size_t depth = t - head_cache_;
+        ++pushes_;
+        depth_sum_ += depth;
+        if (depth > max_depth_) max_depth_ = depth;
+        return true;
+    }
+
+    // Waits while full.  False if `abort` is raised first.
+    bool push(const T& v, const std::atomic<bool>* abort = nullptr) {
+        if (try_push(v)) return true;
+        ++full_waits_;
+        while (!try_push(v)) {
+            if (abort && abort->load(std::memory_order_relaxed)) return false;
+            std::this_thread::yield();
+        }
+        return true;
+    }
+
+    // No more pushes: pop() returns false once the ring drains.
+    void close() { closed_.store(true, std::memory_order_release); }
+
+    // ── Consumer ────────────────────────────────────────────
+
+    bool try_pop(T& v) {
+        const size_t h = head_.load(std::memory_order_relaxed);
+        if (h == tail_cache_) {
+            tail_cache_ = tail_.load(std::memory_order_acquire);
+            if (h == tail_cache_) return false;
+        }
+        v = slots_[h & mask_];
+        head_.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Waits while empty.  False once the ring is closed and drained, or
+    // when `abort` is raised while waiting.
+    bool pop(T& v, const std::atomic<bool>* abort = nullptr) {
+        if (try_pop(v)) return true;
+        ++empty_waits_;
+        for (;;) {
+            const bool closed = closed_.load(std::memory_order_acquire);
+            if (try_pop(v)) return true;
+            if (closed) return false;
+            if (abort && abort->load(std::memory_order_relaxed)) return false;
+            std::this_thread::yield();
+        }
+    }
+
+    QueueStats stats() const {
+        QueueStats s;
+        s.pushes      = pushes_;
+        s.depth_sum   = depth_sum_;
+        s.max_depth   = max_depth_;
+        s.full_waits  = full_waits_;
+        s.empty_waits = empty_waits_;
+        return s;
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_ = 0;
+    std::atomic<bool> closed_{false};
+
+    // Producer side.
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t head_cache_ = 0;
+    size_t pushes_ = 0, depth_sum_ = 0, max_depth_ = 0, full_waits_ = 0;
+
+    // Consumer side.
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t tail_cache_ = 0;
+    size_t empty_waits_ = 0;
+};
+
+#endif
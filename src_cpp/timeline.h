@@ -0,0 +1,138 @@
+#ifndef TIMELINE_H
+#define TIMELINE_H
+
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// L1Timeline: a day's two-sided BBO updates, tick-encoded
+// ─────────────────────────────────────────────────────────────
+//
+// One entry per best-price change with both sides present: its time,
+// bid and ask.  The mid and spread are derived from the ticks on
+// demand, and a bit per entry marks the updates that moved the mid,
+// so the same timeline answers "mid at t", "BBO at t" and the peak
+// scans over mid changes.
+//
+// An entry takes 12 bytes: a uint32 ns offset from its page's base
+// (PAGE entries per page, base held as int64 ns) and the bid / ask in
+// ticks.  An offset that does not fit (a page spanning > 4.29 s) goes
+// to a side table instead.  Times are kept as ns past midnight and
+// read back as ns / 1e9, which reproduces LOBSTER's ≤ 9-decimal
+// timestamps bit-for-bit (see lobbin.h).  Entries must be pushed in
+// time order; clear() keeps the capacity for the next day.
+// ─────────────────────────────────────────────────────────────
+
+class L1Timeline {
+public:
+    static constexpr int PAGE_BITS = 6;
+    static constexpr size_t PAGE   = size_t(1) << PAGE_BITS;
+
+    void reserve(size_t n) {
+        offset_.reserve(n);
+        bid_.reserve(n);
+        ask_.reserve(n);
+        changed_.reserve(n / 64 + 1);
+        base_.reserve(n / PAGE + 1);
+    }
+
+    void clear() {
+        base_.clear();
+        offset_.clear();
+        bid_.clear();
+        ask_.clear();
+        changed_.clear();
+        wide_.clear();
+        last_mid_time_ = 0.0;
+    }
+
+    bool   empty() const { return offset_.empty(); }
+    size_t size()  const { return offset_.size(); }
+
+    // A BBO update (prices in ticks); mid_changed if it moved the mid.
+    void push(double time, int bid, int ask, bool mid_changed) {
+        const size_t k = offset_.size();
+        const int64_t ns = (int64_t)std::llround(time * 1e9);
+        if ((k & (PAGE - 1)) == 0) base_.push_back(ns);
+        const int64_t off = ns - base_.back();
+        if (off >= 0 && off < (int64_t)WIDE) {
+            offset_.push_back((uint32_t)off);
+        } else {
+            offset_.push_back(WIDE);
+            wide_.push_back({k, ns});
+        }
+        bid_.push_back(bid);
+        ask_.push_back(ask);
+        if ((k & 63) == 0) changed_.push_back(0);
+        if (mid_changed) {
+            changed_.back() |= uint64_t(1) << (k & 63);
+            last_mid_time_ = time;
+        }
+    }
+
+    // Seed for a replay resumed from a book checkpoint: the BBO it
+    // recorded (in $) and when the mid last moved before it.
+    void seed(double bbo_time, double bid, double ask, double mid_time) {
+        push(bbo_time, (int)std::llround(bid * 10000.0), (int)std::llround(ask * 10000.0), true);
+        last_mid_time_ = mid_time;
+    }
+
+    double time(size_t k) const {
+        const uint32_t off = offset_[k];
+        if (off != WIDE) return (double)(base_[k >> PAGE_BITS] + off) / 1e9;
+        auto it = std::lower_bound(wide_.begin(), wide_.end(), k,
+            [](const std::pair<size_t, int64_t>& w, size_t i) { return w.first < i; });
+        return (double)it->second / 1e9;
+    }
+    double bid(size_t k)    const { return (double)bid_[k] / 10000.0; }
+    double ask(size_t k)    const { return (double)ask_[k] / 10000.0; }
+    double mid(size_t k)    const { return ((double)bid_[k] + (double)ask_[k]) / 2.0 / 10000.0; }
+    double spread(size_t k) const { return (double)(ask_[k] - bid_[k]) / 10000.0; }
+    bool   mid_changed(size_t k) const { return (changed_[k >> 6] >> (k & 63)) & 1; }
+
+    // When the mid last moved (0 = never).
+    double last_mid_time() const { return last_mid_time_; }
+
+    // First entry in [lo, hi) timed after t (hi if none).
+    size_t upper_bound(double t, size_t lo, size_t hi) const {
+        while (lo < hi) {
+            const size_t m = lo + (hi - lo) / 2;
+            if (t < time(m)) hi = m; else lo = m + 1;
+        }
+        return lo;
+    }
+
+    // First entry in [lo, size()) timed at or after t.
+    size_t lower_bound(double t, size_t lo) const {
+        size_t hi = size();
+        while (lo < hi) {
+            const size_t m = lo + (hi - lo) / 2;
+            if (time(m) < t) lo = m + 1; else hi = m;
+        }
+        return lo;
+    }
+
+    // Mid changes timed in [from, to).
+    size_t mid_changes(double from, double to) const {
+        size_t n = 0;
+        for (size_t k = lower_bound(from, 0); k < size() && time(k) < to; ++k) n += mid_changed(k);
+        return n;
+    }
+
+private:
+    static constexpr uint32_t WIDE = 0xFFFFFFFFu;   // offset held in wide_
+
+    std::vector<int64_t>  base_;      // ns of each page's first entry
+    std::vector<uint32_t> offset_;    // ns after the page base, or WIDE
+    std::vector<int32_t>  bid_;       // ticks
+    std::vector<int32_t>  ask_;
+    std::vector<uint64_t> changed_;   // mid-changed bits
+    std::vector<std::pair<size_t, int64_t>> wide_;   // (entry, ns), ascending
+    double last_mid_time_ = 0.0;
+};
+
+#endif
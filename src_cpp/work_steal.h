@@ -0,0 +1,76 @@
+#ifndef WORK_STEAL_H
+#define WORK_STEAL_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include <cstddef>
+
+// ─────────────────────────────────────────────────────────────
+// StealQueues: per-worker task deques with work stealing
+// ─────────────────────────────────────────────────────────────
+//
+// Tasks are dealt to workers up front (push); worker w then takes
+// from the front of its own deque and, once that is empty, steals
+// from the back of the others', starting with its right-hand
+// neighbour.  Dealing a largest-first list round-robin gives every
+// worker a share of the big tasks early and leaves the small ones
+// at the back, where stealing evens out the finish.
+//
+// One mutex per deque: a worker only ever contends with a thief,
+// and a task here is a whole replayed day, so the lock costs
+// nothing next to it.
+// ─────────────────────────────────────────────────────────────
+
+template <class T>
+class StealQueues {
+public:
+    explicit StealQueues(size_t workers) : lanes_(workers ? workers : 1) {}
+
+    size_t workers() const { return lanes_.size(); }
+
+    void push(size_t w, const T& task) {
+        Lane& l = lanes_[w % lanes_.size()];
+        std::lock_guard<std::mutex> lk(l.mutex);
+        l.tasks.push_back(task);
+    }
+
+    // Next task for worker w: its own front, else another's back.
+    // False once every deque is empty.
+    bool pop(size_t w, T& task) {
+        const size_t n = lanes_.size();
+        {
+            Lane& l = lanes_[w % n];
+            std::lock_guard<std::mutex> lk(l.mutex);
+            if (!l.tasks.empty()) {
+                task = l.tasks.front();
+                l.tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < n; ++k) {
+            Lane& l = lanes_[(w + k) % n];
+            std::lock_guard<std::mutex> lk(l.mutex);
+            if (!l.tasks.empty()) {
+                task = l.tasks.back();
+                l.tasks.pop_back();
+                steals_.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t steals() const { return steals_.load(std::memory_order_relaxed); }
+
+private:
+    struct Lane {
+        std::mutex mutex;
+        std::deque<T> tasks;
+    };
+    std::vector<Lane> lanes_;
+    std::atomic<size_t> steals_{0};
+};
+
+#endif
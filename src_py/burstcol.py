@@ -0,0 +1,138 @@
+#!/usr/bin/env python3
+"""
+burstcol.py
+
+Reader for the columnar burst files written by `data_processor --format bcol`
+(layout in src_cpp/burst_table.h).  The file is memory-mapped and every
+numeric column of a day block is a numpy view into the mapping: nothing is
+parsed.  The columns are the CSV header's, in the same order; values are the
+full doubles the CSV rounds.
+
+    from burstcol import read_bursts, iter_days
+    df = read_bursts("bursts_NVDA_baseline.bcol")              # DataFrame
+    df = read_bursts(path, columns=["Date", "D_b", "Mid_10m"])
+    for ticker, date, cols in iter_days(path):                 # zero-copy
+        cols["D_b"].mean()
+
+read_bursts() also accepts a CSV path (pd.read_csv), so a script can take
+either output.
+
+Usage:
+    python3 src_py/burstcol.py bursts_NVDA_baseline.bcol [--csv out.csv]
+"""
+
+import argparse
+import sys
+
+import numpy as np
+
+MAGIC = b"BURSTC1\0"
+VERSION = 1
+NAME_SIZE = 56
+TEXT, INT64, FLOAT64 = 0, 1, 2
+
+_FILE_HEADER = np.dtype([("magic", "S8"), ("version", "<u4"), ("columns", "<u4")])
+_COLUMN_DESC = np.dtype([("name", f"S{NAME_SIZE}"), ("type", "<u4"), ("reserved", "<u4")])
+_BLOCK_HEADER = np.dtype([("rows", "<u8"), ("text_bytes", "<u8")])
+_NUMPY = {INT64: np.dtype("<i8"), FLOAT64: np.dtype("<f8")}
+
+
+def is_bcol(path):
+    with open(path, "rb") as f:
+        return f.read(8) == MAGIC
+
+
+def read_schema(buf):
+    """[(name, type)] from the file header of a mapped .bcol file."""
+    fh = np.frombuffer(buf, _FILE_HEADER, count=1)[0]
+    if fh["magic"] != MAGIC.rstrip(b"\0") or fh["version"] != VERSION:
+        raise ValueError("not a .bcol file (version %d)" % VERSION)
+    descs = np.frombuffer(buf, _COLUMN_DESC, count=int(fh["columns"]),
+                          offset=_FILE_HEADER.itemsize)
+    return [(d["name"].decode(), int(d["type"])) for d in descs]
+
+
+def iter_days(path):
+    """Yield (ticker, date, {column: array}) per day block.
+
+    Numeric arrays are read-only views into the mapped file; the Ticker and
+    Date columns are the block's values (also given as ticker / date).
+    """
+    buf = np.memmap(path, dtype=np.uint8, mode="r")
+    schema = read_schema(buf)
+    pos = _FILE_HEADER.itemsize + len(schema) * _COLUMN_DESC.itemsize
+    while pos < len(buf):
+        if pos + _BLOCK_HEADER.itemsize > len(buf):
+            raise ValueError("%s: truncated block header at %d" % (path, pos))
+        bh = np.frombuffer(buf, _BLOCK_HEADER, count=1, offset=pos)[0]
+        rows, text_bytes = int(bh["rows"]), int(bh["text_bytes"])
+        pos += _BLOCK_HEADER.itemsize
+        texts = bytes(buf[pos:pos + text_bytes]).split(b"\0")
+        pos += text_bytes
+
+        cols, k = {}, 0
+        for name, kind in schema:
+            if kind == TEXT:
+                cols[name] = texts[k].decode()
+                k += 1
+            else:
+                if pos + rows * 8 > len(buf):
+                    raise ValueError("%s: truncated column %s at %d" % (path, name, pos))
+                cols[name] = np.frombuffer(buf, _NUMPY[kind], count=rows, offset=pos)
+                pos += rows * 8
+        yield cols.get("Ticker", ""), cols.get("Date", ""), cols
+
+
+def read_columns(path, columns=None):
+    """{column: array} over the whole file (numeric columns concatenated)."""
+    buf = np.memmap(path, dtype=np.uint8, mode="r")
+    schema = read_schema(buf)
+    del buf
+    names = [n for n, _ in schema] if columns is None else list(columns)
+    kinds = dict(schema)
+    missing = [n for n in names if n not in kinds]
+    if missing:
+        raise KeyError("no such column(s): %s" % ", ".join(missing))
+
+    parts = {n: [] for n in names}
+    for _, _, cols in iter_days(path):
+        rows = len(next((v for v in cols.values() if not isinstance(v, str)), ()))
+        for n in names:
+            v = cols[n]
+            parts[n].append(np.full(rows, v, dtype=object) if kinds[n] == TEXT else v)
+
+    out = {}
+    for n in names:
+        if parts[n]:
+            out[n] = np.concatenate(parts[n])
+        else:
+            out[n] = np.empty(0, dtype=object if kinds[n] == TEXT else _NUMPY[kinds[n]])
+    return out
+
+
+def read_bursts(path, columns=None):
+    """DataFrame of a .bcol file (or of a CSV: pd.read_csv)."""
+    import pandas as pd
+    if not is_bcol(path):
+        return pd.read_csv(path, usecols=columns)
+    return pd.DataFrame(read_columns(path, columns))
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Inspect / convert a .bcol burst file")
+    ap.add_argument("path")
+    ap.add_argument("--csv", help="write the rows as CSV here")
+    args = ap.parse_args()
+
+    df = read_bursts(args.path)
+    print(f"{args.path}: {len(df)} rows, {len(df.columns)} columns, "
+          f"{df['Date'].nunique() if 'Date' in df else 0} days")
+    if args.csv:
+        df.to_csv(args.csv, index=False)
+    else:
+        print(df.head().to_string())
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())